@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#include <circuitous/IR/Circuit.hpp>
+#include <circuitous/IR/Serialize.hpp>
+#include <circuitous/Transforms/CircuitBuilder.hpp>
+#include <circuitous/Transforms/EGraph.hpp>
+#include <circuitous/Transforms/EGraphBuilder.hpp>
+#include <circuitous/Transforms/EqSatCost.hpp>
+#include <circuitous/Support/Check.hpp>
+#include <circuitous/Util/Warnings.hpp>
+
+#include <eqsat/algo/saturation.hpp>
+#include <eqsat/pattern/parser.hpp>
+
+CIRCUITOUS_RELAX_WARNINGS
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+CIRCUITOUS_UNRELAX_WARNINGS
+
+#include <spdlog/cfg/env.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+DEFINE_string(patterns, "", "Comma separated rule files (e.g., data/eqsat/arithmetic.eq), "
+                            "builtin arithmetic rules are used if empty.");
+DEFINE_string(ir_in, "", "Comma separated files with serialized lifted circuits.");
+DEFINE_string(synthetic, "8,16,32", "Comma separated sizes of synthetic expressions.");
+
+DEFINE_uint64(iterations, 10, "Iteration limit of each saturation.");
+DEFINE_uint64(nodes, 100'000, "Node limit of each saturation.");
+DEFINE_uint64(time, 60, "Time limit of each saturation in seconds.");
+DEFINE_uint64(workers, 0, "Number of threads matching rules, 0 for the number of cores.");
+DEFINE_bool(no_backoff, false, "Disable the backoff scheduler.");
+DEFINE_bool(extract, true, "Extract a circuit after each iteration and report its time.");
+
+DEFINE_string(csv, "", "File to store the report as CSV, printed to stdout if no report is set.");
+DEFINE_string(json, "", "File to store the report as JSON.");
+
+// Saturates circuits with the given rules and reports statistics of each iteration and
+// rule, used to catch rule sets that blow up the egraph and to measure optimizations
+// of equality saturation.
+
+namespace
+{
+    using namespace circ;
+
+    using saturable_circuit_egraph = eqsat::saturable_egraph< circuit_egraph >;
+
+    struct workload {
+        std::string name;
+        circuit_egraph graph;
+        enode_handle root;
+        std::uint32_t ptr_size;
+    };
+
+    struct report {
+        std::string name;
+        eqsat::saturation_stats stats;
+    };
+
+    std::vector< std::string > split(const std::string &list) {
+        std::vector< std::string > out;
+        std::stringstream ss(list);
+        for (std::string item; std::getline(ss, item, ',');) {
+            if (!item.empty())
+                out.push_back(item);
+        }
+        return out;
+    }
+
+    std::vector< eqsat::rule_set > arithmetic_rules() {
+        std::stringstream rules;
+        rules << "[arithmetic]\n"
+              << "add-commutativity:\n"
+              << "    - (op_Add ?x ?y)\n"
+              << "    - (op_Add:64 ?y ?x)\n"
+              << "mul-commutativity:\n"
+              << "    - (op_Mul ?x ?y)\n"
+              << "    - (op_Mul:64 ?y ?x)\n"
+              << "add-associativity:\n"
+              << "    - (op_Add ?x (op_Add ?y ?z))\n"
+              << "    - (op_Add:64 (op_Add:64 ?x ?y) ?z)\n"
+              << "mul-distributivity:\n"
+              << "    - (op_Mul ?x (op_Add ?y ?z))\n"
+              << "    - (op_Add:64 (op_Mul:64 ?x ?y) (op_Mul:64 ?x ?z))\n";
+        return eqsat::parse_rules(rules);
+    }
+
+    std::vector< eqsat::rule_set > load_rules() {
+        if (FLAGS_patterns.empty())
+            return arithmetic_rules();
+
+        std::vector< eqsat::rule_set > rules;
+        for (const auto &file : split(FLAGS_patterns)) {
+            auto sets = eqsat::parse_rules(file);
+            std::move(sets.begin(), sets.end(), std::back_inserter(rules));
+        }
+        return rules;
+    }
+
+    // x0 * (x1 + (x2 + ... (xn-1 + xn))) over 64-bit registers
+    workload synthetic_workload(std::size_t size) {
+        circuit_egraph graph;
+        auto reg = [&] (std::size_t idx) {
+            auto node = circuit_egraph_builder_base::regop("in.register", 64, "x" + std::to_string(idx));
+            return graph.insert(node_template(node), {});
+        };
+
+        auto op = [&] (const std::string &name, std::vector< enode_handle > children) {
+            auto node = circuit_egraph_builder_base::sized(name, 64);
+            return graph.insert(node_template(node), children);
+        };
+
+        auto sum = reg(size);
+        for (auto idx = size - 1; idx > 0; --idx)
+            sum = op("Add", { reg(idx), sum });
+        auto root = op("Mul", { reg(0), sum });
+
+        return { "synthetic-" + std::to_string(size), std::move(graph), root, 64 };
+    }
+
+    workload circuit_workload(const std::string &file) {
+        auto circuit = deserialize(file);
+        check(circuit != nullptr) << "Cannot load circuit from" << file;
+
+        auto [graph, nodes] = circuit_egraph_builder().build(circuit.get());
+        auto root = nodes.at(circuit->root);
+        return { file, std::move(graph), root, circuit->ptr_size };
+    }
+
+    eqsat::saturation_config make_config() {
+        eqsat::saturation_config config;
+        config.iteration_limit = FLAGS_iterations;
+        config.node_limit      = FLAGS_nodes;
+        config.time_limit      = std::chrono::seconds(FLAGS_time);
+        config.backoff         = !FLAGS_no_backoff;
+        config.profile         = true;
+        if (FLAGS_workers)
+            config.workers = FLAGS_workers;
+        return config;
+    }
+
+    // Extraction consumes the egraph, the saturated one is copied through a snapshot
+    // first; only the extraction itself is measured.
+    double extraction_ms(const saturable_circuit_egraph &graph, const workload &work) {
+        std::stringstream buffer;
+        eqsat::save_snapshot(buffer, graph, 0, {});
+        auto copy = eqsat::load_snapshot< circuit_egraph >(buffer);
+
+        auto start = std::chrono::steady_clock::now();
+        auto optimal = make_optimal_circuit_graph(std::move(copy.graph));
+        extract_circuit_from_egraph(optimal).extract(work.root, work.ptr_size);
+        return eqsat::elapsed_ms(start);
+    }
+
+    report run(workload &&work, std::span< eqsat::rule_set > rules) {
+        std::cerr << work.name << ": " << work.graph.num_of_nodes() << " nodes, "
+                  << work.graph.num_of_eclasses() << " classes" << std::endl;
+
+        report out{ work.name, {} };
+        auto observer = [&] (const saturable_circuit_egraph &graph, eqsat::iteration_stats &it) {
+            if (FLAGS_extract)
+                it.extract_ms = extraction_ms(graph, work);
+            std::cerr << "  " << eqsat::to_string(it) << ", extract "
+                      << it.extract_ms << " ms" << std::endl;
+        };
+
+        eqsat::saturation_snapshot< circuit_egraph > start{
+            saturable_circuit_egraph(std::move(work.graph))
+        };
+        eqsat::saturate(std::move(start), rules, make_config(), out.stats, observer);
+
+        std::cerr << "  stopped on " << eqsat::to_string(out.stats.reason) << " after "
+                  << out.stats.total_ms << " ms" << std::endl;
+        return out;
+    }
+
+    void write_csv(std::ostream &os, const std::vector< report > &reports) {
+        os << eqsat::csv_header();
+        for (const auto &r : reports)
+            eqsat::write_csv(os, r.name, r.stats);
+    }
+
+    void write_json(std::ostream &os, const std::vector< report > &reports) {
+        os << "[";
+        for (std::size_t i = 0; i < reports.size(); ++i) {
+            os << (i ? ",\n" : "\n");
+            eqsat::write_json(os, reports[i].name, reports[i].stats);
+        }
+        os << "\n]\n";
+    }
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    spdlog::cfg::load_env_levels();
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    auto rules = load_rules();
+
+    std::vector< report > reports;
+    for (const auto &size : split(FLAGS_synthetic))
+        reports.push_back(run(synthetic_workload(std::stoul(size)), rules));
+    for (const auto &file : split(FLAGS_ir_in))
+        reports.push_back(run(circuit_workload(file), rules));
+
+    if (!FLAGS_csv.empty()) {
+        std::ofstream os(FLAGS_csv);
+        write_csv(os, reports);
+    }
+
+    if (!FLAGS_json.empty()) {
+        std::ofstream os(FLAGS_json);
+        write_json(os, reports);
+    }
+
+    if (FLAGS_csv.empty() && FLAGS_json.empty())
+        write_csv(std::cout, reports);
+
+    return 0;
+}
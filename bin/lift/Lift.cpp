@@ -19,6 +19,8 @@
 #include <circuitous/Support/Check.hpp>
 
 #include <circuitous/Lifter/CircuitSmithy.hpp>
+#include <circuitous/Lifter/Extend.hpp>
+#include <circuitous/Lifter/SemanticsCache.hpp>
 
 #include <eqsat/pattern/parser.hpp>
 
@@ -32,8 +34,10 @@ CIRCUITOUS_UNRELAX_WARNINGS
 
 #include <remill/OS/OS.h>
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <unordered_map>
 
 #include <circuitous/Lifter/BaseLifter.hpp>
@@ -61,11 +65,31 @@ DEFINE_string(ciff_in, "", "Load input from circuitous-seed --dbg produced file"
 
 DEFINE_string(patterns, "", "Equality saturation patterns.");
 DEFINE_bool(eqsat, false, "Enable equality saturation based optimizations.");
+DEFINE_uint64(eqsat_iterations, 0, "Iteration limit of equality saturation.");
+DEFINE_uint64(eqsat_nodes, 0, "Node limit of equality saturation.");
+DEFINE_uint64(eqsat_memory, 0, "Memory limit of equality saturation in MiB.");
+DEFINE_uint64(eqsat_time, 0, "Time limit of equality saturation in seconds.");
+DEFINE_uint64(eqsat_match_limit, 0, "Match limit of the backoff scheduler.");
+DEFINE_uint64(eqsat_ban_length, 0, "Ban length of the backoff scheduler.");
+DEFINE_bool(eqsat_no_backoff, false, "Disable the backoff scheduler.");
+DEFINE_uint64(eqsat_workers, 0, "Number of threads matching equality saturation rules.");
+DEFINE_bool(eqsat_dag_extraction, false, "Account for shared subterms when extracting a circuit.");
+DEFINE_string(eqsat_checkpoint, "", "Path of the equality saturation snapshot.");
+DEFINE_uint64(eqsat_checkpoint_interval, 0, "Iterations between equality saturation snapshots.");
+DEFINE_string(eqsat_resume, "", "Snapshot of equality saturation to continue from.");
 DEFINE_bool(conjure_alu, false, "Enable conjure-alu optimization.");
 DEFINE_bool(no_advices, false, "Lower all advices. Cannot be used with conjure-alu.");
 DEFINE_bool(dbg, false, "Enable various debug dumps");
+DEFINE_bool(time_passes, false, "Report time spent in each llvm pass.");
 DEFINE_bool(quiet, false, "");
 DEFINE_string(lift_with, "", "");
+DEFINE_uint64(lift_workers, 1, "Number of threads lifting instructions.");
+DEFINE_bool(no_cache, false, "Do not use the on-disk cache of lifted semantics.");
+DEFINE_string(cache_dir, "", "Directory of the on-disk cache of lifted semantics.");
+DEFINE_string(reopt, "llvm", "How the optimized circuit is cleaned up.");
+DEFINE_string(extend, "", "Circuit to extend by the input encodings.");
+DEFINE_string(covered, "", "CIFF file with encodings the extended circuit was lifted from.");
+DEFINE_string(covered_out, "", "CIFF file to store encodings the circuit handles into.");
 
 namespace cli = circ::cli;
 
@@ -81,6 +105,120 @@ namespace circ::cli
         static inline const auto opt = circ::CmdOpt( "--no-advices", false );
     };
 
+    struct EqSatIterations : circ::DefaultCmdOpt, NumArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--eqsat-iterations", false );
+        static std::string help()
+        {
+            return "Iteration limit of equality saturation, 0 disables the limit.\n";
+        }
+    };
+
+    struct EqSatNodes : circ::DefaultCmdOpt, NumArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--eqsat-nodes", false );
+        static std::string help()
+        {
+            return "Limit of the number of egraph nodes, 0 disables the limit.\n";
+        }
+    };
+
+    struct EqSatMemory : circ::DefaultCmdOpt, NumArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--eqsat-memory", false );
+        static std::string help()
+        {
+            return "Limit of the (approximate) egraph size in MiB, 0 disables the limit.\n";
+        }
+    };
+
+    struct EqSatTime : circ::DefaultCmdOpt, NumArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--eqsat-time", false );
+        static std::string help()
+        {
+            return "Wall-clock limit of equality saturation in seconds, 0 disables the limit.\n";
+        }
+    };
+
+    struct EqSatMatchLimit : circ::DefaultCmdOpt, NumArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--eqsat-match-limit", false );
+        static std::string help()
+        {
+            std::stringstream ss;
+            ss << "Rules with more matches in one iteration are temporarily banned. "
+               << "The limit of a rule doubles with each of its bans.\n";
+            return ss.str();
+        }
+    };
+
+    struct EqSatBanLength : circ::DefaultCmdOpt, NumArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--eqsat-ban-length", false );
+        static std::string help()
+        {
+            return "Number of iterations a rule is banned for (doubles with each ban).\n";
+        }
+    };
+
+    struct EqSatNoBackoff : circ::DefaultCmdOpt, Arity< 0 >
+    {
+        static inline const auto opt = circ::CmdOpt( "--eqsat-no-backoff", false );
+        static std::string help()
+        {
+            return "Apply all matches of all rules in each iteration, never ban rules.\n";
+        }
+    };
+
+    struct EqSatWorkers : circ::DefaultCmdOpt, NumArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--eqsat-workers", false );
+        static std::string help()
+        {
+            return "Number of threads matching rules, defaults to the number of cores.\n";
+        }
+    };
+
+    struct EqSatDagExtraction : circ::DefaultCmdOpt, Arity< 0 >
+    {
+        static inline const auto opt = circ::CmdOpt( "--eqsat-dag-extraction", false );
+        static std::string help()
+        {
+            return "Improve the extracted circuit for its cost with shared subterms counted once.\n";
+        }
+    };
+
+    struct EqSatCheckpoint : circ::DefaultCmdOpt, PathArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--eqsat-checkpoint", false );
+        static std::string help()
+        {
+            std::stringstream ss;
+            ss << "Periodically write a snapshot of equality saturation to the file, "
+               << "saturation stopped on a limit can continue from it with --eqsat-resume.\n";
+            return ss.str();
+        }
+    };
+
+    struct EqSatCheckpointInterval : circ::DefaultCmdOpt, NumArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--eqsat-checkpoint-interval", false );
+        static std::string help()
+        {
+            return "Number of iterations between two snapshots of equality saturation.\n";
+        }
+    };
+
+    struct EqSatResume : circ::DefaultCmdOpt, PathArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--eqsat-resume", false );
+        static std::string help()
+        {
+            return "Continue equality saturation of the same circuit from the snapshot.\n";
+        }
+    };
+
     struct LiftWith : DefaultCmdOpt, HasAllowed< LiftWith >,
                       PathArg
     {
@@ -91,6 +229,104 @@ namespace circ::cli
             "mux-heavy", "disjunctions", "v3"
         };
     };
+
+    struct LiftWorkers : circ::DefaultCmdOpt, NumArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--lift-workers", false );
+        static std::string help()
+        {
+            std::stringstream ss;
+            ss << "Number of threads lifting instructions, each with its own copy of "
+               << "semantics. Not supported by v3.\n";
+            return ss.str();
+        }
+    };
+
+    struct TimePasses : circ::DefaultCmdOpt, Arity< 0 >
+    {
+        static inline const auto opt = circ::CmdOpt( "--time-passes", false );
+        static std::string help()
+        {
+            return "Print time spent in each llvm pass run on lifted functions.\n";
+        }
+    };
+
+    struct NoCache : circ::DefaultCmdOpt, Arity< 0 >
+    {
+        static inline const auto opt = circ::CmdOpt( "--no-cache", false );
+        static std::string help()
+        {
+            return "Always lift semantics, bypassing the on-disk cache.\n";
+        }
+    };
+
+    struct CacheDir : circ::DefaultCmdOpt, PathArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--cache-dir", false );
+        static std::string help()
+        {
+            std::stringstream ss;
+            ss << "Directory of the on-disk cache of lifted semantics, defaults to "
+               << "$XDG_CACHE_HOME/circuitous/isem.\n";
+            return ss.str();
+        }
+    };
+
+    struct Extend : circ::DefaultCmdOpt, PathArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--extend", false );
+        static std::string help()
+        {
+            std::stringstream ss;
+            ss << "Circuit (in circIR) to extend by the input encodings instead of lifting "
+               << "all of them. Only new encodings and isels they extend are lifted, their "
+               << "contexts are spliced into the circuit. Requires --covered.\n";
+            return ss.str();
+        }
+    };
+
+    struct Covered : circ::DefaultCmdOpt, PathArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--covered", false );
+        static std::string help()
+        {
+            return "CIFF file with encodings the --extend circuit was lifted from, see "
+                   "--covered-out.\n";
+        }
+    };
+
+    struct CoveredOut : circ::DefaultCmdOpt, PathArg
+    {
+        static inline const auto opt = circ::CmdOpt( "--covered-out", false );
+        static std::string help()
+        {
+            return "CIFF file to store encodings (and isels) the resulting circuit handles "
+                   "into, to be used with --covered later.\n";
+        }
+    };
+
+    struct Reopt : circ::DefaultCmdOpt, PathArg, HasAllowed< Reopt >
+    {
+        using HasAllowed< Reopt >::validate;
+
+        static inline const auto opt = circ::CmdOpt( "--reopt", false );
+        static inline const std::unordered_set< std::string > allowed =
+        {
+            "llvm", "native", "compare", "none"
+        };
+
+        static std::string help()
+        {
+            std::stringstream ss;
+            ss << "How the circuit is cleaned up after all other optimizations.\n"
+               << " * llvm - (default) round-trip through llvm and its optimizations.\n"
+               << " * native - simplify directly in circIR, uses less memory.\n"
+               << " * compare - run both, report their node counts and times and keep\n"
+               << "             the smaller circuit.\n"
+               << " * none - keep the circuit as it is.\n";
+            return ss.str();
+        }
+    };
 };
 
 using circuit_owner_t = circ::circuit_owner_t;
@@ -113,6 +349,32 @@ namespace
             auto pass = opt.template emplace_pass< circ::EqualitySaturationPass >( "eqsat" );
             if ( auto patterns = cli.template get< cli::Patterns >() )
                 pass->add_rules( eqsat::parse_rules( patterns.value() ) );
+
+            auto &config = pass->config;
+            if ( auto iterations = cli.template get< cli::EqSatIterations >() )
+                config.iteration_limit = *iterations;
+            if ( auto nodes = cli.template get< cli::EqSatNodes >() )
+                config.node_limit = *nodes;
+            if ( auto memory = cli.template get< cli::EqSatMemory >() )
+                config.memory_limit = *memory << 20;
+            if ( auto seconds = cli.template get< cli::EqSatTime >() )
+                config.time_limit = std::chrono::seconds( *seconds );
+            if ( auto matches = cli.template get< cli::EqSatMatchLimit >() )
+                config.match_limit = *matches;
+            if ( auto length = cli.template get< cli::EqSatBanLength >() )
+                config.ban_length = *length;
+            if ( cli.template present< cli::EqSatNoBackoff >() )
+                config.backoff = false;
+            if ( auto workers = cli.template get< cli::EqSatWorkers >(); workers && *workers )
+                config.workers = *workers;
+            if ( cli.template present< cli::EqSatDagExtraction >() )
+                pass->extraction.dag = true;
+            if ( auto path = cli.template get< cli::EqSatCheckpoint >() )
+                config.checkpoint = *path;
+            if ( auto interval = cli.template get< cli::EqSatCheckpointInterval >(); interval && *interval )
+                config.checkpoint_interval = *interval;
+            if ( auto path = cli.template get< cli::EqSatResume >() )
+                pass->resume = *path;
         }
 
         if ( cli.template present< cli::Simplify >() )
@@ -152,11 +414,88 @@ namespace
         return result;
     }
 
+    std::size_t nodes_count( const circuit_owner_t &circuit )
+    {
+        std::size_t out = 0;
+        circuit->for_each_operation( [ & ]( auto ) { ++out; } );
+        return out;
+    }
+
+    circuit_owner_t reopt_llvm( circ::Circuit *circuit, std::size_t ptr_size )
+    {
+        auto l_ctx = std::make_shared< llvm::LLVMContext >();
+        auto l_module = std::make_unique< llvm::Module >( "reopt", *l_ctx );
+
+        auto fn = circ::convert_to_llvm( circuit, l_module.get(), "reoptfn" );
+        circ::optimize_silently( { fn } );
+        return circ::lower_fn( fn, ptr_size );
+    }
+
+    circuit_owner_t reopt_native( circuit_owner_t &&circuit )
+    {
+        circ::DefaultOptimizer opt;
+        opt.emplace_pass< circ::NativeSimplify >( "native-simplify" );
+        return opt.run( std::move( circuit ) );
+    }
+
+    // Final clean-up of the circuit, see `cli::Reopt` for the available ways.
+    circuit_owner_t reoptimize( circuit_owner_t &&circuit, const std::string &how,
+                                std::size_t ptr_size )
+    {
+        if ( how == "none" )
+            return std::move( circuit );
+
+        using clock = std::chrono::steady_clock;
+        auto before = nodes_count( circuit );
+        auto report = [ & ]( const std::string &name, auto start,
+                             const circuit_owner_t &result )
+        {
+            auto took = std::chrono::duration_cast< std::chrono::milliseconds >(
+                    clock::now() - start );
+            auto after = nodes_count( result );
+            circ::log_info() << "[reopt]:" << name << ":" << before << "->" << after
+                             << "nodes in" << took.count() << "ms";
+            return after;
+        };
+
+        if ( how == "llvm" )
+        {
+            auto start = clock::now();
+            auto result = reopt_llvm( circuit.get(), ptr_size );
+            report( how, start, result );
+            return result;
+        }
+
+        if ( how == "native" )
+        {
+            auto start = clock::now();
+            auto result = reopt_native( std::move( circuit ) );
+            report( how, start, result );
+            return result;
+        }
+
+        // Conversion to llvm leaves the circuit untouched, so it goes first.
+        auto start = clock::now();
+        auto via_llvm = reopt_llvm( circuit.get(), ptr_size );
+        auto llvm_nodes = report( "llvm", start, via_llvm );
+
+        start = clock::now();
+        auto native = reopt_native( std::move( circuit ) );
+        auto native_nodes = report( "native", start, native );
+
+        if ( llvm_nodes < native_nodes )
+            return via_llvm;
+        return native;
+    }
+
 }  // namespace
 
 
 using lifter_config = circ::tl::TL<
-    cli::LiftWith
+    cli::LiftWith,
+    cli::LiftWorkers,
+    cli::NoCache,
+    cli::CacheDir
 >;
 
 using input_options = circ::tl::TL<
@@ -164,6 +503,12 @@ using input_options = circ::tl::TL<
     cli::IRIn,
     cli::BytesIn
 >;
+using extension_options = circ::tl::TL<
+    cli::Extend,
+    cli::Covered,
+    cli::CoveredOut
+>;
+
 using deprecated_options = circ::tl::TL<
     circ::cli::LogToStderr,
     circ::cli::LogDir
@@ -189,6 +534,7 @@ using other_options = circ::tl::TL<
     circ::cli::Quiet,
     circ::cli::Dbg,
     circ::cli::BitBlastStats,
+    cli::TimePasses,
     circ::cli::Help,
     circ::cli::Version
 >;
@@ -198,7 +544,23 @@ using optimization_options = circ::tl::TL<
     circ::cli::ConjureALU,
     circ::cli::NoAdvices,
     circ::cli::EqSat,
-    circ::cli::Patterns
+    circ::cli::Patterns,
+    cli::Reopt
+>;
+
+using eqsat_options = circ::tl::TL<
+    cli::EqSatIterations,
+    cli::EqSatNodes,
+    cli::EqSatMemory,
+    cli::EqSatTime,
+    cli::EqSatMatchLimit,
+    cli::EqSatBanLength,
+    cli::EqSatNoBackoff,
+    cli::EqSatWorkers,
+    cli::EqSatDagExtraction,
+    cli::EqSatCheckpoint,
+    cli::EqSatCheckpointInterval,
+    cli::EqSatResume
 >;
 
 using cmd_opts_list = circ::tl::merge<
@@ -209,45 +571,92 @@ using cmd_opts_list = circ::tl::merge<
     other_options,
     dot_options,
     optimization_options,
-    lifter_config
+    eqsat_options,
+    lifter_config,
+    extension_options
 >;
 
-circ::circuit_owner_t get_input_circuit(auto &cli)
+circ::lifter_kind get_lifter_kind(auto &cli)
 {
-    auto make_circuit = [&](auto buf) {
-        circ::log_info() << "Going to make circuit";
-        circ::Ctx ctx{ *cli.template get< cli::OS >(), *cli.template get< cli::Arch >() };
+    auto lifter_id = *cli.template get< cli::LiftWith >();
+    if ( lifter_id == "mux-heavy" )
+        return circ::lifter_kind::mux_heavy;
+    if ( lifter_id == "disjunctions" )
+        return circ::lifter_kind::disjunctions;
+    if ( lifter_id == "v3" )
+        return circ::lifter_kind::v3;
+    circ::log_kill() << "Unexpected config of lifter:" << lifter_id;
+}
 
-        auto lifter_id = *cli.template get< cli::LiftWith >();
+auto decode_input(circ::CircuitSmithy &smithy, auto &cli) -> circ::CircuitSmithy::concretes_t
+{
+    if (auto bytes = cli.template get< cli::BytesIn >())
+        return smithy.purify(as_string_view(*bytes));
 
-        if ( lifter_id == "mux-heavy" )
-        {
-            auto k = circ::lifter_kind::mux_heavy;
-            return circ::CircuitSmithy(std::move(ctx)).make(k, buf);
-        }
-        else if ( lifter_id == "disjunctions" )
-        {
-            auto k = circ::lifter_kind::disjunctions;
-            return circ::CircuitSmithy(std::move(ctx)).make(k, buf);
-        }
-        else if ( lifter_id == "v3" )
-        {
-            auto k = circ::lifter_kind::v3;
-            return circ::CircuitSmithy(std::move(ctx)).make(k, buf);
-        }
-        else
-            circ::log_kill() << "Unexpected config of lifter:" << lifter_id;
-    };
+    if (auto cif = cli.template get< cli::CiffIn >())
+        return smithy.purify(circ::CIFFReader().read(*cif).take_bytes());
+    return {};
+}
 
-    if (auto bytes = cli.template get< cli::BytesIn >())
-        return make_circuit(as_string_view(*bytes));
+// Circuit being extended (`--extend`) and what is lifted into it.
+struct extension_t
+{
+    circ::circuit_owner_t base;
+    circ::extension_plan plan;
+};
 
+// With `--extend` the returned circuit contains only the lifted contexts (or is empty if
+// there is nothing to lift) and is yet to be spliced into `extension->base`.
+circ::circuit_owner_t get_input_circuit(auto &cli, std::optional< extension_t > &extension)
+{
     if (auto ir_file = cli.template get< cli::IRIn >())
         return circ::deserialize(*ir_file);
 
-    if (auto cif = cli.template get< cli::CiffIn >())
-        return make_circuit(circ::CIFFReader().read(*cif).take_bytes());
-    return {};
+    circ::log_info() << "Going to make circuit";
+    circ::Ctx ctx{ *cli.template get< cli::OS >(), *cli.template get< cli::Arch >() };
+
+    auto lifter_id = *cli.template get< cli::LiftWith >();
+    auto workers = cli.template get< cli::LiftWorkers >().value_or( 1 );
+
+    std::shared_ptr< circ::isem::semantics_cache > cache;
+    if ( !cli.template present< cli::NoCache >() )
+    {
+        auto dir = cli.template get< cli::CacheDir >()
+            .value_or( circ::isem::semantics_cache::default_dir().string() );
+        cache = std::make_shared< circ::isem::semantics_cache >( dir, lifter_id );
+    }
+
+    auto kind = get_lifter_kind(cli);
+    auto smithy = circ::CircuitSmithy(std::move(ctx));
+    smithy.parallel(workers).cache_semantics(cache);
+
+    auto concretes = decode_input(smithy, cli);
+
+    if (auto base_file = cli.template get< cli::Extend >())
+    {
+        auto base = circ::deserialize(*base_file);
+        circ::check(base != nullptr) << "Cannot load circuit to extend from" << *base_file;
+        VerifyCircuit("Verifying circuit to extend.", base.get(), "Circuit is valid.");
+
+        auto covered = circ::CIFFReader().read(*cli.template get< cli::Covered >()).take();
+        auto plan = circ::plan_extension(smithy, base.get(), covered, std::move(concretes));
+
+        circ::circuit_owner_t delta;
+        if (plan.needs_lift())
+            delta = smithy.make(kind, std::move(plan.to_lift));
+
+        extension = extension_t{ std::move(base), std::move(plan) };
+        return delta;
+    }
+
+    if (auto covered_out = cli.template get< cli::CoveredOut >())
+    {
+        auto writer = circ::CIFFWriter(*covered_out);
+        for (const auto &inst : concretes)
+            writer << inst;
+    }
+
+    return smithy.make(kind, std::move(concretes));
 }
 
 void store_outputs(const auto &cli, const circ::circuit_owner_t &circuit)
@@ -308,8 +717,33 @@ auto parse_and_validate_cli(int argc, char *argv[]) -> std::optional< circ::Pars
         return {};
     }
 
-    if (v.check(implies< circ::cli::Patterns, circ::cli::EqSat >()).process_errors(yield_err))
+    if (v.check(implies< circ::cli::Patterns, circ::cli::EqSat >())
+         .check(implies< cli::EqSatIterations, circ::cli::EqSat >())
+         .check(implies< cli::EqSatNodes, circ::cli::EqSat >())
+         .check(implies< cli::EqSatMemory, circ::cli::EqSat >())
+         .check(implies< cli::EqSatTime, circ::cli::EqSat >())
+         .check(implies< cli::EqSatMatchLimit, circ::cli::EqSat >())
+         .check(implies< cli::EqSatBanLength, circ::cli::EqSat >())
+         .check(implies< cli::EqSatNoBackoff, circ::cli::EqSat >())
+         .check(implies< cli::EqSatWorkers, circ::cli::EqSat >())
+         .check(implies< cli::EqSatDagExtraction, circ::cli::EqSat >())
+         .check(implies< cli::EqSatCheckpoint, circ::cli::EqSat >())
+         .check(implies< cli::EqSatCheckpointInterval, cli::EqSatCheckpoint >())
+         .check(implies< cli::EqSatResume, circ::cli::EqSat >())
+         .check(are_exclusive< cli::NoCache, cli::CacheDir >())
+         .process_errors(yield_err))
+    {
+        return {};
+    }
+
+    if (v.check(implies< cli::Extend, cli::Covered >())
+         .check(implies< cli::Covered, cli::Extend >())
+         .check(are_exclusive< cli::Extend, cli::IRIn >())
+         .check(are_exclusive< cli::CoveredOut, cli::IRIn >())
+         .process_errors(yield_err))
+    {
         return {};
+    }
 
     if (v.validate_leaves( OptsList{} ).process_errors(yield_err))
         return {};
@@ -370,31 +804,52 @@ int main(int argc, char *argv[]) {
     google::ParseCommandLineFlags(&argc, &argv, true);
     google::InitGoogleLogging(argv[0]);
 
-    auto circuit = get_input_circuit(parsed_cli);
-    if (!circuit)
+    if (parsed_cli.present< cli::TimePasses >())
+        circ::enable_pass_timing();
+
+    std::optional< extension_t > extension;
+    auto circuit = get_input_circuit(parsed_cli, extension);
+    if (!circuit && !extension)
     {
         std::cerr << "Not able to load circuit.\n";
         return 3;
     }
 
-    VerifyCircuit("Verifying loaded circuit.", circuit.get(), "Circuit is valid.");
+    // When extending, only the lifted part is optimized - the extended circuit already
+    // was when it was lifted.
+    if (circuit)
+    {
+        VerifyCircuit("Verifying loaded circuit.", circuit.get(), "Circuit is valid.");
 
-    if (parsed_cli.present< cli::Dbg >())
-        circuit = optimize< circ::DebugOptimizer >(std::move(circuit), parsed_cli);
-    else
-        circuit = optimize< circ::DefaultOptimizer >(std::move(circuit), parsed_cli);
+        if (parsed_cli.present< cli::Dbg >())
+            circuit = optimize< circ::DebugOptimizer >(std::move(circuit), parsed_cli);
+        else
+            circuit = optimize< circ::DefaultOptimizer >(std::move(circuit), parsed_cli);
 
-    auto l_ctx = std::make_shared< llvm::LLVMContext >();
-    auto l_module = std::make_unique< llvm::Module >( "reopt", *l_ctx );
+        auto ptr_size = [ & ]() -> std::size_t
+        {
+            auto a = parsed_cli.template get< circ::cli::Arch >();
+            return ( a == "x86" ) ? 32 : 64;
+        }();
+        auto reopt = parsed_cli.template get< cli::Reopt >().value_or( "llvm" );
+        circuit = reoptimize( std::move( circuit ), reopt, ptr_size );
+    }
 
-    auto fn = circ::convert_to_llvm( circuit.get(), l_module.get(), "reoptfn" );
-    circ::optimize_silently( { fn } );
-    auto ptr_size = [ & ]() -> std::size_t
+    if (extension)
     {
-        auto a = parsed_cli.template get< circ::cli::Arch >();
-        return ( a == "x86" ) ? 32 : 64;
-    }();
-    circuit = circ::lower_fn( fn, ptr_size );
+        circuit = circ::splice(std::move(extension->base), extension->plan, std::move(circuit));
+        VerifyCircuit("Verifying extended circuit.", circuit.get(), "Circuit is valid.");
+
+        if (auto covered_out = parsed_cli.template get< cli::CoveredOut >())
+        {
+            auto writer = circ::CIFFWriter(*covered_out);
+            for (const auto &entry : extension->plan.coverage)
+                writer << entry;
+        }
+    }
+
+    if (parsed_cli.present< cli::TimePasses >())
+        std::cerr << circ::pass_timing_report();
 
     if (parsed_cli.present< cli::Dbg >())
     {
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#include <circuitous/Support/Log.hpp>
+#include <circuitous/Support/Check.hpp>
+
+#include <circuitous/Support/CLIArgs.hpp>
+
+#include <circuitous/IR/Link.hpp>
+#include <circuitous/IR/Serialize.hpp>
+#include <circuitous/IR/Verify.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Links circuits lifted from disjoint shards of instructions (for example by several
+// `circuitous-lift` processes) into one:
+//   circuitous-link --shards a.circir b.circir ... --ir-out all.circir
+
+namespace circ::cli::link
+{
+    struct Shards : DefaultCmdOpt, Arity< -1 >
+    {
+        static inline const auto opt = CmdOpt( "--shards", false );
+
+        static std::optional< std::vector< std::string > >
+        cast( std::vector< std::string > tokens )
+        {
+            if ( tokens.empty() )
+                return {};
+            return tokens;
+        }
+
+        static std::string help()
+        {
+            return "Serialized circuits (in circIR) to link, each shard is loaded only "
+                   "while it is being linked.\n";
+        }
+    };
+
+} // namespace circ::cli::link
+
+namespace
+{
+    using cmd_opts_list = circ::tl::TL<
+        circ::cli::link::Shards,
+        circ::cli::IROut,
+        circ::cli::Quiet,
+        circ::cli::Dbg,
+        circ::cli::Help
+    >;
+
+    std::optional< circ::ParsedCmd > parse_and_validate( int argc, char *argv[] )
+    {
+        using namespace circ;
+        static const auto yield_err = [ & ]( const auto &msg )
+        {
+            std::cerr << msg << std::endl;
+        };
+
+        auto parsed = CmdParser< cmd_opts_list >::parse_argv( argc, argv );
+        if ( !parsed )
+        {
+            std::cerr << "Command line arguments were not parsed correctly, see "
+                      << "stderr for more details.";
+            return {};
+        }
+
+        auto v = Validator( parsed );
+        if ( v.check( is_singleton< cli::Help >() ).process_errors( yield_err ) )
+            return {};
+
+        if ( parsed.present< cli::Help >() )
+            return parsed;
+
+        if ( v.check( is_present< cli::link::Shards >() )
+              .check( is_present< cli::IROut >() )
+              .process_errors( yield_err ) )
+        {
+            return {};
+        }
+
+        if ( v.validate_leaves( cmd_opts_list() ).process_errors( yield_err ) )
+            return {};
+
+        return parsed;
+    }
+
+    std::size_t nodes_count( circ::Circuit *circuit )
+    {
+        std::size_t out = 0;
+        circuit->for_each_operation( [ & ]( auto ) { ++out; } );
+        return out;
+    }
+
+} // namespace
+
+int main( int argc, char *argv[] )
+{
+    auto maybe_cli = parse_and_validate( argc, argv );
+    if ( !maybe_cli )
+    {
+        std::cerr << circ::help_str( cmd_opts_list() );
+        return 1;
+    }
+
+    auto cli = std::move( *maybe_cli );
+    if ( cli.present< circ::cli::Help >() )
+    {
+        std::cerr << circ::help_str( cmd_opts_list() );
+        return 0;
+    }
+
+    if ( !cli.present< circ::cli::Quiet >() )
+    {
+        circ::add_sink< circ::severity::kill >( std::cerr );
+        circ::add_sink< circ::severity::error >( std::cerr );
+        circ::add_sink< circ::severity::warn >( std::cerr );
+        circ::add_sink< circ::severity::info >( std::cout );
+    }
+
+    if ( cli.present< circ::cli::Dbg >() )
+        circ::add_sink< circ::severity::dbg >( std::cout );
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::optional< circ::CircuitLinker > linker;
+    for ( const auto &path : *cli.get< circ::cli::link::Shards >() )
+    {
+        auto shard = circ::deserialize( path );
+        circ::check( shard != nullptr ) << "Cannot load circuit from" << path;
+
+        if ( !linker )
+            linker.emplace( shard->ptr_size );
+
+        circ::log_info() << "[link]:" << path << "with" << nodes_count( shard.get() ) << "nodes";
+        linker->add( shard.get() );
+    }
+
+    auto stats = linker->stats();
+    auto circuit = linker->take();
+    circ::VerifyCircuit( "Verifying linked circuit.", circuit.get(), "Linked circuit is valid." );
+
+    auto elapsed = std::chrono::duration_cast< std::chrono::milliseconds >(
+            std::chrono::steady_clock::now() - start );
+    circ::log_info() << "[link]:" << stats.shards << "shards," << stats.contexts << "contexts,"
+                     << nodes_count( circuit.get() ) << "nodes (" << stats.reused
+                     << "reused) in" << elapsed.count() << "ms";
+
+    circ::serialize( *cli.get< circ::cli::IROut >(), circuit.get() );
+    return 0;
+}
@@ -8,9 +8,14 @@
 
 #include <circuitous/Support/CLIArgs.hpp>
 
+#include <circuitous/Run/Batch.hpp>
 #include <circuitous/Run/Execute.hpp>
+#include <circuitous/Run/IncrementalConversion.hpp>
 #include <circuitous/Run/Inspect.hpp>
 #include <circuitous/Run/Interpreter.hpp>
+#include <circuitous/Run/Pipeline.hpp>
+#include <circuitous/Run/ResultWriter.hpp>
+#include <circuitous/Run/StepCache.hpp>
 #include <circuitous/Run/Trace.hpp>
 #include <circuitous/Run/TraceConversion.hpp>
 
@@ -56,6 +61,21 @@ namespace circ::cli::run
         }
     };
 
+    struct Batch : DefaultCmdOpt, PathArg
+    {
+        static inline const auto opt = CmdOpt("--batch", false);
+        static std::string help()
+        {
+            std::stringstream ss;
+            ss << "Verify many traces against one circuit: directory (all .json and .jsonl "
+               << "files in it), manifest file with one trace path per line, or `-` to "
+               << "read the paths from stdin.\n"
+               << "Traces are scheduled across --threads workers, results of each one and "
+               << "summary.json are stored into --export-derived directory.\n";
+            return ss.str();
+        }
+    };
+
     struct Memory : DefaultCmdOpt, PathArg
     {
         static inline const auto opt = CmdOpt("--memory", false);
@@ -132,6 +152,89 @@ namespace circ::cli::run
         static inline const auto opt = CmdOpt("--ctl", false);
     };
 
+    struct Pipeline : DefaultCmdOpt, Arity< 0 >
+    {
+        static inline const auto opt = CmdOpt("--pipeline", false);
+        static std::string help()
+        {
+            std::stringstream ss;
+            ss << "Verify in a streaming pipeline: trace reader -> parallel verifiers -> "
+               << "ordered writer.\n"
+               << "Results are written as they are produced, see --export-format. Traces "
+               << "with `.jsonl` extension (one entry per line) are read lazily.\n";
+            return ss.str();
+        }
+    };
+
+    struct StepCache : DefaultCmdOpt, NumArg
+    {
+        static inline const auto opt = CmdOpt("--step-cache", false);
+        static std::string help()
+        {
+            std::stringstream ss;
+            ss << "Memoize results of steps that have equal values of all leaves the "
+               << "circuit reads (timestamps are relative), used by --ctl verify, "
+               << "--pipeline and --batch.\n"
+               << "Argument is the memory bound of the cache in MiB.\n";
+            return ss.str();
+        }
+    };
+
+    struct Covered : DefaultCmdOpt, PathArg
+    {
+        static inline const auto opt = CmdOpt("--covered", false);
+        static std::string help()
+        {
+            std::stringstream ss;
+            ss << "Incremental trace conversion: CIFF file with instructions the --ir-in "
+               << "circuit was lifted from.\n"
+               << "Only encodings not listed there are lifted (into a delta circuit), "
+               << "steps are converted in parallel batches, see --threads.\n";
+            return ss.str();
+        }
+    };
+
+    struct DeltaOut : DefaultCmdOpt, PathArg
+    {
+        static inline const auto opt = CmdOpt("--delta-out", false);
+        static std::string help()
+        {
+            std::stringstream ss;
+            ss << "Store the delta circuit of incremental conversion (if any) into given "
+               << "file, instructions it covers are stored next to it with `.ciff` "
+               << "extension.\n";
+            return ss.str();
+        }
+    };
+
+    struct ExportFormat : DefaultCmdOpt, Arity< 1 >, HasAllowed< ExportFormat >
+    {
+        static inline const auto opt = CmdOpt("--export-format", false);
+        static std::string help()
+        {
+            std::stringstream ss;
+            ss << "Format of exported results of --ctl verify, --pipeline or --batch, "
+               << "all of them are streamed:\n"
+               << "\tjson: Indented JSON document (default without --pipeline).\n"
+               << "\tjson-compact: Same as json, without whitespace.\n"
+               << "\tjsonl: One object per step (default with --pipeline).\n"
+               << "\tbin: Compact binary encoding.\n";
+            return ss.str();
+        }
+
+        static inline std::unordered_set< std::string > allowed =
+        {
+            "json", "json-compact", "jsonl", "bin"
+        };
+
+        static std::optional< std::string > cast(std::vector< std::string > tokens)
+        {
+            if (tokens.size() != 1)
+                return {};
+            return { std::move( tokens[0] ) };
+        }
+    };
+
 } // namespace circ::cli::run
 
 auto load_circ(const std::string &file)
@@ -204,53 +307,104 @@ llvm::json::Object serialize(const auto &ctl)
     return out;
 }
 
-llvm::json::Object serialize( const std::vector< circ::run::result_t > &results,
-                              const auto &memory_hints )
+void store_json(const std::string &path, llvm::json::Object obj)
 {
-    llvm::json::Object out;
-
-    auto export_result = [ & ]( auto r ) -> std::string
-    {
-        if ( circ::run::accepted( r ) )
-            return "accept";
-        if ( circ::run::rejected( r ) )
-            return "reject";
-        return "error";
-    };
+    // Open output file
+    std::error_code ec;
+    llvm::raw_fd_ostream output(path, ec, llvm::sys::fs::OF_Text);
+    circ::check(!ec) << "Error while opening output state JSON file: " << ec.message();
 
-    circ::log_dbg() << to_string( results.back() );
-    out[ "result" ] = export_result( results.back() );
-    circ::log_info() << "result:" << export_result( results.back() );
+    output << llvm::formatv("{0:2}", llvm::json::Value(std::move(obj)));
+}
 
-    llvm::json::Object traces;
-    for ( std::size_t i = 0; i < results.size(); ++i )
-    {
-        llvm::json::Object trace;
-        trace[ "result" ] = export_result( results[ i ] );
+template< typename CLI >
+std::unique_ptr< circ::run::step_cache > make_step_cache(const CLI &parsed_cli,
+                                                         circ::Circuit *circuit)
+{
+    auto mib = parsed_cli.template get< circ::cli::run::StepCache >();
+    if (!mib)
+        return {};
 
-        llvm::json::Object out_hints;
-        for ( std::size_t j = 0; j < memory_hints[ i ].size(); ++j )
-        {
-            auto val = memory_hints[ i ][ j ];
-            out_hints[ str( val.id() ) ] = serialize_mem_hint( val );
-        }
-        trace[ "memory_hints" ] = std::move( out_hints );
+    circ::run::step_cache_config config;
+    config.max_bytes = *mib << 20;
+    return std::make_unique< circ::run::step_cache >(circuit, config);
+}
 
-        traces[hex(i)] = std::move( trace );
-    }
+void report(const std::unique_ptr< circ::run::step_cache > &cache)
+{
+    if (cache)
+        circ::log_info() << "[circuitous-run]: step cache:" << cache->stats().to_string();
+}
 
-    out[ "traces" ] = std::move( traces );
-    return out;
+template< typename CLI >
+std::string export_format(const CLI &parsed_cli, const std::string &fallback)
+{
+    auto format = parsed_cli.template get< circ::cli::run::ExportFormat >();
+    return (format) ? *format : fallback;
 }
 
-void store_json(const std::string &path, llvm::json::Object obj)
+template< typename CLI >
+std::unique_ptr< llvm::raw_fd_ostream > open_export(const CLI &parsed_cli,
+                                                    const std::string &format)
 {
-    // Open output file
+    auto result_path = parsed_cli.template get< circ::cli::run::ExportDerived >();
+    circ::check(result_path) << "Missing --export-derived.";
+
+    auto flags = (circ::run::binary_result_format(format)) ? llvm::sys::fs::OF_None
+                                                            : llvm::sys::fs::OF_Text;
     std::error_code ec;
-    llvm::raw_fd_ostream output(path, ec, llvm::sys::fs::OF_Text);
-    circ::check(!ec) << "Error while opening output state JSON file: " << ec.message();
+    auto output = std::make_unique< llvm::raw_fd_ostream >(*result_path, ec, flags);
+    circ::check(!ec) << "Error while opening output file: " << ec.message();
+    return output;
+}
 
-    output << llvm::formatv("{0:2}", llvm::json::Value(std::move(obj)));
+template< typename CLI >
+void verify_pipelined(const CLI &parsed_cli, circ::Circuit *circuit,
+                      const std::string &trace_path)
+{
+    circ::run::pipeline_config config;
+    if (auto threads = parsed_cli.template get< circ::cli::Threads >())
+        config.workers = *threads;
+
+    auto format = export_format(parsed_cli, "jsonl");
+    auto output = open_export(parsed_cli, format);
+
+    auto cache = make_step_cache(parsed_cli, circuit);
+    config.cache = cache.get();
+
+    auto reader = circ::run::trace::native::EntryReader(trace_path);
+    auto result = circ::run::with_result_writer(format, *output, [&](auto &writer)
+    {
+        return circ::run::verify_pipelined(circuit, std::move(reader), writer, config);
+    });
+    circ::log_info() << "result:" << circ::run::export_result(result);
+    report(cache);
+}
+
+template< typename CLI >
+void verify_batch(const CLI &parsed_cli, circ::Circuit *circuit)
+{
+    auto source = *parsed_cli.template get< circ::cli::run::Batch >();
+    auto traces = circ::run::collect_traces(source);
+    circ::log_info() << "[circuitous-run]: batch of" << traces.size() << "traces.";
+
+    circ::run::batch_config config;
+    config.output_dir = *parsed_cli.template get< circ::cli::run::ExportDerived >();
+    config.format = export_format(parsed_cli, "json");
+    if (auto threads = parsed_cli.template get< circ::cli::Threads >())
+        config.workers = *threads;
+
+    auto cache = make_step_cache(parsed_cli, circuit);
+    config.cache = cache.get();
+
+    auto summary = circ::run::verify_batch(circuit, traces, config);
+
+    summary.store(config.output_dir);
+
+    circ::log_info() << "[circuitous-run]: batch done in" << summary.wall_ms << "ms,"
+                     << "accepted:" << summary.accepted() << "rejected:" << summary.rejected()
+                     << "errors:" << summary.errors();
+    report(cache);
 }
 
 template< typename Runner, typename CLI >
@@ -258,9 +412,25 @@ void run(const CLI &parsed_cli)
 {
     auto circuit = load_circ(*parsed_cli.template get< circ::cli::run::IRIn >());
 
+    if (parsed_cli.template present< circ::cli::run::Batch >())
+    {
+        verify_batch(parsed_cli, circuit.get());
+        if (parsed_cli.template present< circ::cli::run::Die >())
+            circ::log_kill() << "FLAGS_die induced death.";
+        return;
+    }
+
     auto json_trace = parsed_cli.template get< circ::cli::run::Traces >();
     circ::check(json_trace);
 
+    if (parsed_cli.template present< circ::cli::run::Pipeline >())
+    {
+        verify_pipelined(parsed_cli, circuit.get(), *json_trace);
+        if (parsed_cli.template present< circ::cli::run::Die >())
+            circ::log_kill() << "FLAGS_die induced death.";
+        return;
+    }
+
     auto trace = circ::run::trace::native::load_json(*json_trace);
     circ::check(trace.entries.size() >= 2) << trace.entries.size();
 
@@ -281,24 +451,25 @@ void run(const CLI &parsed_cli)
         auto result_path = parsed_cli.template get< circ::cli::run::ExportDerived >();
         store_json(*result_path, std::move(as_json));
     } else if ( ctl == "verify" ) {
-        std::vector< circ::run::parsed_mem_hints > memory_hints;
-        auto collect = [ & ]( const auto &result_spawn_pairs )
-        {
-            for ( auto &[ status, spawn ] : result_spawn_pairs )
-                if ( circ::run::accepted( status ) )
-                {
-                    memory_hints.push_back( spawn->get_derived_mem() );
-                    return;
-                }
-            memory_hints.emplace_back();
-        };
+        auto cache = make_step_cache(parsed_cli, circuit.get());
+        auto format = export_format(parsed_cli, "json");
+        auto output = open_export(parsed_cli, format);
 
-        auto results = circ::run::StatelessControl().test( circuit.get(), trace, collect );
-        circ::log_dbg() << "[circuitous-run]:" << "Collected " << memory_hints.size()
-                                               << "memory hints";
-        auto as_json = serialize( results, memory_hints );
-        auto result_path = parsed_cli.template get< circ::cli::run::ExportDerived >();
-        store_json( *result_path, std::move( as_json ) );
+        auto result = circ::run::with_result_writer(format, *output, [&](auto &writer)
+        {
+            auto write = [&](std::size_t idx, auto &&outcome)
+            {
+                writer.step({ idx, outcome.status, std::move(outcome.memory_hints) });
+            };
+            auto last = circ::run::StatelessControl().stream_outcomes(circuit.get(), trace,
+                                                                      cache.get(), write);
+            writer.finish(last, trace.size() - 1);
+            return last;
+        });
+
+        circ::log_dbg() << to_string(result);
+        circ::log_info() << "result:" << circ::run::export_result(result);
+        report(cache);
 
     } else {
         circ::log_kill() << "uknown ctl";
@@ -357,6 +528,45 @@ void convert_trace( const auto &cli )
     circ::run::trace::trace_converter().convert_trace( traces, circuit.get() ).dump( out );
 }
 
+void store_delta( const std::string &path, circ::Circuit *delta,
+                  const circ::run::trace::delta_plan &plan )
+{
+    circ::serialize( path, delta );
+
+    auto ciff = circ::CIFFWriter( path + ".ciff" );
+    circ::check( ciff ) << "Cannot open" << path + ".ciff";
+    for ( const auto &inst : plan.fresh )
+        ciff << inst;
+}
+
+void convert_trace_incremental( const auto &cli )
+{
+    auto out = *cli.template get< circ::cli::run::Output >();
+    auto trace_file = *cli.template get< circ::cli::run::Traces >();
+
+    auto base = load_circ( *cli.template get< circ::cli::run::IRIn >() );
+    auto coverage = circ::run::trace::coverage_t::from_ciff(
+            *cli.template get< circ::cli::run::Covered >() );
+
+    auto loader = circ::run::trace::incremental_loader();
+    auto traces = loader.parse_alien_trace( trace_file );
+    auto plan = loader.plan( coverage );
+    circ::log_info() << "[run]:" << "Base circuit covers" << coverage.size() << "encodings,"
+                     << plan.fresh.size() << "new ones were seen.";
+
+    auto delta = std::move( loader ).reconstruct_delta( plan );
+    if ( auto delta_out = cli.template get< circ::cli::run::DeltaOut >(); delta_out && delta )
+        store_delta( *delta_out, delta.get(), plan );
+
+    circ::run::trace::incremental_config config;
+    if ( auto threads = cli.template get< circ::cli::Threads >() )
+        config.workers = *threads;
+
+    circ::run::trace::incremental_converter( base.get(), delta.get(), config )
+        .convert_trace( traces, plan )
+        .dump( out );
+}
+
 using run_modes = circ::tl::TL<
     circ::cli::run::Derive,
     circ::cli::run::Verify,
@@ -378,9 +588,16 @@ using output_options = circ::tl::TL<
 >;
 using config_options = circ::tl::TL<
     circ::cli::run::Traces,
+    circ::cli::run::Batch,
     circ::cli::run::Memory,
     circ::cli::run::Die,
-    circ::cli::run::Ctl
+    circ::cli::run::Ctl,
+    circ::cli::run::Pipeline,
+    circ::cli::run::ExportFormat,
+    circ::cli::run::StepCache,
+    circ::cli::run::Covered,
+    circ::cli::run::DeltaOut,
+    circ::cli::Threads
 >;
 using other_options = circ::tl::TL<
     circ::cli::Help,
@@ -439,6 +656,47 @@ std::optional< circ::ParsedCmd > parse_and_validate(int argc, char *argv[])
         return {};
     }
 
+    if (v.check(implies< cli::run::Pipeline, cli::run::Verify >())
+         .check(implies< cli::run::Pipeline, cli::run::ExportDerived >())
+         .check(implies< cli::run::ExportFormat, cli::run::Verify >())
+         .process_errors(yield_err))
+    {
+        return {};
+    }
+
+    if (v.check(implies< cli::run::Batch, cli::run::Verify >())
+         .check(implies< cli::run::Batch, cli::run::ExportDerived >())
+         .check(are_exclusive< cli::run::Batch, cli::run::Traces >())
+         .check(are_exclusive< cli::run::Batch, cli::run::Pipeline >())
+         .process_errors(yield_err))
+    {
+        return {};
+    }
+
+    // Outside of batch and pipeline only `--ctl verify` exports streamed results and uses
+    // the step cache, `--ctl derive` (the default) would silently ignore these options.
+    auto verifies = parsed.present< cli::run::Batch >()
+                 || parsed.present< cli::run::Pipeline >()
+                 || parsed.get< cli::run::Ctl >() == "verify";
+    if (!verifies && parsed.present< cli::run::ExportFormat >())
+    {
+        yield_err("--export-format requires --ctl verify, --pipeline or --batch.");
+        return {};
+    }
+    if (!verifies && parsed.present< cli::run::StepCache >())
+    {
+        yield_err("--step-cache requires --ctl verify, --pipeline or --batch.");
+        return {};
+    }
+
+    if (v.check(implies< cli::run::Covered, cli::run::ConvertTrace >())
+         .check(implies< cli::run::Covered, cli::run::IRIn >())
+         .check(implies< cli::run::DeltaOut, cli::run::Covered >())
+         .process_errors(yield_err))
+    {
+        return {};
+    }
+
     return parsed;
 }
 
@@ -481,7 +739,10 @@ int main(int argc, char *argv[])
         circ::unreachable() << "--derive is currently broken, WIP.";
         run< circ::run::Interpreter >(cli);
     } else if (cli.present< circ::cli::run::ConvertTrace >()) {
-        convert_trace(cli);
+        if (cli.present< circ::cli::run::Covered >())
+            convert_trace_incremental(cli);
+        else
+            convert_trace(cli);
     } else if (cli.present< circ::cli::run::ParseTrace >()) {
         parse_trace(cli);
     } else {
@@ -8,6 +8,7 @@
 #include <iomanip>
 #include <iostream>
 #include <set>
+#include <sstream>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -15,7 +16,9 @@
 
 #include <circuitous/Util/Warnings.hpp>
 #include <circuitous/Lifter/Shadows.hpp>
+#include <circuitous/Fuzz/FuzzEngine.hpp>
 #include <circuitous/Fuzz/InstructionFuzzer.hpp>
+#include <circuitous/Lifter/Semantics.hpp>
 #include <circuitous/Support/Ciff.hpp>
 
 CIRCUITOUS_RELAX_WARNINGS
@@ -42,9 +45,9 @@ DEFINE_string(file, "", "Binary file to load from (separated by ,");
 DEFINE_string(out, "", "File to store plain bytes to.");
 DEFINE_string(cif, "", "File to store dbg format to.");
 DEFINE_string(filter, "", "File that contains allowed opcodes.");
+DEFINE_uint64(workers, 0, "Number of threads fuzzing operands, 0 for the number of cores.");
 
 // TODO(lukas): Filter by instruction.
-// TODO(lukas): Paralelism
 // TODO(lukas): Allow multiple sources
 // TODO(lukas): Allow also lift?
 
@@ -256,12 +259,9 @@ struct rinst_bytes_comparator
 struct Acceptor
 {
     using seen_t = std::unordered_set< std::string >;
+    using fingerprints_t = std::unordered_set< std::string >;
 
-    using entry_t = std::tuple< circ::shadowinst::Instruction, std::string >;
-    using bytes_map_t = std::unordered_map< uint64_t, std::vector< entry_t > >;
-    using iclass_cache_t = std::unordered_map< std::string, bytes_map_t >;
-
-    iclass_cache_t shadows;
+    fingerprints_t fingerprints;
     std::unordered_set< std::string > allowed;
     seen_t seen;
     prune::Exec< prune::X86Prefixes > spec;
@@ -289,30 +289,65 @@ struct Acceptor
         return allowed.count(get_iclass(iform));
     }
 
-    bool already_parsed(const circ::shadowinst::Instruction &nshadow,
-            const remill::Instruction &rinst)
+    // Canonical form of a fuzzed encoding - bits that are not part of any operand
+    // (operand bits are masked out) and the layout of operands over the encoding.
+    // Encodings of one iclass with the same fingerprint get the same decoder, therefore
+    // only the first one is kept.
+    std::string fingerprint(const circ::shadowinst::Instruction &nshadow,
+                            const remill::Instruction &rinst)
     {
-        auto remove_shade = [&](const auto &s_inst) {
-            return circ::shadowinst::remove_shadowed(s_inst, rinst.bytes);
+        std::stringstream ss;
+        ss << get_iclass(rinst.function) << " ";
+
+        decltype(nshadow.enc) operand_bits;
+        for (auto [from, size] : nshadow.IdentifiedRegions())
+            for (auto i = from; i < from + size; ++i)
+                operand_bits.set(i);
+        for (std::size_t i = 0; i < nshadow.enc_bitsize; ++i)
+            ss << (operand_bits[i] ? '-' : (nshadow.enc[i] ? '1' : '0'));
+
+        auto regions = [&](const auto &leaf) {
+            ss << "(";
+            for (auto [from, size] : leaf.regions.areas)
+                ss << from << ":" << size << ",";
+            ss << ")";
+        };
+        auto maybe_regions = [&](const auto &leaf) {
+            if (leaf)
+                regions(*leaf);
+            else
+                ss << "_";
         };
 
-        auto iclass = get_iclass(rinst.function);
-        auto size = rinst.bytes.size();
-        for (const auto &[shadow, iform] : shadows[iclass][size])
-            if (nshadow == shadow && remove_shade(nshadow) == remove_shade(shadow))
-                return true;
-        return false;
-    }
+        for (const auto &op : nshadow.operands)
+        {
+            if (auto addr = op.address())
+            {
+                // Absent parts are recorded too, so each leaf keeps its role (base, index, ...).
+                ss << " a";
+                for (const auto &reg : addr->_regs)
+                    maybe_regions(reg);
+                for (const auto &imm : addr->_imms)
+                    maybe_regions(imm);
+                continue;
+            }
+            ss << (op.reg() ? " r" : op.immediate() ? " i" : " s");
+            op.for_each_present(regions);
+        }
 
-    void add_to_cache(circ::shadowinst::Instruction nshadow,
-            const remill::Instruction &rinst)
-    {
-        auto iclass = get_iclass(rinst.function);
-        auto size = rinst.bytes.size();
-        shadows[iclass][size].emplace_back(std::move(nshadow), rinst.function);
+        for (const auto &cluster : nshadow.deps)
+        {
+            ss << " [";
+            for (const auto &[idx, _] : cluster)
+                ss << idx << ",";
+            ss << "]";
+        }
+        return ss.str();
     }
 
-    bool should_accept(const remill::Instruction &rinst)
+    // Checks that do not require fuzzing, split from `should_accept` so that
+    // candidates can be fuzzed in batches.
+    bool is_candidate(const remill::Instruction &rinst)
     {
         if (seen.count(rinst.bytes))
             return false;
@@ -320,15 +355,22 @@ struct Acceptor
         if (!spec.is_valid(dbg_dump_bytes(rinst.bytes)))
             return false;
 
-        if (!allowed_iform(rinst.function))
-            return false;
+        return allowed_iform(rinst.function);
+    }
 
-        auto nshadow = circ::InstructionFuzzer{ rinst.arch, rinst }.fuzz_ops();
-        if (already_parsed(nshadow, rinst))
+    bool accept_fuzzed(const circ::shadowinst::Instruction &nshadow,
+                       const remill::Instruction &rinst)
+    {
+        return fingerprints.insert(fingerprint(nshadow, rinst)).second;
+    }
+
+    bool should_accept(const remill::Instruction &rinst)
+    {
+        if (!is_candidate(rinst))
             return false;
 
-        add_to_cache(std::move(nshadow), rinst);
-        return true;
+        auto nshadow = circ::InstructionFuzzer{ rinst.arch, rinst }.fuzz_ops();
+        return accept_fuzzed(nshadow, rinst);
     }
 
 };
@@ -387,8 +429,11 @@ struct Parser
     R parsed;
 
     Acceptor &acceptor;
+    circ::fuzz_engine &engine;
 
-    Parser(rctx_t &rctx_, Acceptor &acc_) : rctx(rctx_), acceptor(acc_) {}
+    Parser(rctx_t &rctx_, Acceptor &acc_, circ::fuzz_engine &engine_)
+        : rctx(rctx_), acceptor(acc_), engine(engine_)
+    {}
 
     self_t &provide(llvm::StringRef what)
     {
@@ -396,21 +441,72 @@ struct Parser
         return *this;
     }
 
-    R take() { return std::move(parsed); }
+    struct stats_t
+    {
+        // Instructions decoded from all buffers.
+        std::size_t decoded = 0;
+        std::size_t fuzzed = 0;
+        std::chrono::duration< double > fuzzing{ 0 };
+    };
 
+    stats_t stats;
+    std::vector< rinst_t > candidates;
+
+    R take()
+    {
+        CHECK(candidates.empty()) << "Parser::finish was not called.";
+        return std::move(parsed);
+    }
+
+    static constexpr std::size_t batch_size = 4096;
+
+    // Candidates are fuzzed in batches by `engine` and accepted in the order they
+    // were decoded, same as if `Acceptor::should_accept` was called on each of them.
+    // A batch is not cut at the end of a buffer, so candidates of several input files
+    // are fuzzed at once - `finish` must be called once all buffers are provided.
     self_t &run()
     {
         while (!buffer.empty()) {
             rinst_t inst;
             if (rctx.DecodeInstruction(0, buffer.substr(0, 0x20), inst, {}))
-                if (acceptor.should_accept(inst))
-                    parsed.emplace(std::move(inst));
+            {
+                ++stats.decoded;
+                if (acceptor.is_candidate(inst))
+                    candidates.push_back(std::move(inst));
+            }
             buffer = buffer.drop_front(1);
+
+            if (candidates.size() == batch_size)
+                accept();
         }
         return *this;
     }
+
+    self_t &finish()
+    {
+        accept();
+        return *this;
+    }
+
+    void accept()
+    {
+        auto begin = std::chrono::steady_clock::now();
+        auto shadows = engine.fuzz(candidates);
+        stats.fuzzing += std::chrono::steady_clock::now() - begin;
+        stats.fuzzed += candidates.size();
+
+        for (std::size_t i = 0; i < candidates.size(); ++i)
+            if (acceptor.accept_fuzzed(shadows[i], candidates[i]))
+                parsed.emplace(std::move(candidates[i]));
+        candidates.clear();
+    }
 };
 
+double per_second(std::size_t count, std::chrono::duration< double > took)
+{
+    return (took.count() > 0) ? static_cast< double >(count) / took.count() : 0.0;
+}
+
 std::string dbg_dump(const Parsed &parsed)
 {
     std::stringstream ss;
@@ -470,18 +566,22 @@ int main(int argc, char *argv[])
     auto arch_name = remill::GetArchName(FLAGS_arch);
     auto os_name = remill::GetOSName(FLAGS_os);
     auto owning_arch_ptr = remill::Arch::Build(olctx.get(), os_name, arch_name);
-    auto owning_module_pre = remill::LoadArchSemantics(owning_arch_ptr.get());
+    auto owning_module_pre = circ::isem::load_semantics(*owning_arch_ptr);
 
     Acceptor acceptor(load_config< std::unordered_set< std::string > >(FLAGS_filter));
     if (!FLAGS_prune_spec.empty())
         acceptor.spec = prune::Exec< prune::X86Prefixes >(prune::Spec::load(FLAGS_prune_spec));
 
-    Parser< Parsed > parser{ *owning_arch_ptr, acceptor };
+    auto workers = FLAGS_workers ? FLAGS_workers : circ::hardware_threads();
+    circ::fuzz_engine engine(*owning_arch_ptr, FLAGS_os, FLAGS_arch, workers);
+
+    Parser< Parsed > parser{ *owning_arch_ptr, acceptor, engine };
 
+    auto seeding = std::chrono::steady_clock::now();
     uint32_t idx = 0;
     for (auto file : input_list)
     {
-        auto before = parser.parsed->size();
+        auto decoded = parser.stats.decoded;
         auto begin = std::chrono::steady_clock::now();
         std::cout << "[ " << ++idx << " / " << input_list.size() << " ]"
                   << " ... "
@@ -493,12 +593,27 @@ int main(int argc, char *argv[])
 
         parser.provide(buff).run();
 
-        auto end = std::chrono::steady_clock::now();
-        std::chrono::duration< double > diff = end - begin;
-        std::cout << " ... done,"
-                  << parser.parsed->size() << "( +" << parser.parsed->size() - before << " )"
+        std::chrono::duration< double > diff = std::chrono::steady_clock::now() - begin;
+        decoded = parser.stats.decoded - decoded;
+        std::cout << " ... done, decoded " << decoded << " instructions"
+                  << " ( " << per_second(decoded, diff) << " inst/s ), "
+                  << parser.parsed->size() << " accepted so far,"
                   << " and took: " << diff.count() << " sec." << std::endl;
     }
+    parser.finish();
+
+    std::chrono::duration< double > took = std::chrono::steady_clock::now() - seeding;
+    const auto &totals = parser.stats;
+    std::cout << "Fuzzed " << totals.fuzzed << " candidates in " << totals.fuzzing.count()
+              << " sec ( " << per_second(totals.fuzzed, totals.fuzzing) << " inst/s ), "
+              << "accepted " << parser.parsed->size() << "." << std::endl;
+    std::cout << "Seeding decoded " << totals.decoded << " instructions in " << took.count()
+              << " sec ( " << per_second(totals.decoded, took) << " inst/s )." << std::endl;
+
+    auto stats = engine.decode_stats();
+    std::cout << "Decode cache: " << stats.hits << " hits, " << stats.misses << " misses ("
+              << stats.hit_rate() * 100 << "% hit rate)." << std::endl;
+
     auto filtered = parser.take();
     std::cout << "Parsing done, proceeding to writing result.";
     filtered.write_bytes_into(out);
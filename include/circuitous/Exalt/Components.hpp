@@ -52,6 +52,20 @@ namespace circ::exalt
         llvm::BasicBlock *bb() const { return &*fn.begin(); }
     };
 
+    // Values gathered by a producer that lifted only a part of the worklist (in its own
+    // `Ctx`) need to survive the move into the context of the producer that finalizes
+    // the circuit. They are attached as arguments to calls of `__circ.partial.<kind>`
+    // declarations and collected again once the partial function is inlined.
+    struct partial_marker
+    {
+        static constexpr const char *prefix = "__circ.partial.";
+
+        static llvm::CallInst *make( builder_t &irb, const std::string &kind, values_t args );
+
+        // Returns empty string if `call` is not a marker.
+        static std::string kind( llvm::CallInst *call );
+    };
+
     /* Owns everything related to function manipulation. */
     struct function_context
     {
@@ -118,6 +118,9 @@ namespace circ::exalt
 
         auto finalize_circuit( exalted_value_buckets ) -> value_t override;
 
+        void export_partial() override;
+        void import_partial( const std::string &kind, llvm::CallInst *marker ) override;
+
         /* Local logic */
         void account( const reg_final_values_t &other );
 
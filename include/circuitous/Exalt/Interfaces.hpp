@@ -101,6 +101,12 @@ namespace circ::exalt
         // This allows more freedom on how things will be wired and connected.
         virtual value_t finalize_circuit(exalted_value_buckets) = 0;
 
+        // Parallel lifting - state gathered across units has to be exported as
+        // `partial_marker`s by a producer that lifted only a part of the worklist and
+        // imported from them by the producer that finalizes the circuit.
+        virtual void export_partial() {}
+        virtual void import_partial( const std::string &kind, llvm::CallInst *marker ) {}
+
         // TODO( exalt ): Is this required?
         bool is_persistent() const override { return true; }
     };
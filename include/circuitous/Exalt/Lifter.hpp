@@ -20,6 +20,9 @@
 #include <circuitous/Support/Log.hpp>
 #include <circuitous/Support/Check.hpp>
 
+#include <string>
+#include <string_view>
+
 namespace circ::exalt
 {
     struct unit_lifter
@@ -93,9 +96,26 @@ namespace circ::exalt
             pcs.add( std::move( allocator ) );
         }
 
+        // Parallel lifting - all producers of one worklist select operands from the same
+        // translation maps (built from the whole worklist), see `TM_allocator`.
+        void add_operand_selector( const TM_cache &shared )
+        {
+            TM_cache cache( ctx );
+            cache.storage = shared.storage;
+            component_t allocator = std::make_shared< TM_allocator >( ctx, cache );
+            pcs.add( std::move( allocator ) );
+        }
+
         void exalt( unit_t &unit );
         void finalize();
 
+        // Parallel lifting - a producer that lifted only a part of the worklist in its
+        // own `Ctx` stores everything `finalize` needs as `partial_marker`s and returns
+        // its module as bitcode. The producer that finalizes the circuit links it into
+        // its module, inlines the partial function and imports the markers.
+        std::string export_partial() &&;
+        void merge_partial( std::string_view bitcode );
+
         auto take_fn() &&
         {
             return std::move( b_ctx ).take_fn();
@@ -103,5 +123,8 @@ namespace circ::exalt
 
       protected:
         void init_pcs();
+
+        static constexpr const char *partial_fn_name = "__circ.partial_circuit";
+        static std::string log_prefix() { return "[exalt:circuit-producer]:"; }
     };
 }  // namespace circ::exalt
@@ -91,6 +91,8 @@ namespace circ::exalt
       public:
 
         operand_selector( builder_t &irb, State &state, const shadowinst::TM_t &tm );
+        // Adopts a mux made by another `operand_selector`, see `TM_allocator::import_partial`.
+        explicit operand_selector( value_t mux ) : mux( mux ) {}
 
         void add_user( builder_t &irb, value_t condition, value_t value );
         value_t update_mux( builder_t &irb );
@@ -211,6 +213,13 @@ namespace circ::exalt
                        State &state,
                        std::size_t idx )
             -> operand_selector & override;
+
+        // Parallel lifting - producers of all partitions share `storage`, therefore a mux
+        // is identified by its key in `read_map` and position. Muxes of partitions with
+        // the same identity are merged into one, which makes the circuit the same as if
+        // all partitions were lifted by a single allocator.
+        void export_partial( builder_t &irb );
+        void import_partial( llvm::CallInst *marker );
     };
 
     // TODO( exalt:design ): Maybe something like `mux_[maker,materializer]`
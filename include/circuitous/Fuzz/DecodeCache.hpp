@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <remill/Arch/Arch.h>
+#include <remill/Arch/Instruction.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace circ::ifuzz
+{
+    // Results of `remill::Arch::DecodeInstruction` (at address 0, without decoding
+    // context) keyed by the decoded bytes, including the failed ones.
+    //
+    // Fuzzing decodes each bit flip of an instruction and instructions of the same iform
+    // produce a lot of the same flipped encodings. The cache can be shared by fuzzers
+    // running on different threads with different instances of the same arch (decoded
+    // instructions keep pointer to the instance that decoded them, fuzzers never use it).
+    //
+    // Entries are split into shards with a lock each. A shard that reaches its share
+    // of `capacity` evicts its oldest entry for each inserted one.
+    struct decode_cache
+    {
+        using decoded_t = std::optional< remill::Instruction >;
+
+        struct stats_t
+        {
+            std::uint64_t hits = 0;
+            std::uint64_t misses = 0;
+
+            double hit_rate() const
+            {
+                auto total = hits + misses;
+                return total ? double( hits ) / double( total ) : 0.0;
+            }
+        };
+
+      private:
+        static constexpr std::size_t shard_count = 64;
+
+        struct shard_t
+        {
+            std::mutex mtx;
+            std::unordered_map< std::string, decoded_t > entries;
+            // Keys of `entries` in order of insertion (keys of the map are stable).
+            std::deque< std::string_view > order;
+        };
+
+        std::array< shard_t, shard_count > shards;
+        std::size_t shard_capacity;
+
+        std::atomic< std::uint64_t > hits = 0;
+        std::atomic< std::uint64_t > misses = 0;
+
+      public:
+        explicit decode_cache( std::size_t capacity = 1u << 18 )
+            : shard_capacity( std::max< std::size_t >( capacity / shard_count, 1 ) )
+        {}
+
+        decode_cache( const decode_cache & ) = delete;
+        decode_cache &operator=( const decode_cache & ) = delete;
+
+        decoded_t decode( const remill::Arch &arch, std::string_view bytes )
+        {
+            if ( auto cached = lookup( bytes ) )
+                return std::move( *cached );
+
+            auto out = decode_uncached( arch, bytes );
+            insert( bytes, out );
+            return out;
+        }
+
+        // Lookups of the whole batch happen before anything is decoded, therefore
+        // repeated encodings within the batch are decoded only once as well - and are
+        // counted as hits, same as if the batch was decoded one by one.
+        std::vector< decoded_t > decode( const remill::Arch &arch,
+                                         std::span< const std::string > batch )
+        {
+            std::vector< decoded_t > out( batch.size() );
+            std::unordered_map< std::string_view, std::vector< std::size_t > > missing;
+
+            for ( std::size_t i = 0; i < batch.size(); ++i )
+            {
+                if ( auto it = missing.find( batch[ i ] ); it != missing.end() )
+                {
+                    ++hits;
+                    it->second.push_back( i );
+                }
+                else if ( auto cached = lookup( batch[ i ] ) )
+                    out[ i ] = std::move( *cached );
+                else
+                    missing[ batch[ i ] ].push_back( i );
+            }
+
+            for ( const auto &[ bytes, idxs ] : missing )
+            {
+                auto decoded = decode_uncached( arch, bytes );
+                for ( auto idx : idxs )
+                    out[ idx ] = decoded;
+                insert( bytes, std::move( decoded ) );
+            }
+            return out;
+        }
+
+        stats_t stats() const { return { hits.load(), misses.load() }; }
+
+        std::size_t size()
+        {
+            std::size_t out = 0;
+            for ( auto &shard : shards )
+            {
+                std::lock_guard lock( shard.mtx );
+                out += shard.entries.size();
+            }
+            return out;
+        }
+
+      private:
+        shard_t &shard_of( std::string_view bytes )
+        {
+            return shards[ std::hash< std::string_view >{}( bytes ) % shard_count ];
+        }
+
+        // `std::nullopt` on miss, cached (possibly failed) decode otherwise.
+        std::optional< decoded_t > lookup( std::string_view bytes )
+        {
+            auto &shard = shard_of( bytes );
+            {
+                std::lock_guard lock( shard.mtx );
+                if ( auto it = shard.entries.find( std::string( bytes ) );
+                     it != shard.entries.end() )
+                {
+                    ++hits;
+                    return std::optional< decoded_t >( std::in_place, it->second );
+                }
+            }
+            ++misses;
+            return std::nullopt;
+        }
+
+        void insert( std::string_view bytes, decoded_t decoded )
+        {
+            auto &shard = shard_of( bytes );
+            std::lock_guard lock( shard.mtx );
+            // Other thread may have decoded the same bytes in the meantime.
+            auto [ it, inserted ] = shard.entries.emplace( std::string( bytes ),
+                                                           std::move( decoded ) );
+            if ( !inserted )
+                return;
+
+            shard.order.push_back( it->first );
+            if ( shard.entries.size() > shard_capacity )
+            {
+                shard.entries.erase( std::string( shard.order.front() ) );
+                shard.order.pop_front();
+            }
+        }
+
+        static decoded_t decode_uncached( const remill::Arch &arch, std::string_view bytes )
+        {
+            remill::Instruction tmp;
+            if ( arch.DecodeInstruction( 0, bytes, tmp, {} ) )
+                return { std::move( tmp ) };
+            return std::nullopt;
+        }
+    };
+
+} // namespace circ::ifuzz
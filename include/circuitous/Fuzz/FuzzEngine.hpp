@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+#pragma once
+
+#include <circuitous/Fuzz/DecodeCache.hpp>
+#include <circuitous/Fuzz/InstructionFuzzer.hpp>
+#include <circuitous/Util/Parallel.hpp>
+
+#include <circuitous/Util/Warnings.hpp>
+
+CIRCUITOUS_RELAX_WARNINGS
+#include <llvm/IR/LLVMContext.h>
+CIRCUITOUS_UNRELAX_WARNINGS
+
+#include <remill/Arch/Arch.h>
+#include <remill/Arch/Instruction.h>
+#include <remill/Arch/Name.h>
+#include <remill/OS/OS.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace circ
+{
+    // Fuzzes operands of many instructions at once.
+    //
+    // Every fuzzed instruction re-decodes all its bit flips, which is independent of
+    // other instructions, but a `remill::Arch` is not meant to be shared between threads.
+    // The first worker therefore uses the `primary` arch and each other worker gets its
+    // own instance (with its own `llvm::LLVMContext`). Instances are built once, on
+    // the first use, and kept for subsequent batches.
+    // Results are always in the order of the input. All workers decode through one
+    // shared `decode_cache`.
+    struct fuzz_engine
+    {
+        using arch_ptr_t = remill::Arch::ArchPtr;
+        using rinsts_t = std::span< const remill::Instruction >;
+        using shadows_t = std::vector< shadowinst::Instruction >;
+
+      private:
+        const remill::Arch &primary;
+        std::string os_name;
+        std::string arch_name;
+        std::size_t workers;
+
+        // Declared before `archs` to outlive them.
+        std::vector< std::unique_ptr< llvm::LLVMContext > > contexts;
+        std::vector< arch_ptr_t > archs;
+
+        ifuzz::decode_cache cache;
+
+      public:
+        fuzz_engine( const remill::Arch &primary,
+                     std::string os_name, std::string arch_name,
+                     std::size_t workers = hardware_threads() )
+            : primary( primary ),
+              os_name( std::move( os_name ) ),
+              arch_name( std::move( arch_name ) ),
+              workers( std::max< std::size_t >( workers, 1 ) )
+        {}
+
+        fuzz_engine( const fuzz_engine & ) = delete;
+        fuzz_engine &operator=( const fuzz_engine & ) = delete;
+
+        shadows_t fuzz( rinsts_t rinsts )
+        {
+            auto count = std::min( workers, rinsts.size() );
+            if ( count <= 1 )
+                return fuzz_serial( rinsts );
+
+            prepare( count );
+
+            std::vector< std::optional< shadowinst::Instruction > > fuzzed( rinsts.size() );
+            std::atomic< std::size_t > next = 0;
+            {
+                std::vector< std::jthread > threads;
+                for ( std::size_t i = 0; i < count; ++i )
+                    threads.emplace_back( [ &, i ]
+                    {
+                        const auto &arch = ( i == 0 ) ? primary : *archs[ i - 1 ];
+                        for ( auto idx = next++; idx < rinsts.size(); idx = next++ )
+                            fuzzed[ idx ].emplace( fuzz_operands( arch, rinsts[ idx ], &cache ) );
+                    } );
+            }
+
+            shadows_t out;
+            out.reserve( fuzzed.size() );
+            for ( auto &shadow : fuzzed )
+                out.push_back( std::move( *shadow ) );
+            return out;
+        }
+
+        auto decode_stats() const { return cache.stats(); }
+
+      private:
+        shadows_t fuzz_serial( rinsts_t rinsts )
+        {
+            shadows_t out;
+            out.reserve( rinsts.size() );
+            for ( const auto &rinst : rinsts )
+                out.push_back( fuzz_operands( primary, rinst, &cache ) );
+            return out;
+        }
+
+        // Archs are built on the calling thread, remill (and decoders it wraps) may
+        // initialize global state when building them.
+        void prepare( std::size_t count )
+        {
+            while ( archs.size() + 1 < count )
+            {
+                auto &llvm_ctx = contexts.emplace_back( std::make_unique< llvm::LLVMContext >() );
+                archs.push_back( remill::Arch::Build( llvm_ctx.get(),
+                                                      remill::GetOSName( os_name ),
+                                                      remill::GetArchName( arch_name ) ) );
+                check( archs.back() != nullptr )
+                    << "Could not build arch" << arch_name << "for operand fuzzing.";
+            }
+        }
+    };
+
+} // namespace circ
@@ -70,12 +70,28 @@ namespace circ
         Arch_ptr arch;
         const remill::Instruction &rinst;
 
+        // Optional, shared with other fuzzers of the same arch.
+        ifuzz::decode_cache *cache;
+
         ifuzz::permutate::permutations_t permutations;
 
-        InstructionFuzzer(Arch_ptr arch_, const remill::Instruction &rinst_)
-          : arch(arch_), rinst(rinst_), permutations(ifuzz::permutate::flip(rinst, arch))
+        InstructionFuzzer(Arch_ptr arch_, const remill::Instruction &rinst_,
+                          ifuzz::decode_cache *cache_ = nullptr)
+          : arch(arch_), rinst(rinst_), cache(cache_),
+            permutations(ifuzz::permutate::flip(rinst, arch, cache))
         {}
 
+        std::optional< remill::Instruction > decode(const std::string &bytes)
+        {
+            if (cache)
+                return cache->decode(*arch, bytes);
+
+            remill::Instruction tmp;
+            if (!arch->DecodeInstruction(0, bytes, tmp, {}))
+                return std::nullopt;
+            return std::make_optional(std::move(tmp));
+        }
+
         std::size_t rinst_bitsize() const { return rinst.bytes.size() * 8; }
 
         // We know that `bits` are used to encode `s_addr`. We need to
@@ -513,11 +529,12 @@ namespace circ
             auto preprocess = [&](const std::string &bytes) {
                 std::stringstream ss;
 
-                remill::Instruction tmp;
-                if (!arch->DecodeInstruction(0, bytes, tmp, {})) {
+                auto decoded = decode(bytes);
+                if (!decoded) {
                     ss << "Decode failed!\n";
                     return yield({}, idxs, ss.str());
                 }
+                auto &tmp = *decoded;
 
                 if (tmp.function != rinst.function) {
                     ss << "Guaranteed permuation generated different instruction!\n";
@@ -534,7 +551,7 @@ namespace circ
                     return yield({}, idxs, ss.str());
                 }
 
-                yield( std::make_optional(std::move(tmp)), idxs, ss.str());
+                yield( std::move(decoded), idxs, ss.str());
             };
 
             permutate(nbytes, idxs, 0, preprocess);
@@ -801,9 +818,10 @@ namespace circ
 
 
     static inline shadowinst::Instruction fuzz_operands(const remill::Arch &arch,
-                                                        const remill::Instruction &rinst)
+                                                        const remill::Instruction &rinst,
+                                                        ifuzz::decode_cache *cache = nullptr)
     {
-        return InstructionFuzzer{&arch, rinst}.fuzz_ops();
+        return InstructionFuzzer{&arch, rinst, cache}.fuzz_ops();
     }
 
 } // namespace circ
@@ -7,6 +7,7 @@
 #include <circuitous/Support/Check.hpp>
 #include <circuitous/Support/Log.hpp>
 #include <circuitous/Util/LLVMUtil.hpp>
+#include <circuitous/Fuzz/DecodeCache.hpp>
 #include <circuitous/Fuzz/DiffResult.hpp>
 
 
@@ -30,24 +31,32 @@ namespace circ::ifuzz::permutate
     // permutations on some architecture is not a reasonable way to go, therefore
     // it is expected some part of the code down the line implements heuristic
     // that can deal with these misses.
+    // If `cache` is provided, all flips are decoded through it as one batch.
     static inline permutations_t flip(
-        const remill::Instruction &rinst, const remill::Arch *arch)
+        const remill::Instruction &rinst, const remill::Arch *arch,
+        decode_cache *cache = nullptr)
     {
-        permutations_t out;
-        out.resize(rinst.bytes.size() * 8);
+        std::vector< std::string > flips;
+        flips.reserve(rinst.bytes.size() * 8);
         for (std::size_t i = 0; i < rinst.bytes.size(); ++i) {
             for (int j = 0; j < 8; ++j) {
-                auto index = 8 * i + static_cast< uint64_t >(j);
-
                 std::string flipped = rinst.bytes;
                 auto byte = static_cast< uint8_t >(flipped[i]);
                 uint8_t mask = 1;
                 flipped[i] = static_cast< char >(byte ^ (mask << j));
+                flips.push_back(std::move(flipped));
+            }
+        }
 
-                remill::Instruction tmp;
-                if (arch->DecodeInstruction(0, flipped, tmp, {})) {
-                    out[index] = std::move(tmp);
-                }
+        if (cache)
+            return cache->decode(*arch, flips);
+
+        permutations_t out;
+        out.resize(flips.size());
+        for (std::size_t index = 0; index < flips.size(); ++index) {
+            remill::Instruction tmp;
+            if (arch->DecodeInstruction(0, flips[index], tmp, {})) {
+                out[index] = std::move(tmp);
             }
         }
         return out;
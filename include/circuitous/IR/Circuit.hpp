@@ -77,7 +77,8 @@ namespace circ
             return Op::op_code_str();
         };
 
-        static std::unordered_map< Operation::kind_t, std::string > cache;
+        // Per thread, as interpreters run concurrently over one circuit.
+        static thread_local std::unordered_map< Operation::kind_t, std::string > cache;
         if (!cache.count(rkind))
             cache[rkind] = dispatch_on_kind_to_all(rkind, get_name);
 
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <circuitous/IR/Circuit.hpp>
+
+#include <circuitous/Util/Warnings.hpp>
+
+CIRCUITOUS_RELAX_WARNINGS
+#include <llvm/ADT/APInt.h>
+CIRCUITOUS_UNRELAX_WARNINGS
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace circ
+{
+    // Value of `InputInstructionBits` of `size` bits for a raw encoding - its first byte
+    // is the least significant one and bits past it are zero (same as in traces).
+    // Empty if the encoding does not fit.
+    std::optional< llvm::APInt > instruction_bits( std::string_view encoding, uint32_t size );
+
+    // Contexts (operands of the root) whose decoder accepts `encoding`. Decoders only
+    // depend on instruction bits (see `VerifyCircuit`), so nothing else has to be known
+    // and nothing is interpreted past them. Decoders with nodes the evaluator does not
+    // support (e.g., rewritten by an optimization) never accept, so callers fall back to
+    // lifting the encoding.
+    std::vector< Operation * > accepting_contexts( Circuit *circuit, std::string_view encoding );
+
+} // namespace circ
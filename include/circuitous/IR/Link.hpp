@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <circuitous/IR/Circuit.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace circ
+{
+    // Links circuits lifted from disjoint sets of instructions (shards) into one, that
+    // has `VerifyInstruction` contexts of all of them.
+    //  * Inputs and outputs (registers, instruction bits, error flags, timestamps,
+    //    memory hints, ...) are shared by all shards, their sizes must agree.
+    //  * Structurally equal nodes are merged, therefore decoders and semantics lifted
+    //    in more than one shard are present only once.
+    //  * Advices are renumbered so that the ones of different shards stay distinct.
+    // Each node of a shard is visited once, linking is linear in the total size
+    // of shards.
+    struct CircuitLinker
+    {
+        struct stats_t
+        {
+            std::size_t shards = 0;
+            std::size_t contexts = 0;
+            std::size_t created = 0;
+            std::size_t reused = 0;
+        };
+
+      private:
+        circuit_owner_t circuit;
+
+        // Structural key -> node of `circuit`.
+        std::unordered_map< std::string, Operation * > nodes;
+        std::unordered_set< Operation * > contexts;
+
+        std::size_t next_advice = 0;
+        stats_t _stats;
+
+      public:
+        explicit CircuitLinker( Circuit::ptr_size_t ptr_size );
+
+        // `shard` is only read, it can be freed right after. Its root must be
+        // an `OnlyOneCondition` of contexts (which is what lifters produce).
+        CircuitLinker &add( Circuit *shard );
+
+        // Linker must not be used afterwards.
+        circuit_owner_t take();
+
+        const stats_t &stats() const { return _stats; }
+
+      private:
+        Operation *import( Operation *op, const std::vector< Operation * > &operands,
+                           std::size_t advice_offset );
+    };
+
+    // Each shard is freed as soon as it is linked.
+    circuit_owner_t link( std::vector< circuit_owner_t > &&shards );
+
+} // namespace circ
@@ -37,6 +37,8 @@ CIRCUITOUS_UNRELAX_WARNINGS
 namespace circ
 {
 
+    // Runs a fixed function pipeline (simplifycfg, sroa, early-cse) over `fns`, the
+    // pipeline is built once per thread.
     void optimize_silently(llvm::Module *module,
                            const std::vector<llvm::Function *> &fns);
 
@@ -51,6 +53,13 @@ namespace circ
         return optimize_silently( lmodule, fns );
     }
 
+    // Time spent in each pass of `optimize_silently` is collected (across all threads)
+    // once enabled.
+    void enable_pass_timing( bool enabled = true );
+
+    // Table of passes with number of runs and total time, sorted by the time.
+    std::string pass_timing_report();
+
     // Flatten all control flow into pure data-flow inside of a function.
     // TODO(lukas): Write down what are guarantees w.r.t. to metadata.
     void flatten_cfg(llvm::Function *func, const remill::IntrinsicTable &intrinsics);
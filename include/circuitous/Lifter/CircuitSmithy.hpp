@@ -8,6 +8,8 @@
 #include <circuitous/Lifter/Instruction.hpp>
 #include <circuitous/Util/InstructionBytes.hpp>
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -66,12 +68,43 @@ namespace circ
         using worklist_t = Worklist< unit_t >;
 
 
+        // Configures a fresh producer, called once per each producer when lifting
+        // in parallel.
+        using producer_setup_t = std::function< void( exalt::circuit_producer & ) >;
+
+        // Number of threads fuzzing operands and lifting the worklist (`v3` always
+        // lifts serially).
+        std::size_t workers = 1;
+
         using owns_context::owns_context;
 
+        self_t &parallel( std::size_t count )
+        {
+            workers = ( count == 0 ) ? 1 : count;
+            return *this;
+        }
+
+        // Post-processed semantic functions are loaded from (and stored to) `cache`,
+        // `nullptr` disables caching.
+        self_t &cache_semantics( std::shared_ptr< isem::semantics_cache > cache )
+        {
+            ctx._isem_cache = std::move( cache );
+            return *this;
+        }
+
       private:
 
         worklist_t categorize( atoms_t atoms );
 
+        void log_cache_stats();
+
+        // Each worker lifts a partition of the worklist with its own `Ctx`, partial
+        // circuits are then merged into `producer` in the order of partitions.
+        // Operand selectors are merged as well, so the result matches the serial build.
+        void exalt_parallel( exalt::circuit_producer &producer,
+                             const producer_setup_t &setup,
+                             worklist_t &&worklist );
+
       public:
 
         auto purify( const std::vector< InstBytes > &insts ) -> concretes_t;
@@ -85,7 +118,7 @@ namespace circ
         auto forge_mux_heavy( concretes_t &&concretes ) -> circuit_ptr_t;
         auto forge_v3( concretes_t &&concretes ) -> circuit_ptr_t;
 
-        auto forge_common( exalt::circuit_producer &producer,
+        auto forge_common( const producer_setup_t &setup,
                            atoms_t &&atoms ) -> circuit_ptr_t;
 
         template< typename R >
@@ -7,6 +7,7 @@
 #include <map>
 #include <memory>
 
+#include <circuitous/Lifter/Semantics.hpp>
 #include <circuitous/Lifter/Shadows.hpp>
 #include <circuitous/Support/Check.hpp>
 
@@ -29,6 +30,11 @@ namespace remill {
   class Operand;
 }
 
+namespace circ::isem
+{
+    struct semantics_cache;
+} // namespace circ::isem
+
 namespace circ
 {
     using isel_t = std::string;
@@ -58,11 +64,23 @@ namespace circ
 
         uint32_t ptr_size = 0;
 
+        // Kept to be able to build another instance for the same target.
+        std::string _os_name;
+        std::string _arch_name;
+
+        // Optional, shared by all instances lifting the same circuit.
+        std::shared_ptr< isem::semantics_cache > _isem_cache;
+
         auto llvm_ctx() { return _llvm_context.get(); }
         auto arch() { return _arch.get(); }
         auto module() { return _module.get(); }
         auto &regs() { return _regs; }
 
+        const std::string &os_name() const { return _os_name; }
+        const std::string &arch_name() const { return _arch_name; }
+
+        auto isem_cache() { return _isem_cache.get(); }
+
         auto ir() { return llvm::IRBuilder<>{ *llvm_ctx() }; }
 
         // TOOD(lifter): Probably no longer needed with opaque pointers?
@@ -137,6 +155,13 @@ namespace circ
                 gv->replaceAllUsesWith( llvm::UndefValue::get( gv->getType() ) );
                 gv->eraseFromParent();
             }
+
+            // Semantics are loaded lazily, what is left is materialized already and
+            // this only detaches the module from the bitcode, so it can be verified
+            // and written.
+            if ( auto err = module()->materializeAll() )
+                log_kill() << "Cannot materialize semantics:"
+                           << llvm::toString( std::move( err ) );
         }
 
         reg_ptr_t pc_reg()
@@ -191,8 +216,10 @@ namespace circ
 
         Ctx(const std::string &os_name, const std::string &arch_name)
             : _arch(make_arch(_llvm_context.get(), os_name, arch_name)),
-              _module(remill::LoadArchSemantics(arch())),
-              ptr_size(_arch->address_size)
+              _module(isem::load_semantics(*arch())),
+              ptr_size(_arch->address_size),
+              _os_name(os_name),
+              _arch_name(arch_name)
         {
           std::stringstream dbg;
           _arch->ForEachRegister([&](reg_ptr_t reg_) {
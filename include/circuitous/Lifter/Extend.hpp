@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <circuitous/IR/Circuit.hpp>
+#include <circuitous/Lifter/CircuitSmithy.hpp>
+#include <circuitous/Support/Ciff.hpp>
+
+#include <cstddef>
+#include <unordered_set>
+
+// Incremental lifting: an existing circuit is extended by new encodings without lifting
+// again the ones it was lifted from. Which encodings (and isels) those were is recorded
+// in its coverage - a CIFF file written alongside of the circuit.
+namespace circ
+{
+    struct extension_plan
+    {
+        // New encodings together with all covered encodings of isels they extend (units
+        // are lifted whole, otherwise two contexts of one isel could overlap).
+        CircuitSmithy::concretes_t to_lift;
+        // Contexts of the base circuit that are replaced by the lifted ones.
+        std::unordered_set< Operation * > stale;
+        // Coverage of the extended circuit.
+        CIF coverage;
+
+        // Encodings already listed in the coverage.
+        std::size_t known = 0;
+        // Encodings not listed, but accepted by a decoder of the base circuit.
+        std::size_t accepted = 0;
+        std::size_t fresh = 0;
+        // Isels of the base circuit that are lifted again.
+        std::size_t changed_isels = 0;
+
+        bool needs_lift() const { return !to_lift.empty(); }
+    };
+
+    // Decides what has to be lifted so that `base` (lifted from `covered`) also handles
+    // `concretes`. `smithy` only decodes covered encodings of changed isels.
+    extension_plan plan_extension( CircuitSmithy &smithy, Circuit *base, const CIF &covered,
+                                   CircuitSmithy::concretes_t &&concretes );
+
+    // Drops stale contexts of `base` and links contexts of `delta` (lifted from
+    // `plan.to_lift`) into it. Operand selectors, decoders and semantics equal
+    // in both are shared.
+    circuit_owner_t splice( circuit_owner_t &&base, const extension_plan &plan,
+                            circuit_owner_t &&delta );
+
+} // namespace circ
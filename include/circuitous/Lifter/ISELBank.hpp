@@ -36,11 +36,12 @@ namespace circ::isem
 {
     using insts_t = std::vector< llvm::Instruction * >;
 
-    // Linear wrt number of functions in module.
+    // Linear wrt number of functions in module. Only materialized semantics are yielded.
     auto semantic_fns( llvm::Module &in )
         -> gap::generator< llvm::Function * >;
 
-    // Linear wrt number of functions in module.
+    // Constant wrt number of functions in module, materializes the semantic function
+    // if semantics are loaded lazily.
     auto semantic_fn( const std::string &isel_name, llvm::Module &in )
         -> std::optional< llvm::Function * >;
 
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <circuitous/Util/Warnings.hpp>
+
+CIRCUITOUS_RELAX_WARNINGS
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalValue.h>
+#include <llvm/IR/Module.h>
+CIRCUITOUS_UNRELAX_WARNINGS
+
+#include <memory>
+#include <vector>
+
+namespace remill
+{
+    class Arch;
+} // namespace remill
+
+namespace circ::isem
+{
+    // Semantics module of `arch` with bodies of functions left in the bitcode.
+    //
+    // Globals (including the `ISEL_` table) and function declarations are read eagerly,
+    // a function body is deserialized only once `materialize` is called on it or on
+    // a function that refers to it. Remill helpers (`__remill*`) are materialized right
+    // away, as arch expects to be able to clone some of them.
+    //
+    // Operations over the whole module (verification, writing bitcode) require
+    // the module to be fully materialized, see `Ctx::clean_module`.
+    std::unique_ptr< llvm::Module > load_semantics( const remill::Arch &arch );
+
+    // Materializes `fn` and everything it transitively refers to and marks materialized
+    // functions as semantics. No-op for already materialized functions.
+    void materialize( llvm::Function &fn );
+
+    // Globals `root` refers to, including through constant expressions.
+    std::vector< llvm::GlobalValue * > referenced_globals( llvm::GlobalValue &root );
+
+} // namespace circ::isem
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <circuitous/Lifter/Context.hpp>
+
+CIRCUITOUS_RELAX_WARNINGS
+#include <llvm/IR/Function.h>
+CIRCUITOUS_UNRELAX_WARNINGS
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace circ::isem
+{
+    // On-disk cache of semantic functions already processed by `post_lift`.
+    //
+    // Entries are bitcode modules with a single definition (everything else the function
+    // refers to is only declared) named after the hash of everything the result of
+    // `post_lift` depends on: printed IR of the semantic function and of all globals it
+    // transitively refers to, target, llvm version and lifter configuration. Entries
+    // therefore never need to be invalidated and the cache can be shared by concurrent
+    // processes (entries are written to a temporary file first and then renamed).
+    //
+    // Semantic functions that call other functions with local linkage cannot be linked
+    // back and are always processed.
+    struct semantics_cache
+    {
+        static constexpr inline const char *cached_fn_name = "__circ.isem_cached";
+        static constexpr inline const char *processed_md = "circuitous.isem.post_lifted";
+
+        struct stats_t
+        {
+            std::uint64_t hits = 0;
+            std::uint64_t misses = 0;
+            std::uint64_t uncacheable = 0;
+        };
+
+      private:
+        std::filesystem::path dir;
+        std::string config;
+
+        std::atomic< std::uint64_t > hits = 0;
+        std::atomic< std::uint64_t > misses = 0;
+        std::atomic< std::uint64_t > uncacheable = 0;
+
+      public:
+        // `config` should describe every option of the lifter that can change the result.
+        semantics_cache( std::filesystem::path dir, std::string config );
+
+        semantics_cache( const semantics_cache & ) = delete;
+        semantics_cache &operator=( const semantics_cache & ) = delete;
+
+        // `$XDG_CACHE_HOME/circuitous/isem` or `~/.cache/circuitous/isem`.
+        static std::filesystem::path default_dir();
+
+        // Replaces body of `fn` with a cached one, or runs `post_lift` and stores
+        // the result. Use `isem::post_lift` instead, which also handles functions
+        // already processed in this module.
+        void post_lift( Ctx &ctx, const std::string &isel, llvm::Function &fn );
+
+        stats_t stats() const { return { hits.load(), misses.load(), uncacheable.load() }; }
+
+        const std::filesystem::path &path() const { return dir; }
+
+      private:
+        std::string key( Ctx &ctx, const std::string &isel, llvm::Function &fn ) const;
+
+        bool load( Ctx &ctx, llvm::Function &fn, const std::filesystem::path &file );
+        bool store( llvm::Function &fn, const std::filesystem::path &file );
+    };
+
+    // Runs `post_lift` on a semantic function, through the cache of `ctx` if it has one.
+    // Functions already processed in this module are left as they are. Debug info is
+    // stripped, so the result is the same with and without the cache.
+    void post_lift( Ctx &ctx, const std::string &isel, llvm::Function &fn );
+
+} // namespace circ::isem
@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2022 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <circuitous/Run/Execute.hpp>
+#include <circuitous/Run/ResultWriter.hpp>
+#include <circuitous/Run/StepCache.hpp>
+#include <circuitous/Run/Trace.hpp>
+
+#include <circuitous/Support/Check.hpp>
+#include <circuitous/Support/Log.hpp>
+#include <circuitous/Util/Parallel.hpp>
+#include <circuitous/Util/Warnings.hpp>
+
+CIRCUITOUS_RELAX_WARNINGS
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+CIRCUITOUS_UNRELAX_WARNINGS
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// Verification of many traces against one circuit in a single process - the circuit
+// is loaded (and verified) once and traces are scheduled across a pool of workers.
+namespace circ::run
+{
+    namespace detail
+    {
+        static inline std::vector< std::string > read_paths( std::istream &in,
+                                                             const std::filesystem::path &base )
+        {
+            std::vector< std::string > out;
+            for ( std::string line; std::getline( in, line ); )
+            {
+                auto trimmed = llvm::StringRef( line ).trim();
+                if ( trimmed.empty() || trimmed.startswith( "#" ) )
+                    continue;
+
+                auto path = std::filesystem::path( trimmed.str() );
+                out.push_back( ( path.is_relative() ) ? ( base / path ).string()
+                                                      : path.string() );
+            }
+            return out;
+        }
+    } // namespace detail
+
+    // `source` is one of:
+    //  * `-`: paths are read from stdin, one per line.
+    //  * directory: all `.json` and `.jsonl` files in it (not recursive), ordered by name.
+    //  * anything else is a manifest file with one path per line; relative paths are
+    //    relative to the directory of the manifest.
+    // Empty lines and lines starting with `#` are ignored in both manifest and stdin.
+    static inline std::vector< std::string > collect_traces( const std::string &source )
+    {
+        namespace fs = std::filesystem;
+
+        if ( source == "-" )
+            return detail::read_paths( std::cin, fs::path() );
+
+        if ( fs::is_directory( source ) )
+        {
+            std::vector< std::string > out;
+            for ( const auto &entry : fs::directory_iterator( source ) )
+            {
+                auto ext = entry.path().extension();
+                if ( entry.is_regular_file() && ( ext == ".json" || ext == ".jsonl" ) )
+                    out.push_back( entry.path().string() );
+            }
+            std::sort( out.begin(), out.end() );
+            return out;
+        }
+
+        std::ifstream manifest( source );
+        check( manifest ) << "[run:batch]: Cannot open manifest:" << source;
+        return detail::read_paths( manifest, fs::path( source ).parent_path() );
+    }
+
+    struct batch_config
+    {
+        std::size_t workers = hardware_threads();
+        // Per-trace results are stored here.
+        std::string output_dir;
+        // See `with_result_writer`.
+        std::string format = "json";
+        // Shared by all traces, optional.
+        step_cache *cache = nullptr;
+    };
+
+    struct batch_entry
+    {
+        std::string trace;
+        std::string output;
+
+        result_t result = result_t::unreachable;
+        std::size_t steps = 0;
+        double ms = 0;
+
+        // Set if the trace could not be verified - it (or its output) could not be opened
+        // or it is malformed. Such entry counts as an error.
+        std::string error;
+    };
+
+    struct batch_summary
+    {
+        std::vector< batch_entry > entries;
+        std::size_t workers = 0;
+        double wall_ms = 0;
+
+        std::size_t count( auto &&pred ) const
+        {
+            return static_cast< std::size_t >( std::count_if(
+                    entries.begin(), entries.end(),
+                    [ & ]( const auto &e ) { return pred( e.result ); } ) );
+        }
+
+        std::size_t accepted() const { return count( run::accepted ); }
+        std::size_t rejected() const { return count( run::rejected ); }
+        std::size_t errors() const { return entries.size() - accepted() - rejected(); }
+
+        void write( llvm::raw_ostream &os ) const
+        {
+            llvm::json::OStream j( os, 2 );
+            j.object( [ & ]
+            {
+                j.attribute( "total", static_cast< int64_t >( entries.size() ) );
+                j.attribute( "accepted", static_cast< int64_t >( accepted() ) );
+                j.attribute( "rejected", static_cast< int64_t >( rejected() ) );
+                j.attribute( "errors", static_cast< int64_t >( errors() ) );
+                j.attribute( "workers", static_cast< int64_t >( workers ) );
+                j.attribute( "wall_ms", wall_ms );
+                j.attributeArray( "traces", [ & ]
+                {
+                    for ( const auto &entry : entries )
+                        j.object( [ & ]
+                        {
+                            j.attribute( "trace", entry.trace );
+                            j.attribute( "output", entry.output );
+                            j.attribute( "result", export_result( entry.result ) );
+                            j.attribute( "status", to_string( entry.result ) );
+                            j.attribute( "steps", static_cast< int64_t >( entry.steps ) );
+                            j.attribute( "ms", entry.ms );
+                            if ( !entry.error.empty() )
+                                j.attribute( "error", entry.error );
+                        } );
+                } );
+            } );
+            os << "\n";
+        }
+
+        // Writes the summary as `summary.json` into `dir` and returns its path.
+        std::string store( const std::string &dir ) const
+        {
+            auto path = ( std::filesystem::path( dir ) / "summary.json" ).string();
+            std::error_code ec;
+            llvm::raw_fd_ostream os( path, ec, llvm::sys::fs::OF_Text );
+            check( !ec ) << "[run:batch]: Cannot open" << path << ":" << ec.message();
+            write( os );
+            return path;
+        }
+    };
+
+    struct batch_verifier
+    {
+        using clock = std::chrono::steady_clock;
+
+        circuit_ref_t circuit;
+        batch_config config;
+
+        batch_verifier( circuit_ref_t circuit, batch_config config_ )
+            : circuit( circuit ), config( std::move( config_ ) )
+        {
+            config.workers = std::max< std::size_t >( config.workers, 1 );
+        }
+
+        batch_summary run( const std::vector< std::string > &traces )
+        {
+            std::filesystem::create_directories( config.output_dir );
+
+            batch_summary out;
+            out.workers = std::min( config.workers, traces.size() );
+            out.entries = plan( traces );
+
+            auto start = clock::now();
+            std::atomic< std::size_t > next = 0;
+            {
+                std::vector< std::jthread > workers;
+                for ( std::size_t i = 0; i < out.workers; ++i )
+                    workers.emplace_back( [ & ]
+                    {
+                        for ( auto idx = next++; idx < out.entries.size(); idx = next++ )
+                            verify( out.entries[ idx ] );
+                    } );
+            }
+            out.wall_ms = elapsed_ms( start );
+            return out;
+        }
+
+      private:
+
+        static double elapsed_ms( clock::time_point since )
+        {
+            using ms = std::chrono::duration< double, std::milli >;
+            return std::chrono::duration_cast< ms >( clock::now() - since ).count();
+        }
+
+        std::string extension() const
+        {
+            if ( config.format == "jsonl" )
+                return ".jsonl";
+            if ( binary_result_format( config.format ) )
+                return ".bin";
+            return ".json";
+        }
+
+        // Output names are derived from trace names, duplicates get index of the trace.
+        std::vector< batch_entry > plan( const std::vector< std::string > &traces ) const
+        {
+            std::vector< batch_entry > out;
+            std::unordered_set< std::string > taken;
+            for ( std::size_t i = 0; i < traces.size(); ++i )
+            {
+                auto name = std::filesystem::path( traces[ i ] ).stem().string();
+                if ( !taken.insert( name ).second )
+                    name += "." + std::to_string( i );
+
+                auto output = std::filesystem::path( config.output_dir ) /
+                              ( name + ".result" + extension() );
+                out.push_back( { traces[ i ], output.string() } );
+            }
+            return out;
+        }
+
+        // Problems with a single trace are recorded in its entry, so the rest of
+        // the batch is still verified.
+        void verify( batch_entry &entry )
+        {
+            auto start = clock::now();
+            auto fail = [ & ]( std::string error )
+            {
+                entry.result = result_t::runtime_error;
+                entry.error = std::move( error );
+                entry.ms = elapsed_ms( start );
+                log_error() << "[run:batch]:" << entry.trace << ":" << entry.error;
+            };
+
+            std::string error;
+            auto reader = trace::native::EntryReader::open( entry.trace, error );
+            if ( !reader )
+                return fail( std::move( error ) );
+
+            auto flags = ( binary_result_format( config.format ) ) ? llvm::sys::fs::OF_None
+                                                                   : llvm::sys::fs::OF_Text;
+            std::error_code ec;
+            llvm::raw_fd_ostream os( entry.output, ec, flags );
+            if ( ec )
+                return fail( "Cannot open " + entry.output + ": " + ec.message() );
+
+            with_result_writer( config.format, os, [ & ]( auto &writer )
+            {
+                verify( *reader, writer, entry );
+            } );
+
+            entry.ms = elapsed_ms( start );
+            if ( !entry.error.empty() )
+                log_error() << "[run:batch]:" << entry.trace << ":" << entry.error;
+            else
+                log_dbg() << "[run:batch]:" << entry.trace << "->" << to_string( entry.result )
+                          << "in" << entry.ms << "ms";
+        }
+
+        // Same semantics as `StatelessControl::stream_outcomes`, but entries are read
+        // one at a time. Reading stops at the first malformed entry, steps verified
+        // before it are still written.
+        void verify( trace::native::EntryReader &reader, auto &writer, batch_entry &entry )
+        {
+            bool failed = false;
+            auto current = reader.try_next( entry.error );
+            while ( current )
+            {
+                auto next = reader.try_next( entry.error );
+                if ( !next )
+                    break;
+
+                step_outcome outcome{ result_t::unreachable, {} };
+                if ( !failed )
+                {
+                    auto step = trace::native::make_step_trace( circuit, *current, *next );
+                    outcome = StatelessControl<>().outcome_of( circuit, step, config.cache );
+                    failed = !accepted( outcome.status );
+                }
+
+                entry.result = outcome.status;
+                writer.step( { entry.steps++, outcome.status,
+                               std::move( outcome.memory_hints ) } );
+                current = std::move( next );
+            }
+
+            if ( !entry.error.empty() )
+                entry.result = result_t::runtime_error;
+            else if ( entry.steps == 0 )
+                log_error() << "[run:batch]:" << entry.trace
+                            << "has less than two entries, nothing to verify.";
+            writer.finish( entry.result, entry.steps );
+        }
+    };
+
+    static inline batch_summary verify_batch( circuit_ref_t circuit,
+                                              const std::vector< std::string > &traces,
+                                              batch_config config )
+    {
+        return batch_verifier( circuit, std::move( config ) ).run( traces );
+    }
+
+} // namespace circ::run
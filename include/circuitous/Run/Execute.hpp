@@ -5,6 +5,7 @@
 #pragma once
 
 #include <circuitous/Run/Interpreter.hpp>
+#include <circuitous/Run/StepCache.hpp>
 #include <circuitous/Run/Trace.hpp>
 #include <circuitous/Support/Check.hpp>
 
@@ -195,6 +196,34 @@ namespace circ::run
             return result_spawn_pairs;
         }
 
+        // Same as `run_step`, but only the outcome is kept - which means `cache` (if
+        // present) can answer instead of running the interpreter.
+        auto outcome_of( circuit_ref_t circuit, const auto &step, step_cache *cache = nullptr )
+            -> step_outcome
+        {
+            auto compute = [ & ]
+            {
+                step_outcome out{ result_t::unreachable, {} };
+                auto collect = [ & ]( const auto &result_spawn_pairs )
+                {
+                    for ( auto &[ status, spawn ] : result_spawn_pairs )
+                    {
+                        if ( accepted( status ) )
+                        {
+                            out.memory_hints = spawn->get_derived_mem();
+                            return;
+                        }
+                    }
+                };
+                out.status = process_results( run_step( circuit, step, collect ) );
+                return out;
+            };
+
+            if ( !cache )
+                return compute();
+            return cache->get_or_compute( step, compute );
+        }
+
         auto test( circuit_ref_t circuit, auto trace, auto &&yield ) -> statuses_t
         {
             check( trace.entries.size() >= 2 );
@@ -213,6 +242,44 @@ namespace circ::run
             }
             return statuses;
         }
+
+        // Counterpart of `test` that reports outcomes instead of yielding spawns - each
+        // one is passed to `yield( idx, outcome )` as soon as it is known. Returns status
+        // of the last step.
+        auto stream_outcomes( circuit_ref_t circuit, const auto &trace, step_cache *cache,
+                              auto &&yield ) -> result_t
+        {
+            check( trace.entries.size() >= 2 );
+
+            auto last = result_t::unreachable;
+            bool failed = false;
+            for ( std::size_t i = 0; i < trace.size() - 1; ++i )
+            {
+                step_outcome outcome{ result_t::unreachable, {} };
+                if ( !failed )
+                {
+                    auto step = trace::native::make_step_trace( circuit, trace[ i ],
+                                                                trace[ i + 1 ] );
+                    outcome = outcome_of( circuit, step, cache );
+                    failed = !accepted( outcome.status );
+                }
+
+                last = outcome.status;
+                yield( i, std::move( outcome ) );
+            }
+            return last;
+        }
+
+        auto test_outcomes( circuit_ref_t circuit, const auto &trace,
+                            step_cache *cache = nullptr ) -> std::vector< step_outcome >
+        {
+            std::vector< step_outcome > outcomes;
+            stream_outcomes( circuit, trace, cache, [ & ]( std::size_t, auto &&outcome )
+            {
+                outcomes.push_back( std::move( outcome ) );
+            } );
+            return outcomes;
+        }
     };
 
 
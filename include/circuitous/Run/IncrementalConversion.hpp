@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2022 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <circuitous/Run/TraceConversion.hpp>
+
+#include <circuitous/Support/Ciff.hpp>
+#include <circuitous/Support/Check.hpp>
+#include <circuitous/Support/Log.hpp>
+#include <circuitous/Util/Parallel.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+// Incremental trace conversion: instead of lifting every instruction of the trace, an
+// existing circuit is reused for instructions it was lifted from (its coverage) and
+// only the newly seen encodings are lifted into a (usually tiny) delta circuit.
+// Each step is then converted by the circuit that covers its instruction.
+namespace circ::run::trace
+{
+    // Encodings (raw bytes) of instructions some circuit was lifted from.
+    struct coverage_t
+    {
+        std::unordered_set< std::string > encodings;
+
+        static coverage_t from_ciff( const std::string &path )
+        {
+            std::ifstream probe( path );
+            check( probe ) << "[run::trace]:" << "Cannot open coverage file:" << path;
+
+            coverage_t out;
+            for ( auto &bytes : CIFFReader().read( path ).take_bytes() )
+                out.encodings.insert( std::move( bytes.data ) );
+            return out;
+        }
+
+        bool covers( const remill::Instruction &inst ) const
+        {
+            return encodings.count( inst.bytes );
+        }
+
+        std::size_t size() const { return encodings.size(); }
+    };
+
+    // Which circuit converts which step.
+    struct delta_plan
+    {
+        // Instructions not covered by the base circuit, each encoding once.
+        std::vector< remill::Instruction > fresh;
+        // `in_delta[ i ]` is set if instruction of entry `i` is not covered.
+        std::vector< bool > in_delta;
+
+        bool needs_delta() const { return !fresh.empty(); }
+    };
+
+    struct incremental_loader : loader_base
+    {
+        using loader_base::loader_base;
+
+        // One decoded instruction per trace entry, in order.
+        std::vector< remill::Instruction > seen;
+
+        auto parse_alien_trace( const std::string &source_file )
+        {
+            return loader_base::parse_alien_trace( source_file,
+                                                   capturing_size_decoder, seen );
+        }
+
+        delta_plan plan( const coverage_t &coverage ) const
+        {
+            delta_plan out;
+            std::unordered_set< std::string > queued;
+            for ( const auto &inst : seen )
+            {
+                auto fresh = !coverage.covers( inst );
+                out.in_delta.push_back( fresh );
+                if ( fresh && queued.insert( inst.bytes ).second )
+                    out.fresh.push_back( inst );
+            }
+            return out;
+        }
+
+        // Lifts only instructions of `plan.fresh`, `nullptr` if there are none.
+        circuit_owner_t reconstruct_delta( const delta_plan &plan ) &&
+        {
+            if ( !plan.needs_delta() )
+                return {};
+
+            log_info() << "[run::trace]:" << "Lifting" << plan.fresh.size()
+                                          << "new encodings into delta circuit.";
+            auto k = lifter_kind::disjunctions;
+            return CircuitSmithy( std::move( ctx ) ).make( k, plan.fresh );
+        }
+    };
+
+    struct incremental_config
+    {
+        std::size_t workers = hardware_threads();
+        // Number of consecutive steps a worker claims at once.
+        std::size_t batch = 64;
+    };
+
+    // Converts steps in parallel batches; each step is run on `base` or `delta` depending
+    // on the plan. Exported entries use the union of fields of both circuits (ordered by
+    // name, same as `circ::Trace::make` would order them for a circuit that has leaves of
+    // both) - if there is no delta, this is exactly the layout of `base`.
+    struct incremental_converter
+    {
+        using self_t = incremental_converter;
+        using exported_t = std::tuple< std::string, std::string >;
+
+        // [ from, size, to ] - copy `size` bits from `from` in circuit layout to `to`.
+        using remap_t = std::vector< std::tuple< uint32_t, uint32_t, uint32_t > >;
+
+        static inline constexpr auto no_failure = std::numeric_limits< std::size_t >::max();
+
+        circuit_ref_t base;
+        circuit_ref_t delta;
+        incremental_config config;
+
+        std::map< std::string, std::tuple< uint32_t, uint32_t > > layout;
+        uint32_t total_size = 0;
+
+        std::vector< std::string > to_export;
+        bool failure = false;
+
+        incremental_converter( circuit_ref_t base, circuit_ref_t delta,
+                               incremental_config config = {} )
+            : base( base ), delta( delta ), config( config )
+        {
+            check( base ) << "[run::trace]:" << "Incremental conversion requires base circuit.";
+            this->config.workers = std::max< std::size_t >( this->config.workers, 1 );
+            this->config.batch = std::max< std::size_t >( this->config.batch, 1 );
+
+            std::map< std::string, uint32_t > sizes;
+            auto add_fields = [ & ]( circuit_ref_t circuit )
+            {
+                for ( const auto &[ _, size, name ] : circ::Trace::make( circuit ).storage )
+                {
+                    auto [ it, inserted ] = sizes.emplace( name, size );
+                    check( inserted || it->second == size )
+                        << "[run::trace]:" << "Field" << name
+                        << "has different sizes in base and delta circuit.";
+                }
+            };
+
+            add_fields( base );
+            if ( delta )
+                add_fields( delta );
+
+            for ( const auto &[ name, size ] : sizes )
+            {
+                layout[ name ] = { total_size, size };
+                total_size += size;
+            }
+        }
+
+        auto convert_trace( const native::Trace &traces, const delta_plan &plan ) -> self_t &
+        {
+            check( traces.size() >= 2 );
+            check( plan.in_delta.size() == traces.size() )
+                << "[run::trace]:" << "Plan does not match the trace.";
+            check( delta || !plan.needs_delta() )
+                << "[run::trace]:" << "Plan requires delta circuit, but none was given.";
+
+            auto steps = traces.size() - 1;
+            auto base_remap = make_remap( base );
+            auto delta_remap = ( delta ) ? make_remap( delta ) : remap_t{};
+
+            std::vector< std::optional< exported_t > > converted( steps );
+            std::atomic< std::size_t > next_batch = 0;
+            std::atomic< std::size_t > first_failure = no_failure;
+
+            auto convert_step = [ & ]( std::size_t i )
+            {
+                // not structured bindings, Clang before 16 cannot capture them in `collect`
+                auto &circuit = ( plan.in_delta[ i ] ) ? delta : base;
+                auto &remap = ( plan.in_delta[ i ] ) ? delta_remap : base_remap;
+
+                auto collect = [ & ]( const auto &result_spawn_pairs )
+                {
+                    for ( auto &[ status, spawn ] : result_spawn_pairs )
+                        if ( accepted( status ) )
+                        {
+                            auto [ current, next ] = spawn->to_traces();
+                            converted[ i ] = { apply( remap, current ),
+                                               apply( remap, next ) };
+                            return;
+                        }
+                };
+
+                auto step = native::make_step_trace( circuit, traces[ i ], traces[ i + 1 ] );
+                StatelessControl().run_step( circuit, step, collect );
+                if ( converted[ i ] )
+                    return;
+
+                auto seen = first_failure.load();
+                while ( i < seen && !first_failure.compare_exchange_weak( seen, i ) )
+                {}
+            };
+
+            auto worker = [ & ]
+            {
+                for ( ;; )
+                {
+                    auto from = ( next_batch++ ) * config.batch;
+                    if ( from >= steps || from > first_failure )
+                        return;
+
+                    auto to = std::min( from + config.batch, steps );
+                    for ( auto i = from; i < to && i < first_failure; ++i )
+                        convert_step( i );
+                }
+            };
+
+            log_dbg() << "[run::trace]:" << "Converting" << steps << "steps using"
+                                         << config.workers << "workers.";
+            {
+                std::vector< std::jthread > workers;
+                for ( std::size_t i = 0; i < config.workers; ++i )
+                    workers.emplace_back( worker );
+            }
+
+            for ( std::size_t i = 0; i < steps; ++i )
+            {
+                if ( !converted[ i ] )
+                {
+                    log_info() << "[run::trace]:" << "No spawn was successful in step" << i;
+                    failure = true;
+                    break;
+                }
+
+                auto &[ current, next ] = *converted[ i ];
+                if ( to_export.empty() )
+                    to_export.push_back( std::move( current ) );
+                to_export.push_back( std::move( next ) );
+            }
+
+            log_info() << "[run::trace]:" << "Conversion done.";
+            return *this;
+        }
+
+        auto dump( const std::string &path ) -> self_t &
+        {
+            std::ofstream ofile( path );
+            check( ofile );
+            ofile << *this;
+
+            return *this;
+        }
+
+        template< typename stream >
+        friend stream &operator<<( stream &out, const self_t &self )
+        {
+            for ( const auto &entry : self.to_export )
+                out << entry << "\n";
+            return out;
+        }
+
+      private:
+
+        remap_t make_remap( circuit_ref_t circuit ) const
+        {
+            remap_t out;
+            for ( const auto &[ from, size, name ] : circ::Trace::make( circuit ).storage )
+            {
+                auto [ to, _ ] = layout.at( name );
+                out.emplace_back( from, size, to );
+            }
+            return out;
+        }
+
+        std::string apply( const remap_t &remap, const std::string &entry ) const
+        {
+            std::string out( total_size, '0' );
+            for ( const auto &[ from, size, to ] : remap )
+                out.replace( to, size, entry, from, size );
+            return out;
+        }
+    };
+
+} // namespace circ::run::trace
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2022 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <circuitous/Run/Execute.hpp>
+#include <circuitous/Run/ResultWriter.hpp>
+#include <circuitous/Run/Trace.hpp>
+
+#include <circuitous/Support/Check.hpp>
+#include <circuitous/Util/Parallel.hpp>
+
+#include <atomic>
+#include <limits>
+#include <map>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+namespace circ::run
+{
+    struct pipeline_config
+    {
+        // Number of verifier threads.
+        std::size_t workers = hardware_threads();
+        // Maximum number of steps that were read but are not written yet. This is what
+        // keeps the memory flat regardless of the trace length.
+        std::size_t window = 256;
+        // Shared by all verifiers, optional.
+        step_cache *cache = nullptr;
+    };
+
+    // Streaming counterpart of `StatelessControl::test`:
+    //   reader -> [ jobs ] -> verifiers ( `config.workers` threads ) -> [ done ] -> writer
+    // Writer runs on the calling thread and emits steps in trace order as soon as all
+    // previous steps are emitted. Same as `StatelessControl`, every step after the first
+    // one that was not accepted is reported as `unreachable` - verifiers skip those if
+    // they already know about the failure.
+    template< typename Writer >
+    struct verify_pipeline
+    {
+        using entry_t = trace::native::Trace::Entry;
+
+        struct job_t
+        {
+            std::size_t idx;
+            entry_t current;
+            entry_t next;
+        };
+
+        static inline constexpr auto no_failure = std::numeric_limits< std::size_t >::max();
+
+      private:
+        circuit_ref_t circuit;
+        Writer &writer;
+        pipeline_config config;
+
+        bounded_queue< job_t > jobs;
+        bounded_queue< step_result > done;
+
+        // Each step holds one slot from the moment it is read until it is written.
+        std::counting_semaphore<> in_flight;
+        std::atomic< std::size_t > first_failure = no_failure;
+
+      public:
+        verify_pipeline( circuit_ref_t circuit, Writer &writer, pipeline_config config_ )
+            : circuit( circuit ), writer( writer ), config( config_ ),
+              jobs( config.window ), done( config.window ),
+              in_flight( static_cast< std::ptrdiff_t >( std::max< std::size_t >(
+                              config.window, 1 ) ) )
+        {
+            config.workers = std::max< std::size_t >( config.workers, 1 );
+        }
+
+        // Returns status of the last step.
+        result_t run( trace::native::EntryReader reader )
+        {
+            std::jthread reader_thread( [ & ] { read( reader ); } );
+
+            std::atomic< std::size_t > running = config.workers;
+            std::vector< std::jthread > verifiers;
+            for ( std::size_t i = 0; i < config.workers; ++i )
+            {
+                verifiers.emplace_back( [ & ]
+                {
+                    while ( auto job = jobs.pop() )
+                        done.push( verify( *job ) );
+                    if ( --running == 0 )
+                        done.close();
+                } );
+            }
+
+            return write();
+        }
+
+      private:
+
+        void read( trace::native::EntryReader &reader )
+        {
+            std::size_t idx = 0;
+            auto current = reader.next();
+            while ( current )
+            {
+                auto next = reader.next();
+                if ( !next )
+                    break;
+
+                in_flight.acquire();
+                jobs.push( { idx++, std::move( *current ), *next } );
+                current = std::move( next );
+            }
+            jobs.close();
+        }
+
+        step_result verify( const job_t &job )
+        {
+            step_result out{ job.idx, result_t::unreachable, {} };
+            if ( job.idx > first_failure )
+                return out;
+
+            auto step = trace::native::make_step_trace( circuit, job.current, job.next );
+            auto outcome = StatelessControl<>().outcome_of( circuit, step, config.cache );
+            out.status = outcome.status;
+            out.memory_hints = std::move( outcome.memory_hints );
+
+            if ( !accepted( out.status ) )
+            {
+                auto seen = first_failure.load();
+                while ( job.idx < seen && !first_failure.compare_exchange_weak( seen, job.idx ) )
+                {}
+            }
+            return out;
+        }
+
+        result_t write()
+        {
+            // Steps that are done, but some of their predecessors are not.
+            std::map< std::size_t, step_result > pending;
+            std::size_t next = 0;
+            bool failed = false;
+            auto last = result_t::unreachable;
+
+            while ( auto res = done.pop() )
+            {
+                pending.emplace( res->idx, std::move( *res ) );
+                for ( auto it = pending.begin(); it != pending.end() && it->first == next;
+                      it = pending.erase( it ), ++next )
+                {
+                    auto &step = it->second;
+                    if ( failed )
+                    {
+                        step.status = result_t::unreachable;
+                        step.memory_hints.clear();
+                    }
+                    failed |= !accepted( step.status );
+
+                    writer.step( step );
+                    last = step.status;
+                    in_flight.release();
+                }
+            }
+
+            check( pending.empty() ) << "[run:pipeline]:" << pending.size()
+                                     << "steps were never written.";
+            check( next != 0 ) << "[run:pipeline]: Trace must have at least two entries.";
+
+            writer.finish( last, next );
+            return last;
+        }
+    };
+
+    template< typename Writer >
+    result_t verify_pipelined( circuit_ref_t circuit, trace::native::EntryReader reader,
+                               Writer &writer, pipeline_config config = {} )
+    {
+        return verify_pipeline< Writer >( circuit, writer, config ).run( std::move( reader ) );
+    }
+
+} // namespace circ::run
@@ -4,11 +4,11 @@
 
 #pragma once
 
-#include <circuitous/Run/Base.hpp>
-#include <circuitous/Run/Spawn.hpp>
-
 #include <circuitous/Support/Check.hpp>
 
+#include <cstdint>
+#include <string>
+
 namespace circ::run
 {
     enum class result_t : uint32_t
@@ -22,7 +22,7 @@ namespace circ::run
         unreachable
     };
 
-    std::string to_string(result_t raw)
+    static inline std::string to_string(result_t raw)
     {
         switch(raw)
         {
@@ -36,12 +36,12 @@ namespace circ::run
         }
     }
 
-    bool accepted(result_t raw)
+    static inline bool accepted(result_t raw)
     {
         return raw == result_t::accepted;
     }
 
-    bool rejected(result_t raw)
+    static inline bool rejected(result_t raw)
     {
         switch(raw)
         {
@@ -51,7 +51,7 @@ namespace circ::run
         }
     }
 
-    bool error(result_t raw)
+    static inline bool error(result_t raw)
     {
         switch(raw)
         {
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2022 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <circuitous/Run/Result.hpp>
+#include <circuitous/Run/State.hpp>
+
+#include <circuitous/Support/Check.hpp>
+#include <circuitous/Util/Warnings.hpp>
+
+CIRCUITOUS_RELAX_WARNINGS
+#include <llvm/ADT/APInt.h>
+#include <llvm/Support/EndianStream.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+CIRCUITOUS_UNRELAX_WARNINGS
+
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace circ::run
+{
+    // Outcome of one step - transition between two consecutive entries of a trace.
+    struct step_result
+    {
+        std::size_t idx;
+        result_t status;
+        // Derived by the accepting context, empty if there is none.
+        std::vector< Memory::Parsed > memory_hints;
+    };
+
+    // Coarse category of `result_t` that is used in exported results.
+    static inline std::string export_result( result_t r )
+    {
+        if ( accepted( r ) )
+            return "accept";
+        if ( rejected( r ) )
+            return "reject";
+        return "error";
+    }
+
+    namespace detail
+    {
+        static inline std::string str( const llvm::APInt &what )
+        {
+            return llvm::toString( what, 16, false );
+        }
+
+        static inline std::string hex( std::size_t what )
+        {
+            std::stringstream ss;
+            ss << std::hex << what;
+            return ss.str();
+        }
+
+        static inline void write_memory_hints( llvm::json::OStream &j,
+                                               const std::vector< Memory::Parsed > &hints )
+        {
+            for ( const auto &hint : hints )
+                j.attributeObject( str( hint.id() ), [ & ]
+                {
+                    j.attribute( "used", str( hint.used() ) );
+                    j.attribute( "mode", str( hint.mode() ) );
+                    j.attribute( "id", str( hint.id() ) );
+                    j.attribute( "size", str( hint.size() ) );
+                    j.attribute( "addr", str( hint.addr() ) );
+                    j.attribute( "value", str( hint.value() ) );
+                    j.attribute( "ts", str( hint.timestamp() ) );
+                } );
+        }
+    } // namespace detail
+
+    // Writers receive steps in trace order via `step( const step_result & )` and once all
+    // steps are processed `finish( last_status, steps_count )` is called.
+
+    // JSON Lines - one compact object per step, written as soon as the step is known,
+    // followed by a summary object:
+    //  { "step": "1a", "result": "accept", "memory_hints": { "0": { ... } } }
+    //  ...
+    //  { "result": "accept", "steps": 27 }
+    struct jsonl_result_writer
+    {
+        llvm::raw_ostream &os;
+
+        explicit jsonl_result_writer( llvm::raw_ostream &os ) : os( os ) {}
+
+        void step( const step_result &step )
+        {
+            llvm::json::OStream j( os );
+            j.object( [ & ]
+            {
+                j.attribute( "step", detail::hex( step.idx ) );
+                j.attribute( "result", export_result( step.status ) );
+                j.attributeObject( "memory_hints", [ & ]
+                {
+                    detail::write_memory_hints( j, step.memory_hints );
+                } );
+            } );
+            os << "\n";
+        }
+
+        void finish( result_t last, std::size_t steps )
+        {
+            llvm::json::OStream j( os );
+            j.object( [ & ]
+            {
+                j.attribute( "result", export_result( last ) );
+                j.attribute( "steps", static_cast< int64_t >( steps ) );
+            } );
+            os << "\n";
+            os.flush();
+        }
+    };
+
+    // Same document as `dom_result_writer` produces, but streamed - nothing but the
+    // current step is ever kept in memory:
+    //  { "traces": { "0": { "memory_hints": { ... }, "result": "accept" }, ... },
+    //    "result": "accept" }
+    // The only difference is the order of keys (`traces` are ordered by step and overall
+    // result goes last, as it is not known before), which JSON does not assign any
+    // meaning to. `indent` of 0 produces compact output.
+    struct json_result_writer
+    {
+        llvm::raw_ostream &os;
+        llvm::json::OStream j;
+
+        explicit json_result_writer( llvm::raw_ostream &os, unsigned indent = 2 )
+            : os( os ), j( os, indent )
+        {
+            j.objectBegin();
+            j.attributeBegin( "traces" );
+            j.objectBegin();
+        }
+
+        void step( const step_result &step )
+        {
+            j.attributeObject( detail::hex( step.idx ), [ & ]
+            {
+                j.attributeObject( "memory_hints", [ & ]
+                {
+                    detail::write_memory_hints( j, step.memory_hints );
+                } );
+                j.attribute( "result", export_result( step.status ) );
+            } );
+        }
+
+        void finish( result_t last, std::size_t )
+        {
+            j.objectEnd();
+            j.attributeEnd();
+            j.attribute( "result", export_result( last ) );
+            j.objectEnd();
+            os.flush();
+        }
+    };
+
+    // Builds the whole document in memory first and prints it at the end. Kept as
+    // a reference for `json_result_writer`, which should be preferred.
+    struct dom_result_writer
+    {
+        llvm::raw_ostream &os;
+        llvm::json::Object traces;
+
+        explicit dom_result_writer( llvm::raw_ostream &os ) : os( os ) {}
+
+        void step( const step_result &step )
+        {
+            using detail::str;
+
+            llvm::json::Object hints;
+            for ( const auto &hint : step.memory_hints )
+            {
+                llvm::json::Object current;
+                current[ "used" ]  = str( hint.used() );
+                current[ "mode" ]  = str( hint.mode() );
+                current[ "id" ]    = str( hint.id() );
+                current[ "size" ]  = str( hint.size() );
+                current[ "addr" ]  = str( hint.addr() );
+                current[ "value" ] = str( hint.value() );
+                current[ "ts" ]    = str( hint.timestamp() );
+                hints[ str( hint.id() ) ] = std::move( current );
+            }
+
+            llvm::json::Object trace;
+            trace[ "result" ] = export_result( step.status );
+            trace[ "memory_hints" ] = std::move( hints );
+            traces[ detail::hex( step.idx ) ] = std::move( trace );
+        }
+
+        void finish( result_t last, std::size_t )
+        {
+            llvm::json::Object out;
+            out[ "result" ] = export_result( last );
+            out[ "traces" ] = std::move( traces );
+            os << llvm::formatv( "{0:2}", llvm::json::Value( std::move( out ) ) );
+            os.flush();
+        }
+    };
+
+    // Binary encoding, all integers are little endian:
+    //  header  : "CRES", u32 version
+    //  step    : u8 1, u64 idx, u8 result_t, u8 hints count, hints count * 8 * u64
+    //            (memory hint fields in the order of `irops::memory::Layout`)
+    //  summary : u8 0, u64 steps count, u8 result_t
+    struct binary_result_writer
+    {
+        static inline constexpr uint32_t version = 1;
+
+        llvm::raw_ostream &os;
+
+        explicit binary_result_writer( llvm::raw_ostream &os ) : os( os )
+        {
+            os << "CRES";
+            write< uint32_t >( version );
+        }
+
+        template< typename T >
+        void write( T value )
+        {
+            llvm::support::endian::write< T >( os, value, llvm::support::little );
+        }
+
+        void step( const step_result &step )
+        {
+            check( step.memory_hints.size() <= std::numeric_limits< uint8_t >::max() );
+
+            write< uint8_t >( 1 );
+            write< uint64_t >( step.idx );
+            write< uint8_t >( static_cast< uint8_t >( step.status ) );
+            write< uint8_t >( static_cast< uint8_t >( step.memory_hints.size() ) );
+            for ( const auto &hint : step.memory_hints )
+                hint.apply( [ & ]( auto, const auto &val )
+                {
+                    write< uint64_t >( val.getZExtValue() );
+                } );
+        }
+
+        void finish( result_t last, std::size_t steps )
+        {
+            write< uint8_t >( 0 );
+            write< uint64_t >( steps );
+            write< uint8_t >( static_cast< uint8_t >( last ) );
+            os.flush();
+        }
+    };
+
+    static inline bool binary_result_format( const std::string &format )
+    {
+        return format == "bin";
+    }
+
+    // Invokes `fn( writer )` with writer of requested `format`:
+    //  json (pretty), json-compact, jsonl, bin
+    template< typename Fn >
+    auto with_result_writer( const std::string &format, llvm::raw_ostream &os, Fn &&fn )
+    {
+        if ( format == "json" )
+        {
+            json_result_writer writer( os );
+            return fn( writer );
+        }
+        if ( format == "json-compact" )
+        {
+            json_result_writer writer( os, 0 );
+            return fn( writer );
+        }
+        if ( format == "jsonl" )
+        {
+            jsonl_result_writer writer( os );
+            return fn( writer );
+        }
+
+        check( format == "bin" ) << "Unknown result format:" << format;
+        binary_result_writer writer( os );
+        return fn( writer );
+    }
+
+} // namespace circ::run
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2022 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <circuitous/IR/Circuit.hpp>
+
+#include <circuitous/Run/Result.hpp>
+#include <circuitous/Run/State.hpp>
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace circ::run
+{
+    // What `StatelessControl` reports about one step - the joined status of all spawns
+    // and memory hints derived by the accepting one (empty if there is none).
+    struct step_outcome
+    {
+        result_t status;
+        std::vector< Memory::Parsed > memory_hints;
+    };
+
+    struct step_cache_config
+    {
+        // Upper bound of memory used by cached entries (approximate).
+        std::size_t max_bytes = 256ull << 20;
+
+        // Circuits produced by the lifter only compare timestamps with each other
+        // (`ts_out == ts_in + 1`, memory hints carry `ts_in`), therefore the result of a
+        // step does not change if all its timestamps are shifted together. With this
+        // enabled, timestamps are keyed relative to the input timestamp - otherwise every
+        // step of a trace would be unique.
+        bool relative_timestamps = true;
+    };
+
+    // Memoizes outcomes of steps. Key is formed by values of exactly the leaves in the
+    // dependency cone of the circuit root (values of leaves the circuit never reads do
+    // not matter), so repeated states of hot loops are verified only once.
+    // Entries are evicted in least-recently-used order once `max_bytes` is exceeded.
+    // All public methods are thread-safe.
+    struct step_cache
+    {
+        using step_t = std::unordered_map< Operation *, value_type >;
+
+        struct stats_t
+        {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;
+            std::size_t entries = 0;
+            std::size_t bytes = 0;
+
+            double hit_rate() const
+            {
+                auto total = hits + misses;
+                return ( total == 0 ) ? 0.0 : static_cast< double >( hits ) / total;
+            }
+
+            std::string to_string() const;
+        };
+
+      private:
+        struct key_t
+        {
+            std::vector< value_type > values;
+            std::size_t hash = 0;
+
+            bool operator==( const key_t &other ) const
+            {
+                return hash == other.hash && values == other.values;
+            }
+        };
+
+        struct key_hash
+        {
+            std::size_t operator()( const key_t &key ) const { return key.hash; }
+        };
+
+        using lru_t = std::list< const key_t * >;
+
+        struct cached_t
+        {
+            // Timestamps of memory hints are relative, see `relative_timestamps`.
+            step_outcome outcome;
+            std::size_t bytes;
+            lru_t::iterator position;
+        };
+
+        step_cache_config config;
+
+        // Leaves in the dependency cone of the root, ordered by id.
+        std::vector< Operation * > leaves;
+        Operation *ts_in = nullptr;
+        // Memory leaves in the order of memory hints of an outcome, `nullptr` if the leaf
+        // is not part of the key.
+        std::vector< Operation * > hint_leaves;
+        // Offset of the timestamp field in memory hints.
+        uint32_t hint_ts_offset;
+
+        mutable std::mutex mtx;
+        std::unordered_map< key_t, cached_t, key_hash > entries;
+        // Most recently used entry is at the front.
+        lru_t lru;
+        stats_t counters;
+
+      public:
+        explicit step_cache( circuit_ref_t circuit, step_cache_config config = {} );
+
+        step_cache( const step_cache & ) = delete;
+        step_cache &operator=( const step_cache & ) = delete;
+
+        // Returns outcome of an equivalent step if it was seen, otherwise `compute()`
+        // is invoked and its result is remembered.
+        template< typename Compute >
+        step_outcome get_or_compute( const step_t &step, Compute &&compute )
+        {
+            auto key = make_key( step );
+            if ( auto hit = lookup( key, step ) )
+                return std::move( *hit );
+
+            auto out = compute();
+            insert( std::move( key ), out, step );
+            return out;
+        }
+
+        stats_t stats() const;
+
+      private:
+        key_t make_key( const step_t &step ) const;
+
+        std::optional< llvm::APInt > input_ts( const step_t &step ) const;
+
+        // Shift timestamps of `outcome` by `-ts` (`relative` is `true`) or by `ts`. Only
+        // hints whose timestamp is relative in the key are shifted, others (e.g., unused
+        // hints without a value in the trace) are the same for every timestamp.
+        void rebase( step_outcome &outcome, const step_t &step, bool relative ) const;
+
+        std::optional< step_outcome > lookup( const key_t &key, const step_t &step );
+        void insert( key_t key, step_outcome outcome, const step_t &step );
+        void evict();
+    };
+
+} // namespace circ::run
@@ -9,12 +9,17 @@
 #include <circuitous/Util/Warnings.hpp>
 
 CIRCUITOUS_RELAX_WARNINGS
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/StringExtras.h>
 #include <llvm/Support/JSON.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/MemoryBuffer.h>
 CIRCUITOUS_UNRELAX_WARNINGS
 
+#include <filesystem>
 #include <fstream>
+#include <optional>
+#include <string>
 
 #include <circuitous/IR/Trace.hpp>
 
@@ -152,6 +157,94 @@ namespace circ::run::trace
 
             auto take() { return std::move(trace); }
 
+            // Validation reports the first problem that would make parsing fail, so that
+            // callers which must not terminate (e.g. batch verification) can reject
+            // the input up front. Empty if the input can be parsed.
+            using error_t = std::optional< std::string >;
+
+            // `max_digits == 0` means unlimited.
+            static error_t validate_hex(const llvm::json::Object &obj, llvm::StringRef key,
+                                        std::size_t max_digits = 0)
+            {
+                auto str = obj.getString(key);
+                if (!str)
+                    return "missing string \"" + key.str() + "\"";
+                if (str->empty() || (max_digits != 0 && str->size() > max_digits) ||
+                    !llvm::all_of(*str, llvm::isHexDigit))
+                {
+                    return "\"" + key.str() + "\" is not a valid hex value: " + str->str();
+                }
+                return {};
+            }
+
+            static error_t validate_entry(const llvm::json::Object &obj)
+            {
+                for (auto key : { "timestamp", "error_flag" })
+                    if (auto err = validate_hex(obj, key))
+                        return err;
+
+                // Bytes of at most 15 byte long encoding.
+                if (auto err = validate_hex(obj, "instruction_bits", 15 * 2))
+                    return err;
+                if (obj.getString("instruction_bits")->size() % 2 != 0)
+                    return "\"instruction_bits\" do not consist of whole bytes";
+
+                auto regs = obj.getObject("regs");
+                if (!regs)
+                    return "missing object \"regs\"";
+                for (const auto &[reg, _] : *regs)
+                    if (auto err = validate_hex(*regs, reg))
+                        return "register " + *err;
+
+                auto hints = obj.getArray("memory_hints");
+                if (!hints)
+                    return "missing array \"memory_hints\"";
+                for (const auto &hint : *hints)
+                {
+                    auto o = hint.getAsObject();
+                    if (!o)
+                        return "memory hint is not an object";
+                    for (auto key : { "mode", "id", "size", "addr", "val", "ts" })
+                        if (auto err = validate_hex(*o, key, 16))
+                            return "memory hint " + *err;
+                }
+                return {};
+            }
+
+            static error_t validate(const llvm::json::Object &obj)
+            {
+                if (!obj.getInteger("id"))
+                    return "missing integer \"id\"";
+
+                if (auto memory = obj.getObject("initial_memory"))
+                {
+                    for (const auto &[addr, val] : *memory)
+                    {
+                        auto str = val.getAsString();
+                        if (addr.str().empty() || addr.str().size() > 16 ||
+                            !llvm::all_of(addr.str(), llvm::isHexDigit) ||
+                            !str || str->size() % 2 != 0 ||
+                            !llvm::all_of(*str, llvm::isHexDigit))
+                        {
+                            return "invalid initial memory at: " + addr.str();
+                        }
+                    }
+                }
+
+                auto entries = obj.getArray("entries");
+                if (!entries)
+                    return "missing array \"entries\"";
+                for (std::size_t i = 0; i < entries->size(); ++i)
+                {
+                    auto entry = (*entries)[i].getAsObject();
+                    if (!entry)
+                        return "entry " + std::to_string(i) + " is not an object";
+                    if (auto err = validate_entry(*entry))
+                        return "entry " + std::to_string(i) + ": " + *err;
+                }
+                return {};
+            }
+
             Trace::memory_t parse_memory(const auto &obj)
             {
                 Trace::memory_t out;
@@ -172,7 +265,11 @@ namespace circ::run::trace
 
             self_t &run(const std::string &path)
             {
-                auto obj = open_json(path);
+                return run(open_json(path));
+            }
+
+            self_t &run(const llvm::json::Object &obj)
+            {
                 trace.id = static_cast< uint64_t >(unwrap(obj.getInteger("id")));
                 if (auto maybe_initial_memory = obj.getObject("initial_memory"))
                     trace.initial_memory = parse_memory(unwrap(maybe_initial_memory));
@@ -182,7 +279,6 @@ namespace circ::run::trace
                     trace.entries.emplace_back(std::move(x));
                 }
                 return *this;
-
             }
 
             struct ParseEntry
@@ -254,6 +350,136 @@ namespace circ::run::trace
             return FromJSON().run(path).take();
         }
 
+        // Yields entries of a trace one at a time. Traces stored as JSON Lines (`.jsonl`,
+        // one entry object per line in the format of `FromJSON::ParseEntry`) are parsed
+        // lazily, so only entries that are currently processed are kept in memory.
+        // Any other trace is loaded as a whole first.
+        struct EntryReader
+        {
+            using entry_t = Trace::Entry;
+
+          private:
+            std::ifstream input;
+            std::optional< Trace > loaded;
+            std::size_t current = 0;
+
+            EntryReader() = default;
+
+          public:
+            explicit EntryReader(Trace trace) : loaded(std::move(trace)) {}
+
+            explicit EntryReader(const std::string &path)
+            {
+                if (std::filesystem::path(path).extension() != ".jsonl")
+                {
+                    loaded = load_json(path);
+                    return;
+                }
+
+                input.open(path);
+                check(input) << "Problem opening file to load trace from:" << path;
+            }
+
+            // Same as the constructor, but a trace that cannot be opened (or loaded, if
+            // it is not `.jsonl`) is reported in `error` instead of terminating.
+            static std::optional< EntryReader > open(const std::string &path,
+                                                     std::string &error)
+            {
+                EntryReader out;
+                if (std::filesystem::path(path).extension() == ".jsonl")
+                {
+                    out.input.open(path);
+                    if (!out.input)
+                    {
+                        error = "Problem opening file to load trace from: " + path;
+                        return {};
+                    }
+                    return out;
+                }
+
+                auto maybe_buff = llvm::MemoryBuffer::getFile(path);
+                if (!maybe_buff)
+                {
+                    error = "Error while opening JSON at: " + path + ": " +
+                            maybe_buff.getError().message();
+                    return {};
+                }
+
+                auto maybe_json = llvm::json::parse(maybe_buff.get()->getBuffer());
+                if (!maybe_json)
+                {
+                    error = "Error while parsing JSON at: " + path + ": " +
+                            llvm::toString(maybe_json.takeError());
+                    return {};
+                }
+
+                auto obj = maybe_json->getAsObject();
+                if (!obj)
+                {
+                    error = "Invalid loaded JSON object from: " + path;
+                    return {};
+                }
+
+                if (auto err = FromJSON::validate(*obj))
+                {
+                    error = "Invalid trace " + path + ": " + *err;
+                    return {};
+                }
+
+                out.loaded = FromJSON().run(*obj).take();
+                return out;
+            }
+
+            std::optional< entry_t > next()
+            {
+                std::string error;
+                auto out = try_next(error);
+                check(error.empty()) << error;
+                return out;
+            }
+
+            // Same as `next`, but an entry that cannot be parsed is reported in `error`
+            // (and nothing is returned) instead of terminating.
+            std::optional< entry_t > try_next(std::string &error)
+            {
+                if (loaded)
+                {
+                    if (current >= loaded->size())
+                        return {};
+                    return std::move((*loaded)[current++]);
+                }
+
+                for (std::string line; std::getline(input, line);)
+                {
+                    if (llvm::StringRef(line).trim().empty())
+                        continue;
+
+                    auto maybe_json = llvm::json::parse(line);
+                    if (!maybe_json)
+                    {
+                        error = "Error while parsing trace entry: " +
+                                llvm::toString(maybe_json.takeError());
+                        return {};
+                    }
+
+                    auto obj = maybe_json.get().getAsObject();
+                    if (!obj)
+                    {
+                        error = "Trace entry is not a JSON object: " + line;
+                        return {};
+                    }
+
+                    if (auto err = FromJSON::validate_entry(*obj))
+                    {
+                        error = "Invalid trace entry: " + *err;
+                        return {};
+                    }
+                    return FromJSON::ParseEntry().run(*obj).take();
+                }
+                return {};
+            }
+        };
+
         static inline auto prune_memory_hints( circuit_ref_t circuit,
                                                const Trace::Entry &src )
             -> Trace::Entry
@@ -25,7 +25,7 @@ CIRCUITOUS_UNRELAX_WARNINGS
 
 namespace circ::run::trace
 {
-    auto do_decode( circ::Ctx &ctx )
+    static inline auto do_decode( circ::Ctx &ctx )
     {
         return [ & ]( const std::string &data )
         {
@@ -45,7 +45,7 @@ namespace circ::run::trace
 
     // TODO(run:trace): Someone can play and make this composable, but I do not think
     //                  it is worth the boilerplate.
-    auto raw_size_decoder( circ::Ctx &ctx )
+    static inline auto raw_size_decoder( circ::Ctx &ctx )
     {
         return [ & ]( const std::string &data ) -> std::size_t
         {
@@ -53,7 +53,7 @@ namespace circ::run::trace
         };
     }
 
-    auto capturing_size_decoder( circ::Ctx &ctx, std::vector< remill::Instruction > &into )
+    static inline auto capturing_size_decoder( circ::Ctx &ctx, std::vector< remill::Instruction > &into )
     {
         return [ & ]( const std::string &data ) -> std::size_t
         {
@@ -6,6 +6,8 @@
 
 #include <circuitous/Util/CmdParser.hpp>
 
+#include <algorithm>
+
 namespace circ::cli
 {
     template< typename Self >
@@ -40,7 +42,31 @@ namespace circ::cli
         }
     };
 
+    template<>
+    struct As< std::size_t >
+    {
+        using tokens_t = std::vector< std::string >;
+        static std::optional< std::size_t > cast(tokens_t tokens)
+        {
+            if (validate(tokens))
+                return std::nullopt;
+            return static_cast< std::size_t >(std::stoull(tokens[0]));
+        }
+
+        static std::optional< std::string > validate(const tokens_t &tokens)
+        {
+            auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+            if (tokens.size() == 1 && !tokens[0].empty() &&
+                std::all_of(tokens[0].begin(), tokens[0].end(), is_digit))
+            {
+                return {};
+            }
+            return std::make_optional< std::string >("Expected 1 non-negative number.");
+        }
+    };
+
     struct PathArg : Arity< 1 >, As< std::string > {};
+    struct NumArg : Arity< 1 >, As< std::size_t > {};
 
     struct SMTOut : circ::DefaultCmdOpt, PathArg
     {
@@ -281,6 +307,15 @@ namespace circ::cli
         static std::string short_help() { return help(); }
     };
 
+    struct Threads : circ::DefaultCmdOpt, derive_short_help< Threads >, NumArg
+    {
+        static inline const auto opt = circ::CmdOpt("--threads", { "-j" }, false);
+        static std::string help()
+        {
+            return "Number of worker threads, defaults to the number of hardware threads.\n";
+        }
+    };
+
     struct EqSat : circ::DefaultCmdOpt, Arity< 0 >
     {
         static inline const auto opt = circ::CmdOpt("--eqsat", false);
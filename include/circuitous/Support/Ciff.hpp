@@ -16,6 +16,9 @@ CIRCUITOUS_UNRELAX_WARNINGS
 
 namespace circ
 {
+    using bytes_and_iform_t = std::tuple< InstBytes, std::string >;
+    using CIF = std::vector< bytes_and_iform_t >;
+
     // CIF(F) - circuitous input file (format)
     struct CIFFWriter
     {
@@ -36,12 +39,16 @@ namespace circ
             return *this;
         }
 
+        self_t &operator<<(const bytes_and_iform_t &entry)
+        {
+            const auto &[bytes, iform] = entry;
+            out << bytes << " " << iform << std::endl;
+            return *this;
+        }
+
         void flush() { out.flush(); }
     };
 
-    using bytes_and_iform_t = std::tuple< InstBytes, std::string >;
-    using CIF = std::vector< bytes_and_iform_t >;
-
     struct CIFFReader
     {
         using self_t = CIFFReader;
@@ -13,7 +13,11 @@
 
 #include <eqsat/core/cost_graph.hpp>
 
+#include <initializer_list>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace circ {
 
@@ -69,55 +73,35 @@ namespace circ {
             return bitwidth;
         }
 
+        using symbol_set = std::unordered_set< eqsat::symbol_t >;
+
+        static symbol_set interned(std::initializer_list< std::string_view > names) {
+            symbol_set out;
+            for (auto name : names) {
+                out.insert(eqsat::intern(name));
+            }
+            return out;
+        }
+
         bitwidth_t compute_bitwidth(const sized_node &sized, const std::vector< operation > &children) {
-            auto result = llvm::StringSwitch< bitwidth_t >(sized.op_code_name)
-                // .Case("in.timestamp",     circuit->create< InputTimestamp >( size ))
-                // .Case("out.timestamp",    circuit->create< OutputTimestamp >( size ))
-                // .Case("in.error_flag",    circuit->create< InputErrorFlag >( size ))
-                // .Case("out.error_flag",   circuit->create< OutputErrorFlag >( size ))
-                // .Case("undefined",        circuit->create< Undefined >( size ))
-                // .Case("instruction_bits", circuit->create< InputInstructionBits >( size ))
-
-                .Case("Add" ,  size_of_operands(children))
-                .Case("Sub" ,  size_of_operands(children))
-                .Case("Mul" ,  size_of_operands(children))
-                .Case("UDiv",  size_of_operands(children))
-                .Case("SDiv",  size_of_operands(children))
-                .Case("URem",  size_of_operands(children))
-                .Case("Xor" ,  size_of_operands(children))
-                .Case("SRem",  size_of_operands(children))
-                .Case("Shl" ,  size_of_operands(children))
-                .Case("LShr",  size_of_operands(children))
-                .Case("AShr",  size_of_operands(children))
-                // .Case("Trunc", size_of_operands(children))
-                // .Case("ZExt",  size_of_operands(children))
-                // .Case("SExt",  size_of_operands(children))
-
-                .Case("Icmp_ult", 1)
-                .Case("Icmp_slt", 1)
-                .Case("Icmp_ugt", 1)
-                .Case("Icmp_eq", 1)
-                .Case("Icmp_ne", 1)
-                .Case("Icmp_uge", 1)
-                .Case("Icmp_ule", 1)
-                .Case("Icmp_sgt", 1)
-                .Case("Icmp_sge", 1)
-                .Case("Icmp_sle", 1)
-
-                // .Case("concat", circuit->create< Concat >( size ))
-
-                .Case("Or" ,  size_of_operands(children))
-                .Case("And",  size_of_operands(children))
-                .Case("Xor",  size_of_operands(children))
-
-                // .Case("pop_count",             circuit->create< PopulationCount >( size ))
-                // .Case("count_lead_zeroes",     circuit->create< CountLeadingZeroes >( size ))
-                // .Case("count_trailing_zeroes", circuit->create< CountTrailingZeroes >( size ))
-                .Case("not",  size_of_operands(children))
-
-                // .Case("Switch", circuit->create< Switch >( size ))
-                // .Case("Option", circuit->create< Option >( size ))
-                .Default( 0 );
+            // TODO: in/out timestamps and error flags, undefined, instruction bits, casts,
+            // concat, bit counting, switch and option
+            static const auto same_as_operands = interned({
+                "Add", "Sub", "Mul", "UDiv", "SDiv", "URem", "Xor", "SRem", "Shl", "LShr", "AShr",
+                "Or", "And", "not"
+            });
+
+            static const auto predicates = interned({
+                "Icmp_ult", "Icmp_slt", "Icmp_ugt", "Icmp_eq", "Icmp_ne", "Icmp_uge",
+                "Icmp_ule", "Icmp_sgt", "Icmp_sge", "Icmp_sle"
+            });
+
+            bitwidth_t result = 0;
+            if (same_as_operands.count(sized.op_code)) {
+                result = size_of_operands(children);
+            } else if (predicates.count(sized.op_code)) {
+                result = 1;
+            }
 
             if (!result) {
                 log_kill() << "not implemented: update bitwidths of " << node_name(sized);
@@ -126,111 +110,168 @@ namespace circ {
             return result;
         }
 
-        operation extract(const optimal_node &node) {
-            auto node_ptr = node.node;
-            if (cached.count(node_ptr)) {
-                return cached.at(node_ptr);
-            }
+        // Operations are created in postorder of the extracted graph. The traversal
+        // uses an explicit stack, deep circuits do not exhaust the native one.
+        operation extract(const optimal_node &root) {
+            auto chosen = [&] (node_pointer node, std::size_t idx) {
+                return graph.node(node->child(idx)).node;
+            };
+
+            std::vector< std::pair< node_pointer, bool > > stack = { { root.node, false } };
+            while (!stack.empty()) {
+                auto [node_ptr, expanded] = stack.back();
+                if (cached.count(node_ptr)) {
+                    stack.pop_back();
+                    continue;
+                }
 
-            std::vector< operation > children;
-            for (const auto &ch : node.children()) {
-                children.push_back(extract(ch));
-            }
+                if (!expanded) {
+                    stack.back().second = true;
+                    for (auto idx = node_ptr->num_of_children(); idx > 0; --idx) {
+                        stack.emplace_back(chosen(node_ptr, idx - 1), false);
+                    }
+                    continue;
+                }
 
-            auto data = unwrap(node_ptr->data);
+                stack.pop_back();
 
-            if (needs_compute_bitwidth(data)) {
-                if (auto *sized = std::get_if< sized_node >(&data)) {
-                    sized->size = compute_bitwidth(*sized, children);
-                } else {
-                    log_kill() << "not implemented: update bitwidths of " << node_name(data);
+                std::vector< operation > children;
+                for (std::size_t idx = 0; idx < node_ptr->num_of_children(); ++idx) {
+                    children.push_back(cached.at(chosen(node_ptr, idx)));
                 }
-            }
 
-            auto op = make_operation(data);
-            cached.emplace(node_ptr, op);
+                auto data = unwrap(node_ptr->data);
+
+                if (needs_compute_bitwidth(data)) {
+                    if (auto *sized = std::get_if< sized_node >(&data)) {
+                        sized->size = compute_bitwidth(*sized, children);
+                    } else {
+                        log_kill() << "not implemented: update bitwidths of " << node_name(data);
+                    }
+                }
 
-            for (auto child : children) {
-                op->add_operand(child);
+                auto op = make_operation(data);
+                cached.emplace(node_ptr, op);
+
+                for (auto child : children) {
+                    op->add_operand(child);
+                }
             }
 
-            return op;
+            return cached.at(root.node);
         }
 
-        operation make_operation(const op_code_node &op) {
-            return llvm::StringSwitch< operation >(op.op_code_name)
-                .Case("register_constraint",  circuit->create< RegConstraint >())
-                .Case("advice_constraint",    circuit->create< AdviceConstraint >())
-                .Case("write_constraint",     circuit->create< WriteConstraint >())
-                .Case("read_constraint",      circuit->create< ReadConstraint >())
-                .Case("unused_constraint",    circuit->create< UnusedConstraint >())
+        //
+        // operation factories indexed by interned op codes
+        //
+        template< typename op_t >
+        static operation create(Circuit *circuit) { return circuit->create< op_t >(); }
 
-                .Case("parity",               circuit->create< Parity >())
+        template< typename op_t >
+        static operation create_sized(Circuit *circuit, bitwidth_t size) {
+            return circuit->create< op_t >( size );
+        }
 
-                .Case("DecodeCondition",      circuit->create< DecodeCondition >())
-                .Case("DecoderResult",        circuit->create< DecoderResult >())
-                .Case("VerifyInstruction",    circuit->create< VerifyInstruction >())
-                .Case("OnlyOneCondition",     circuit->create< OnlyOneCondition >())
+        template< typename op_t >
+        static operation create_register(Circuit *circuit, const std::string &reg, bitwidth_t size) {
+            return circuit->create< op_t >( reg, size );
+        }
 
-                .Case("DecoderResult", circuit->create< DecoderResult >())
+        template< typename factory >
+        using factories = std::unordered_map< eqsat::symbol_t, factory >;
+
+        static const auto &opcode_factories() {
+            using factory = operation (*)(Circuit *);
+            static const factories< factory > table = {
+                { eqsat::intern("register_constraint"), create< RegConstraint > },
+                { eqsat::intern("advice_constraint"),   create< AdviceConstraint > },
+                { eqsat::intern("write_constraint"),    create< WriteConstraint > },
+                { eqsat::intern("read_constraint"),     create< ReadConstraint > },
+                { eqsat::intern("unused_constraint"),   create< UnusedConstraint > },
+
+                { eqsat::intern("parity"),              create< Parity > },
+
+                { eqsat::intern("DecodeCondition"),     create< DecodeCondition > },
+                { eqsat::intern("DecoderResult"),       create< DecoderResult > },
+                { eqsat::intern("VerifyInstruction"),   create< VerifyInstruction > },
+                { eqsat::intern("OnlyOneCondition"),    create< OnlyOneCondition > },
+            };
+            return table;
+        }
 
-                .Default( nullptr );
+        static const auto &sized_factories() {
+            using factory = operation (*)(Circuit *, bitwidth_t);
+            static const factories< factory > table = {
+                { eqsat::intern("in.timestamp"),     create_sized< InputTimestamp > },
+                { eqsat::intern("out.timestamp"),    create_sized< OutputTimestamp > },
+                { eqsat::intern("in.error_flag"),    create_sized< InputErrorFlag > },
+                { eqsat::intern("out.error_flag"),   create_sized< OutputErrorFlag > },
+                { eqsat::intern("undefined"),        create_sized< Undefined > },
+                { eqsat::intern("instruction_bits"), create_sized< InputInstructionBits > },
+
+                { eqsat::intern("Add"),   create_sized< Add > },
+                { eqsat::intern("Sub"),   create_sized< Sub > },
+                { eqsat::intern("Mul"),   create_sized< Mul > },
+                { eqsat::intern("UDiv"),  create_sized< UDiv > },
+                { eqsat::intern("SDiv"),  create_sized< SDiv > },
+                { eqsat::intern("URem"),  create_sized< URem > },
+                { eqsat::intern("Xor"),   create_sized< Xor > },
+                { eqsat::intern("SRem"),  create_sized< SRem > },
+                { eqsat::intern("Shl"),   create_sized< Shl > },
+                { eqsat::intern("LShr"),  create_sized< LShr > },
+                { eqsat::intern("AShr"),  create_sized< AShr > },
+                { eqsat::intern("Trunc"), create_sized< Trunc > },
+                { eqsat::intern("ZExt"),  create_sized< ZExt > },
+                { eqsat::intern("SExt"),  create_sized< SExt > },
+
+                { eqsat::intern("Icmp_ult"), create_sized< Icmp_ult > },
+                { eqsat::intern("Icmp_slt"), create_sized< Icmp_slt > },
+                { eqsat::intern("Icmp_ugt"), create_sized< Icmp_ugt > },
+                { eqsat::intern("Icmp_eq"),  create_sized< Icmp_eq > },
+                { eqsat::intern("Icmp_ne"),  create_sized< Icmp_ne > },
+                { eqsat::intern("Icmp_uge"), create_sized< Icmp_uge > },
+                { eqsat::intern("Icmp_ule"), create_sized< Icmp_ule > },
+                { eqsat::intern("Icmp_sgt"), create_sized< Icmp_sgt > },
+                { eqsat::intern("Icmp_sge"), create_sized< Icmp_sge > },
+                { eqsat::intern("Icmp_sle"), create_sized< Icmp_sle > },
+
+                { eqsat::intern("input_immediate"), create_sized< InputImmediate > },
+
+                { eqsat::intern("concat"), create_sized< Concat > },
+
+                { eqsat::intern("Or"),  create_sized< Or > },
+                { eqsat::intern("And"), create_sized< And > },
+
+                { eqsat::intern("pop_count"),             create_sized< PopulationCount > },
+                { eqsat::intern("count_lead_zeroes"),     create_sized< CountLeadingZeroes > },
+                { eqsat::intern("count_trailing_zeroes"), create_sized< CountTrailingZeroes > },
+                { eqsat::intern("not"),                   create_sized< Not > },
+
+                { eqsat::intern("Switch"), create_sized< Switch > },
+                { eqsat::intern("Option"), create_sized< Option > },
+            };
+            return table;
+        }
+
+        static const auto &register_factories() {
+            using factory = operation (*)(Circuit *, const std::string &, bitwidth_t);
+            static const factories< factory > table = {
+                { eqsat::intern("in.register"),  create_register< InputRegister > },
+                { eqsat::intern("out.register"), create_register< OutputRegister > },
+            };
+            return table;
+        }
+
+        // Only the operation of the matching op code is created.
+        operation make_operation(const op_code_node &op) {
+            auto it = opcode_factories().find(op.op_code);
+            return it != opcode_factories().end() ? it->second(circuit.get()) : nullptr;
         }
 
         operation make_operation(const sized_node &op) {
             check(op.size.has_value());
-            auto size = op.size.value();
-            return llvm::StringSwitch< Operation* >(op.op_code_name)
-                .Case("in.timestamp",     circuit->create< InputTimestamp >( size ))
-                .Case("out.timestamp",    circuit->create< OutputTimestamp >( size ))
-                .Case("in.error_flag",    circuit->create< InputErrorFlag >( size ))
-                .Case("out.error_flag",   circuit->create< OutputErrorFlag >( size ))
-                .Case("undefined",        circuit->create< Undefined >( size ))
-                .Case("instruction_bits", circuit->create< InputInstructionBits >( size ))
-
-                .Case("Add",   circuit->create< Add >( size ))
-                .Case("Sub",   circuit->create< Sub >( size ))
-                .Case("Mul",   circuit->create< Mul >( size ))
-                .Case("UDiv",  circuit->create< UDiv >( size ))
-                .Case("SDiv",  circuit->create< SDiv >( size ))
-                .Case("URem",  circuit->create< URem >( size ))
-                .Case("Xor",   circuit->create< Xor >( size ))
-                .Case("SRem",  circuit->create< SRem >( size ))
-                .Case("Shl",   circuit->create< Shl >( size ))
-                .Case("LShr",  circuit->create< LShr >( size ))
-                .Case("AShr",  circuit->create< AShr >( size ))
-                .Case("Trunc", circuit->create< Trunc >( size ))
-                .Case("ZExt",  circuit->create< ZExt >( size ))
-                .Case("SExt",  circuit->create< SExt >( size ))
-
-                .Case("Icmp_ult", circuit->create< Icmp_ult >( size ))
-                .Case("Icmp_slt", circuit->create< Icmp_slt >( size ))
-                .Case("Icmp_ugt", circuit->create< Icmp_ugt >( size ))
-                .Case("Icmp_eq",  circuit->create< Icmp_eq >( size ))
-                .Case("Icmp_ne",  circuit->create< Icmp_ne >( size ))
-                .Case("Icmp_uge", circuit->create< Icmp_uge >( size ))
-                .Case("Icmp_ule", circuit->create< Icmp_ule >( size ))
-                .Case("Icmp_sgt", circuit->create< Icmp_sgt >( size ))
-                .Case("Icmp_sge", circuit->create< Icmp_sge >( size ))
-                .Case("Icmp_sle", circuit->create< Icmp_sle >( size ))
-
-                .Case("input_immediate", circuit->create< InputImmediate >( size ))
-
-                .Case("concat", circuit->create< Concat >( size ))
-
-                .Case("Or",                    circuit->create< Or >( size ))
-                .Case("And",                   circuit->create< And >( size ))
-                .Case("Xor",                   circuit->create< Xor >( size ))
-
-                .Case("pop_count",             circuit->create< PopulationCount >( size ))
-                .Case("count_lead_zeroes",     circuit->create< CountLeadingZeroes >( size ))
-                .Case("count_trailing_zeroes", circuit->create< CountTrailingZeroes >( size ))
-                .Case("not",                   circuit->create< Not >( size ))
-
-                .Case("Switch", circuit->create< Switch >( size ))
-                .Case("Option", circuit->create< Option >( size ))
-
-                .Default( nullptr );
+            auto it = sized_factories().find(op.op_code);
+            return it != sized_factories().end() ? it->second(circuit.get(), op.size.value()) : nullptr;
         }
 
         operation make_operation(const advice_node &op) {
@@ -238,14 +279,14 @@ namespace circ {
         }
 
         operation make_operation(const register_node &op) {
-            return llvm::StringSwitch< Operation* >(op.op_code_name)
-                .Case("in.register",  circuit->create< InputRegister >( op.reg_name, op.size ))
-                .Case("out.register", circuit->create< OutputRegister >( op.reg_name, op.size ))
-                .Default( nullptr );
+            auto it = register_factories().find(op.op_code);
+            return it != register_factories().end()
+                ? it->second(circuit.get(), op.reg.name(), op.size)
+                : nullptr;
         }
 
         operation make_operation(const constant_node &op) {
-            return circuit->create< Constant >( op.bits, op.size );
+            return circuit->create< Constant >( op.bits.name(), op.size );
         }
 
         operation make_operation(const memory_node &op) {
@@ -6,12 +6,15 @@
 
 #include <eqsat/core/common.hpp>
 #include <eqsat/core/egraph.hpp>
+#include <eqsat/core/snapshot.hpp>
+#include <eqsat/core/symbol.hpp>
 
 #include <circuitous/IR/Visitors.hpp>
 
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <variant>
 
 namespace circ
@@ -24,47 +27,64 @@ namespace circ
     // Node Templates keep data required to rebuild circuitous IR from EGraph
     //
     struct op_code_node {
-        std::string op_code_name;
+        eqsat::symbol_t op_code;
+
+        bool operator==(const op_code_node &) const = default;
     };
 
     struct sized_node {
-        std::string op_code_name;
+        eqsat::symbol_t op_code;
         maybe_bitwidth_t size;
+
+        bool operator==(const sized_node &) const = default;
     };
 
     struct advice_node {
-        std::string op_code_name;
+        eqsat::symbol_t op_code;
         maybe_bitwidth_t size;
         std::optional< std::uint32_t > idx;
+
+        bool operator==(const advice_node &) const = default;
     };
 
     struct register_node {
-        std::string op_code_name;
+        eqsat::symbol_t op_code;
         bitwidth_t size;
-        std::string reg_name;
+        eqsat::symbol_t reg;
+
+        bool operator==(const register_node &) const = default;
     };
 
     struct constant_node {
-        std::string op_code_name;
+        eqsat::symbol_t op_code;
         bitwidth_t size;
-        std::string bits;
+        // interned, constants repeat a lot and are compared on every hash-consing
+        eqsat::symbol_t bits;
+
+        bool operator==(const constant_node &) const = default;
     };
 
     struct memory_node {
-        std::string op_code_name;
+        eqsat::symbol_t op_code;
         maybe_bitwidth_t size;
         std::optional< std::uint32_t > idx;
+
+        bool operator==(const memory_node &) const = default;
     };
 
     struct extract_node {
-        std::string op_code_name;
+        eqsat::symbol_t op_code;
         std::uint32_t low_bit_inc, high_bit_exc;
+
+        bool operator==(const extract_node &) const = default;
     };
 
     struct select_node {
-        std::string op_code_name;
+        eqsat::symbol_t op_code;
         bitwidth_t size;
         std::uint32_t bits;
+
+        bool operator==(const select_node &) const = default;
     };
 
     using node_template = std::variant<
@@ -80,55 +100,68 @@ namespace circ
 
     struct circuit_egraph_builder_base {
 
+        // op code of an operation type is constant, therefore it is interned only once
+        template< typename op_t >
+        static eqsat::symbol_t op_code(op_t *) {
+            static const auto symbol = eqsat::intern(op_t::op_code_str());
+            return symbol;
+        }
+
         static op_code_node opcode(auto *op) {
-            return { op->op_code_str() };
+            return { op_code(op) };
         }
 
         static op_code_node opcode(const std::string &name) {
-            return { name };
+            return { eqsat::intern(name) };
         }
 
         static sized_node sized(auto *op) {
-            return { op->op_code_str(), op->size };
+            return { op_code(op), op->size };
         }
 
         static sized_node sized(const std::string &name, maybe_bitwidth_t size) {
-            return { name, size };
+            return { eqsat::intern(name), size };
         }
 
         static advice_node advice(Advice *op) {
-            return { op->op_code_str(), op->size, op->advice_idx };
+            return { op_code(op), op->size, op->advice_idx };
         }
 
         static advice_node advice(const std::string &name, bitwidth_t size, std::uint32_t idx) {
-            return { name, size, idx };
+            return { eqsat::intern(name), size, idx };
         }
 
         static register_node regop(auto *op) {
-            return { op->op_code_str(), op->size, op->reg_name };
+            return { op_code(op), op->size, eqsat::intern(op->reg_name) };
         }
 
         static register_node regop(const std::string &name, bitwidth_t size, const std::string &reg_name) {
-            return { name, size, reg_name };
+            return { eqsat::intern(name), size, eqsat::intern(reg_name) };
         }
 
         static constant_node constop(Constant *op) {
-            return { op->op_code_str(), op->size, op->bits };
+            return { op_code(op), op->size, eqsat::intern(op->bits) };
         }
 
         static memory_node memop(Memory *op) {
-            return { op->op_code_str(), op->size, op->mem_idx };
+            return { op_code(op), op->size, op->mem_idx };
         }
 
         static extract_node extract(Extract *op) {
-            return { op->op_code_str(), op->low_bit_inc, op->high_bit_exc };
+            return { op_code(op), op->low_bit_inc, op->high_bit_exc };
         }
 
         static select_node select(Select *op) {
-            return { op->op_code_str(), op->size, op->bits };
+            return { op_code(op), op->size, op->bits };
         }
     };
 
+    // Node template of an operation synthesized by a rewrite rule, `std::nullopt` if the
+    // operation cannot be synthesized (yet).
+    std::optional< node_template > synthesize_node_template(
+        eqsat::symbol_t op, maybe_bitwidth_t size
+    );
+
     //
     // Circuit from pattern builder
     //
@@ -156,75 +189,14 @@ namespace circ
         }
 
         static storage_type make(const eqsat::atom_t &op) {
-            // TODO build storage
-            auto name = atom_name(op);
-            auto res = llvm::StringSwitch< storage_type, std::optional< storage_type > >(name)
-                .Case("register_constraint", opcode(name))
-                .Case("advice_constraint"  , opcode(name))
-                .Case("write_constraint"   , opcode(name))
-                .Case("read_constraint"    , opcode(name))
-                .Case("unused_constraint"  , opcode(name))
-                .Case("parity"             , opcode(name))
-                .Case("DecodeCondition"    , opcode(name))
-                .Case("DecoderResult"      , opcode(name))
-                .Case("VerifyInstruction"  , opcode(name))
-                .Case("OnlyOneCondition"   , opcode(name))
-                .Case("DecoderResult"      , opcode(name))
-                // sized
-                .Case("in.timestamp"       , sized(name, op.bitwidth()))
-                .Case("out.timestamp"      , sized(name, op.bitwidth()))
-                .Case("in.error_flag"      , sized(name, op.bitwidth()))
-                .Case("out.error_flag"     , sized(name, op.bitwidth()))
-                .Case("undefined"          , sized(name, op.bitwidth()))
-                .Case("instruction_bits"   , sized(name, op.bitwidth()))
-                // binary sized
-                .Case("Add"     , sized(name, op.bitwidth()))
-                .Case("Sub"     , sized(name, op.bitwidth()))
-                .Case("Mul"     , sized(name, op.bitwidth()))
-                .Case("UDiv"    , sized(name, op.bitwidth()))
-                .Case("SDiv"    , sized(name, op.bitwidth()))
-                .Case("URem"    , sized(name, op.bitwidth()))
-                .Case("Xor"     , sized(name, op.bitwidth()))
-                .Case("SRem"    , sized(name, op.bitwidth()))
-                .Case("Shl"     , sized(name, op.bitwidth()))
-                .Case("LShr"    , sized(name, op.bitwidth()))
-                .Case("AShr"    , sized(name, op.bitwidth()))
-                .Case("Trunc"   , sized(name, op.bitwidth()))
-                .Case("ZExt"    , sized(name, op.bitwidth()))
-                .Case("SExt"    , sized(name, op.bitwidth()))
-                // binary relational
-                .Case("Icmp_ult", sized(name, 1))
-                .Case("Icmp_slt", sized(name, 1))
-                .Case("Icmp_ugt", sized(name, 1))
-                .Case("Icmp_eq" , sized(name, 1))
-                .Case("Icmp_ne" , sized(name, 1))
-                .Case("Icmp_uge", sized(name, 1))
-                .Case("Icmp_ule", sized(name, 1))
-                .Case("Icmp_sgt", sized(name, 1))
-                .Case("Icmp_sge", sized(name, 1))
-                .Case("Icmp_sle", sized(name, 1))
-                // concat
-                .Case("concat", sized(name, op.bitwidth()))
-                // bitops
-                .Case("Or"  , sized(name, op.bitwidth()))
-                .Case("And" , sized(name, op.bitwidth()))
-                .Case("Xor" , sized(name, op.bitwidth()))
-                // input
-                .Case("input_immediate" , sized(name, op.bitwidth()))
-                // other
-                .Case("pop_count"               , sized(name, op.bitwidth()))
-                .Case("count_lead_zeroes"       , sized(name, op.bitwidth()))
-                .Case("count_trailing_zeroes"   , sized(name, op.bitwidth()))
-                .Case("not"                     , sized(name, op.bitwidth()))
-                .Case("Switch"                  , sized(name, op.bitwidth()))
-                .Case("Option"                  , sized(name, op.bitwidth()))
-                .Default({});
-
-            if (!res) {
-                throw std::runtime_error(std::string("not implemented operation synthesis: ") + name);
+            const eqsat::atom_base &base = op;
+            if (auto operation = std::get_if< eqsat::operation_t >(&base)) {
+                if (auto res = synthesize_node_template(operation->symbol, op.bitwidth())) {
+                    return res.value();
+                }
             }
 
-            return res.value();
+            throw std::runtime_error(std::string("not implemented operation synthesis: ") + atom_name(op));
         }
     };
 
@@ -246,10 +218,21 @@ namespace circ
 
     std::string node_name(const node_template &op);
 
+    eqsat::symbol_t node_symbol(const node_template &op);
+
+    gap::hash_code hash_value(gap::hash_code code, const node_template &op);
+
+    // `undefined` leaves are not hash-consed, each stands for a distinct value.
+    bool hashconsed(const node_template &op);
+
     std::optional< gap::bigint > extract_constant(const node_template &op);
 
     std::string to_string(const node_template &op);
 
+    // egraph snapshot of node templates
+    void save_storage(eqsat::snapshot_output &out, const node_template &op);
+    node_template load_storage(eqsat::snapshot_input &in, std::type_identity< node_template >);
+
     using maybe_bitwidth = std::optional< bitwidth_t >;
     maybe_bitwidth bitwidth(const node_template &op);
 
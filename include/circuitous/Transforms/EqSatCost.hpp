@@ -15,10 +15,14 @@ namespace circ
         eqsat::cost_t operator()(const circuit_egraph::node_pointer node) const {
             // TODO: implement cost function
 
-            if (node_name(*node) == "Mul") {
+            static const auto mul = eqsat::intern("Mul");
+            static const auto add = eqsat::intern("Add");
+
+            auto symbol = node_symbol(*node);
+            if (symbol == mul) {
                 return 1000;  // * bitwidth(node).value();
             }
-            if (node_name(*node) == "Add") {
+            if (symbol == add) {
                 return 100;  // * bitwidth(node).value();
             }
 
@@ -32,7 +36,7 @@ namespace circ
 
     static_assert(gap::graph::graph_like< circuit_cost_graph >);
 
-    auto make_circuit_cost_graph(circuit_egraph &&graph) -> circuit_cost_graph {
+    static inline auto make_circuit_cost_graph(circuit_egraph &&graph) -> circuit_cost_graph {
         return circuit_cost_graph(std::move(graph), circuit_cost_function{});
     }
 
@@ -42,7 +46,7 @@ namespace circ
 
     static_assert(gap::graph::graph_like< optimal_circuit_graph_view >);
 
-    auto make_optimal_circuit_graph(circuit_egraph &&graph)
+    static inline auto make_optimal_circuit_graph(circuit_egraph &&graph)
         -> optimal_circuit_graph_view
     {
         return optimal_circuit_graph_view(std::move(graph), circuit_cost_function{});
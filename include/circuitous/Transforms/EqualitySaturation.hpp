@@ -6,12 +6,20 @@
 
 #include <circuitous/Transforms/PassBase.hpp>
 
+#include <eqsat/algo/saturation.hpp>
 #include <eqsat/pattern/rule_set.hpp>
 
+#include <filesystem>
 #include <span>
 
 namespace circ
 {
-    circuit_owner_t run_equality_saturation(circuit_owner_t &&, std::span< eqsat::rule_set > rules);
+    circuit_owner_t run_equality_saturation(
+        circuit_owner_t &&, std::span< eqsat::rule_set > rules,
+        const eqsat::saturation_config &config = {},
+        const eqsat::extraction_config &extraction = {},
+        // snapshot of a previous saturation of the same circuit to continue from
+        const std::filesystem::path &resume = {}
+    );
 
 } // namespace circ
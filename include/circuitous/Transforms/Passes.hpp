@@ -11,6 +11,7 @@
 #include <circuitous/Transforms/ConjureALU.hpp>
 #include <circuitous/Transforms/EqualitySaturation.hpp>
 
+#include <filesystem>
 #include <memory>
 #include <optional>
 #include <span>
@@ -33,7 +34,7 @@ namespace circ
   {
     circuit_owner_t run(circuit_owner_t &&circuit) override
     {
-      return run_equality_saturation(std::move(circuit), rulesets);
+      return run_equality_saturation(std::move(circuit), rulesets, config, extraction, resume);
     }
 
     static Pass get() { return std::make_shared< EqualitySaturationPass >(); }
@@ -47,6 +48,10 @@ namespace circ
     }
 
     std::vector< eqsat::rule_set > rulesets;
+    eqsat::saturation_config config;
+    eqsat::extraction_config extraction;
+    // snapshot written by a previous run (see `saturation_config::checkpoint`)
+    std::filesystem::path resume;
   };
 
 
@@ -136,6 +141,24 @@ namespace circ
     };
 
 
+    /*
+     * Simplifies the circuit without leaving circIR (the alternative is a round-trip
+     * through llvm, which needs the whole circuit twice in memory). Until fixpoint
+     * (or `max_sweeps`) nodes are visited operands first and
+     *  * operations on constants are folded,
+     *  * algebraic identities (`x & 0`, `x - x`, `trunc(zext(x))`, ...) are applied,
+     *  * extracts of extracts/concats are fused and adjacent slices in concats merged,
+     *  * structurally equal side-effect free nodes are merged.
+     * Finally dead nodes and advices that are only constrained are removed.
+     */
+    struct NativeSimplify : PassBase
+    {
+        circuit_owner_t run( circuit_owner_t &&circuit ) override;
+
+        std::size_t max_sweeps = 8;
+    };
+
+
     struct DummyPass : PassBase
     {
         circuit_owner_t run( circuit_owner_t &&circuit ) override { return std::move( circuit ); }
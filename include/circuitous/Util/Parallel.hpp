@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2022 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace circ
+{
+    static inline std::size_t hardware_threads()
+    {
+        auto count = std::thread::hardware_concurrency();
+        return ( count == 0 ) ? 1 : count;
+    }
+
+    // Multi-producer multi-consumer queue with a fixed capacity.
+    // `push` blocks while the queue is full, `pop` blocks while it is empty. Once the queue
+    // is `close`d and drained, `pop` returns `std::nullopt` - this is how consumers learn
+    // there will be no more work.
+    template< typename T >
+    struct bounded_queue
+    {
+        using value_type = T;
+
+      private:
+        std::mutex mtx;
+        std::condition_variable not_full;
+        std::condition_variable not_empty;
+
+        std::deque< T > items;
+        std::size_t capacity;
+        bool closed = false;
+
+      public:
+        explicit bounded_queue( std::size_t capacity )
+            : capacity( ( capacity == 0 ) ? 1 : capacity )
+        {}
+
+        bounded_queue( const bounded_queue & ) = delete;
+        bounded_queue &operator=( const bounded_queue & ) = delete;
+
+        // Returns `false` if the queue was closed and `item` was therefore dropped.
+        bool push( T item )
+        {
+            std::unique_lock lock( mtx );
+            not_full.wait( lock, [ & ] { return closed || items.size() < capacity; } );
+            if ( closed )
+                return false;
+
+            items.push_back( std::move( item ) );
+            lock.unlock();
+            not_empty.notify_one();
+            return true;
+        }
+
+        std::optional< T > pop()
+        {
+            std::unique_lock lock( mtx );
+            not_empty.wait( lock, [ & ] { return closed || !items.empty(); } );
+            if ( items.empty() )
+                return {};
+
+            auto out = std::move( items.front() );
+            items.pop_front();
+            lock.unlock();
+            not_full.notify_one();
+            return out;
+        }
+
+        // Items already in the queue can still be popped.
+        void close()
+        {
+            {
+                std::lock_guard lock( mtx );
+                closed = true;
+            }
+            not_full.notify_all();
+            not_empty.notify_all();
+        }
+    };
+
+} // namespace circ
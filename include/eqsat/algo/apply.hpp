@@ -47,7 +47,7 @@ namespace eqsat {
         node_handle apply() { return apply(rule.rhs.action); }
 
         applier(const rewrite_rule &rule, const match_result &where, saturable_egraph< egraph > &graph)
-            : rule(rule), places(gather_places(rule.lhs)), where(where), graph(graph)
+            : rule(rule), places(rule.program.places), where(where), graph(graph)
         {}
 
         const rewrite_rule &rule;
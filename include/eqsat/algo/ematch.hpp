@@ -14,6 +14,7 @@
 #include <spdlog/spdlog.h>
 #include <fmt/ranges.h>
 #include <iostream>
+#include <optional>
 #include <span>
 
 namespace eqsat
@@ -101,251 +102,132 @@ namespace eqsat
         return std::visit([&] (const auto &m) -> stream& { return os << m; }, _m);
     }
 
-    using match_generator = gap::recursive_generator< match_result >;
-
-    using single_match_generator = gap::recursive_generator< single_match_result >;
-
 } // namespace eqsat
 
 namespace eqsat {
 
+    //
+    // e-matching machine
+    //
+    // Executes a compiled `match_program` on the egraph. Backtracking follows the
+    // native call stack, one frame per active scan, hence matching allocates only
+    // the registers and the reported results.
+    //
     template< gap::graph::graph_like egraph >
     struct matcher {
         using node_type = typename egraph::node_type;
-        using eclass_type = typename egraph::eclass_type;
-
-        //
-        // match constant node
-        //
-        auto match(const constant_t &c, const node_type &n, const matched_places_t &matched)
-            -> single_match_generator
-        {
-            if (auto con = extract_constant(n)) {
-                if (con.value() == c.ref()) {
-                    // spdlog::debug("[eqsat] matched constant {} with {}", c, con.value());
-                    co_yield { graph.find(&n), matched };
-                }
-            }
-        }
-
-        //
-        // match operation node
-        //
-        auto match(const operation_t &o, const node_type &n, const matched_places_t &matched)
-            -> single_match_generator
-        {
-            if (node_name(n) == o.ref()) {
-                // spdlog::debug("[eqsat] matched op {} with {}", o, node_name(n));
-                co_yield { graph.find(&n), matched };
-            }
-        }
-
-        //
-        // match place node
-        //
-        auto match(const place_t &p, const node_type &n, const matched_places_t &matched)
-            -> single_match_generator
-        {
-            auto id = std::uint32_t(place_index(p, places));
-            auto handle = graph.find(&n);
-            if (auto it = matched.find(id); it != matched.end()) {
-                if (it->second.handle() != handle) {
-                    co_return;
-                }
-            }
-
-            // spdlog::debug("[eqsat] matched place {} with {}", p, node_name(n));
-
-            single_match_result result = { handle, matched };
-            result.matched_places.emplace(id, maybe_node_handle(handle));
-            co_yield result;
-        }
 
-        //
-        // match label node
-        //
-        auto match(const label_t &lab, const node_type &n, const matched_places_t &matched)
-            -> single_match_generator
-        {
-            co_yield match(get_expr_with_name(lab, pattern).expr, n, matched);
-        }
-
-        //
-        // match atom node
-        //
-        auto match(const atom_t &a, const node_type &n, const matched_places_t &matched)
-            -> single_match_generator
-        {
-            const atom_base &base = a;
-            co_yield std::visit([&] (const auto &atom) -> single_match_generator {
-                co_yield match(atom, n, matched);
-            }, base);
-        }
-
-        auto match_children(const auto &pattern_children, const auto &node_children, const matched_places_t &matched)
-            -> single_match_generator
-        {
-            auto front = graph.eclass(node_children.front());
-            auto front_match = match(pattern_children.front(), front, matched);
-
-            if (pattern_children.size() == 1) {
-                co_yield front_match;
-            } else {
-                for (auto m : front_match) {
-                    co_yield match_children(tail(pattern_children), tail(node_children), matched_places(m));
-                }
-            }
-        }
+        matcher(const match_program &program, const egraph &graph)
+            : program(program), graph(graph)
+            , eclasses(program.eclass_registers, graph::node_handle(node_id_t(0)))
+            , enodes(program.enode_registers, nullptr)
+        {}
 
-        //
-        // match list piecewise
-        //
-        auto match(const expr_list &list, const node_type &n, const matched_places_t &matched)
-            -> single_match_generator
-        {
-            for (auto head : match(list.front(), n, matched)) {
-                auto pattern_children = tail(list);
-
-                if (pattern_children.empty()) {
-                    co_yield head;
-                } else {
-                    if (pattern_children.size() != n.num_of_children()) {
-                        co_return;
+        void run(auto &&yield) { run(0, yield); }
+
+      private:
+        void run(std::size_t pc, auto &yield) {
+            for (; pc < program.code.size(); ++pc) {
+                const auto &inst = program.code[pc];
+                switch (inst.op) {
+                    case opcode::scan_eclasses: {
+                        auto next = [&] (const auto &entry) {
+                            eclasses[inst.dst] = entry.first;
+                            run(pc + 1, yield);
+                        };
+
+                        if (inst.arg == instruction::any_operation) {
+                            graph.for_each_eclass(next);
+                        } else {
+                            graph.for_each_eclass(symbol_t{ inst.arg }, next);
+                        }
+                        return;
                     }
-
-                    std::vector< graph::node_handle > node_children;
-                    for (auto ch : n.children()) {
-                        node_children.push_back(ch);
+                    case opcode::scan_nodes: {
+                        for (const node_type *n : graph.eclass(eclasses[inst.src]).nodes) {
+                            enodes[inst.dst] = n;
+                            run(pc + 1, yield);
+                        }
+                        return;
                     }
-
-                    auto head_matched = matched_places(head);
-                    for (auto m : match_children(pattern_children, node_children, head_matched)) {
-                        co_yield { head.root, matched_places(m) };
+                    case opcode::check_operation: {
+                        if (node_symbol(*enodes[inst.src]) != symbol_t{ inst.arg }) {
+                            return;
+                        }
+                        break;
+                    }
+                    case opcode::check_constant: {
+                        auto con = extract_constant(*enodes[inst.src]);
+                        if (!con || !(con.value() == program.constants[inst.arg].ref())) {
+                            return;
+                        }
+                        break;
+                    }
+                    case opcode::load_children: {
+                        const auto *n = enodes[inst.src];
+                        if (n->num_of_children() != inst.arg) {
+                            return;
+                        }
+                        for (std::uint32_t i = 0; i < inst.arg; ++i) {
+                            eclasses[inst.dst + i] = graph.find(n->child(i));
+                        }
+                        break;
+                    }
+                    case opcode::compare: {
+                        if (eclasses[inst.src] != eclasses[inst.dst]) {
+                            return;
+                        }
+                        break;
+                    }
+                    case opcode::yield: {
+                        yield(result());
+                        return;
+                    }
+                    case opcode::unsupported: {
+                        spdlog::error("not implemented commutative_match_expr expr");
+                        __builtin_abort();
                     }
                 }
             }
         }
 
-        //
-        // match expr with context
-        //
-        auto match(const expr_with_context &e, const node_type &n, const matched_places_t &matched)
-            -> single_match_generator
-        {
-            // TODO deal with context matching
-            co_yield match(e.expr, n, matched);
-        }
-
-        //
-        // match simple expr node
-        //
-        auto match(const simple_expr &e, const node_type &n, const matched_places_t &matched)
-            -> single_match_generator
-        {
-            const simple_expr_base &base = e;
-            co_yield std::visit([&] (const auto &a) -> single_match_generator {
-                co_yield match(a, n, matched);
-            }, base);
-        }
-
-        auto match(const simple_expr &e, const eclass_type &eclass, const matched_places_t &matched)
-            -> single_match_generator
-        {
-            for (const auto &n : eclass.nodes) {
-                co_yield match(e, *n, matched);
+        match_result result() const {
+            matched_places_t places;
+            for (std::uint32_t id = 0; id < program.place_registers.size(); ++id) {
+                places.emplace(id, maybe_node_handle(eclasses[program.place_registers[id]]));
             }
-        }
 
-        //
-        // generate matches of expr for whole egraph
-        //
-        single_match_generator match(const simple_expr &expr, const matched_places_t &matched) {
-            for (const auto &[_, eclass] : graph.eclasses()) {
-                for (auto m : match(expr, eclass, matched)) {
-                    if (matched_places(m).size() == places.size()) {
-                        //spdlog::debug("[eqsat] matched {}", m);
-                        co_yield m;
-                    }
-                }
+            if (!program.multi_match) {
+                return single_match_result{ eclasses[program.roots.front().second], std::move(places) };
             }
-        }
-
-        single_match_generator match(const simple_expr &expr) {
-            matched_places_t matched;
-            co_yield match(expr, matched);
-        }
 
-        single_match_generator match(const expr_with_context &e, const matched_places_t &matched)
-        {
-            // TODO deal with context matching
-            co_yield match(e.expr, matched);
-        }
-
-        //
-        // labeled multi-match
-        //
-        single_match_generator match(const label_t &lab, const matched_places_t &matched)
-        {
-            co_yield match(get_expr_with_name(lab, pattern).expr, matched);
-        }
-
-        match_generator match(std::vector< label_t > labels, multi_match_result partial_result) {
-            auto label = labels.back();
-            labels.pop_back();
-
-            for (auto m : match(label, partial_result.matched_places)) {
-                multi_match_result result = partial_result;
-                result.insert(label, std::move(m));
-
-                if (labels.empty()) {
-                    co_yield result;
-                } else {
-                    co_yield match(labels, result);
-                }
+            multi_match_result multi;
+            for (const auto &[label, reg] : program.roots) {
+                multi.roots.emplace(label, eclasses[reg]);
             }
+            multi.matched_places = std::move(places);
+            return multi;
         }
 
-        match_generator match(const basic_match_expr &expr) {
-            multi_match_result result;
-            co_yield match(expr.labels, result);
-        }
-
-        match_generator match(const commutative_match_expr &expr) {
-            spdlog::error("not implemented basic_match_expr expr");
-            __builtin_abort();
-        }
-
-        match_generator match(const match_expr &expr) {
-            co_yield std::visit([&] (const auto &a) -> match_generator {
-                co_yield match(a);
-            }, expr);
-        }
-
-        match_generator match() {
-            co_yield std::visit([&] (const auto &a) -> match_generator {
-                for (auto &&m : match(a)) {
-                    co_yield std::forward< decltype(m) >(m);
-                }
-            }, pattern.action);
-        }
-
-        matcher(const match_pattern &pattern, const egraph &graph)
-            : pattern(pattern), graph(graph), places(gather_places(pattern))
-        {}
-
-        matcher(const rewrite_rule &rule, const egraph &graph)
-            : matcher(rule.lhs, graph)
-        {}
-
-        const match_pattern &pattern;
+        const match_program &program;
         const egraph &graph;
-        places_t places;
+
+        std::vector< graph::node_handle > eclasses;
+        std::vector< const node_type * > enodes;
     };
 
     template< gap::graph::graph_like egraph >
-    match_generator match(const rewrite_rule &rule, const egraph &graph) {
-        // spdlog::debug("[eqsat] match rule {}", rule);
-        co_yield matcher(rule, graph).match();
+    void for_each_match(const rewrite_rule &rule, const egraph &graph, auto &&yield) {
+        matcher(rule.program, graph).run(yield);
+    }
+
+    template< gap::graph::graph_like egraph >
+    std::vector< match_result > match(const rewrite_rule &rule, const egraph &graph) {
+        std::vector< match_result > results;
+        for_each_match(rule, graph, [&] (match_result &&m) {
+            results.push_back(std::move(m));
+        });
+        return results;
     }
 
 } // namespace eqsat
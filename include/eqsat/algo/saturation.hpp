@@ -6,13 +6,30 @@
 
 #include <eqsat/algo/ematch.hpp>
 #include <eqsat/algo/apply.hpp>
+#include <eqsat/algo/scheduler.hpp>
 
 #include <eqsat/core/egraph.hpp>
 #include <eqsat/core/cost_graph.hpp>
+#include <eqsat/core/snapshot.hpp>
 
 #include <eqsat/pattern/rule_set.hpp>
 #include <eqsat/pattern/rewrite_rule.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace eqsat
 {
@@ -28,19 +45,27 @@ namespace eqsat
 
     } // namespace action
 
+    static inline double elapsed_ms(std::chrono::steady_clock::time_point since) {
+        using ms = std::chrono::duration< double, std::milli >;
+        return std::chrono::duration_cast< ms >(std::chrono::steady_clock::now() - since).count();
+    }
+
     template< gap::graph::graph_like egraph >
     struct saturable_egraph : egraph {
 
         using base = egraph;
 
-        using handle_hash = typename base::handle_hash;
+        using handle_hash  = typename base::handle_hash;
+        using node_pointer = typename base::node_pointer;
+
+        saturable_egraph() = default;
 
         explicit saturable_egraph(egraph &&graph)
             : egraph(std::forward< egraph >(graph))
         {}
 
         node_handle merge(node_handle lhs, node_handle rhs) {
-            // TODO perform atomically
+            assert(!this->frozen() && "merge of a frozen egraph");
             auto lid = find(lhs.id);
             auto rid = find(rhs.id);
 
@@ -54,6 +79,7 @@ namespace eqsat
 
             // TODO maybe can be moved to rebuild?
             merge_eclasses(node_handle(lid), node_handle(rid));
+            ++_merges;
 
             return { merge(lid, rid) };
         }
@@ -62,35 +88,102 @@ namespace eqsat
 
         // Restores the egraph invariants, i.e, congruence equality and enode uniqueness
         void rebuild() {
-            for (auto eclass : _pending) {
-                this->canonicalize(eclass);
+            std::unordered_set< node_handle, handle_hash > changed_classes;
+            while (!_pending.empty()) {
+                std::unordered_set< node_handle, handle_hash > todo;
+                for (auto eclass : std::exchange(_pending, {})) {
+                    todo.insert(find(eclass));
+                }
+
+                // repairs may merge other classes and put them on the worklist
+                for (auto eclass : todo) {
+                    repair(eclass);
+                    changed_classes.insert(eclass);
+                }
             }
 
-            std::unordered_set< node_handle, handle_hash > changed_classes;
+            remove_duplicates(changed_classes);
+            this->compact_eclasses();
+        }
+
+        // number of merges that joined two distinct classes
+        std::size_t num_of_merges() const { return _merges; }
+
+        // pending classes are part of the snapshot, i.e., the egraph does not have to be
+        // rebuilt before it is saved
+        void save(snapshot_output &out) const {
+            base::save(out);
+            out.write(_merges);
+            out.write(_pending.size());
             for (auto eclass : _pending) {
-                changed_classes.insert(find(eclass));
+                out.write(eclass.id.ref());
             }
+        }
 
-            for (auto eclass : changed_classes) {
-                this->repair(eclass);
+        void load(snapshot_input &in) {
+            base::load(in);
+            _merges = in.read< std::size_t >();
+            for (auto size = in.read< std::size_t >(); size; --size) {
+                auto id = in.read< node_id_t::underlying_t >();
+                if (id >= this->num_of_ids()) {
+                    throw snapshot_error("invalid pending eclass in snapshot");
+                }
+                _pending.emplace_back(node_id_t(id));
             }
-
-            _pending.clear();
         }
 
-        void match_and_apply(const rewrite_rule &rule) {
-            auto &graph = *this;
+        std::vector< match_result > collect_matches(const rewrite_rule &rule) const {
+            return match(rule, *this);
+        }
 
-            std::vector< match_result > results;
-            for (const auto &m : match(rule, graph)) {
-                results.push_back(m);
+        // Read phase: all rules are matched against the same frozen egraph, by up to
+        // `workers` threads with one rule per task. Matches of a rule do not depend on
+        // other rules, hence results (in the order of `rules`) do not depend on the
+        // number of threads either. If `search_ms` is not empty, it receives the time
+        // of matching of each rule.
+        std::vector< std::vector< match_result > > collect_matches(
+            std::span< const rewrite_rule * const > rules, std::size_t workers,
+            std::span< double > search_ms = {}
+        ) {
+            assert(search_ms.empty() || search_ms.size() == rules.size());
+            std::vector< std::vector< match_result > > results(rules.size());
+
+            this->freeze();
+            std::atomic< std::size_t > next = 0;
+            auto worker = [&] {
+                for (auto idx = next++; idx < rules.size(); idx = next++) {
+                    auto start = std::chrono::steady_clock::now();
+                    results[idx] = collect_matches(*rules[idx]);
+                    if (!search_ms.empty()) {
+                        search_ms[idx] = elapsed_ms(start);
+                    }
+                }
+            };
+
+            workers = std::min(workers, rules.size());
+            if (workers <= 1) {
+                worker();
+            } else {
+                std::vector< std::jthread > pool;
+                for (std::size_t i = 0; i < workers; ++i) {
+                    pool.emplace_back(worker);
+                }
             }
+            this->thaw();
 
+            return results;
+        }
+
+        void apply_matches(const rewrite_rule &rule, const std::vector< match_result > &results) {
             for (const auto &m : results) {
-                apply(rule, m, graph);
+                apply(rule, m, *this);
             }
         }
 
+        void match_and_apply(const rewrite_rule &rule) {
+            apply_matches(rule, collect_matches(rule));
+        }
+
         auto apply_action( action::rebuild ) && {
             rebuild();
             return std::move( *this );
@@ -103,9 +196,64 @@ namespace eqsat
 
       private:
 
+        // Parents of a changed class are the only enodes that might have become
+        // congruent. They are rehashed with canonical children, and whenever a parent
+        // collides with another enode in memo, their classes are merged and the parent
+        // is scheduled for removal.
+        void repair(node_handle eclass) {
+            // copy, merges below invalidate the class
+            auto parents = this->eclass(eclass).parents;
+            std::erase_if(parents, [&] (auto parent) { return _duplicates.count(parent); });
+
+            for (auto parent : parents) {
+                this->unhash(parent);
+            }
+
+            for (auto parent : parents) {
+                this->canonicalize(*parent);
+            }
+
+            for (auto parent : parents) {
+                if (auto repr = this->hashcons(parent); repr != parent) {
+                    merge(find(repr), find(parent));
+                    _duplicates.insert(parent);
+                }
+            }
+        }
+
+        // Removes congruent duplicates from classes and parent lists.
+        void remove_duplicates(const std::unordered_set< node_handle, handle_hash > &changed) {
+            std::unordered_set< node_handle, handle_hash > affected;
+            for (auto eclass : changed) {
+                affected.insert(find(eclass));
+            }
+
+            for (auto dup : _duplicates) {
+                affected.insert(find(dup));
+                for (auto ch : dup->_children) {
+                    affected.insert(find(ch));
+                }
+            }
+
+            auto is_duplicate = [&] (auto node) { return _duplicates.count(node); };
+            for (auto eclass : affected) {
+                auto &cls = this->slot(eclass).second;
+                std::erase_if(cls.nodes, is_duplicate);
+
+                std::unordered_set< node_pointer > seen;
+                std::erase_if(cls.parents, [&] (auto parent) {
+                    return is_duplicate(parent) || !seen.insert(parent).second;
+                });
+            }
+
+            this->remove_nodes(_duplicates);
+            _duplicates.clear();
+        }
+
         void merge_eclasses(node_handle lhs, node_handle rhs) {
-            auto eclass = this->_classes.extract(rhs).mapped();
-            this->_classes[lhs].merge(std::move(eclass));
+            this->reindex_operators(lhs, rhs);
+            auto eclass = this->extract_eclass(rhs);
+            this->slot(lhs).second.merge(std::move(eclass));
         }
 
         node_id_t find(node_id_t id) { return this->_unions.find(id); }
@@ -120,12 +268,17 @@ namespace eqsat
 
         // modified eclasses that needs to be rebuild
         std::vector< node_handle > _pending;
+
+        // enodes congruent to some other enode, removed at the end of rebuild
+        std::unordered_set< node_pointer > _duplicates;
+
+        std::size_t _merges = 0;
     };
 
     // return value of equality saturation
     enum class stop_reason
     {
-        saturated, iteration_limit, node_limit, time_limit, unknown, none
+        saturated, iteration_limit, node_limit, memory_limit, time_limit, unknown, none
     };
 
     std::string to_string(stop_reason reason);
@@ -133,48 +286,464 @@ namespace eqsat
     template< gap::graph::graph_like egraph >
     using saturation_result = std::pair< saturable_egraph< egraph >, stop_reason >;
 
+    static inline std::size_t hardware_workers() {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Budgets of the saturation, zero disables the respective limit. Limits are checked
+    // after each applied rule, so they can be exceeded by the matches of one rule. The
+    // memory limit is checked once per iteration only, as measuring the size of the egraph
+    // walks all of it, hence it can be exceeded by the matches of one iteration.
+    struct saturation_config {
+        std::size_t iteration_limit = 30;
+        std::size_t node_limit      = 100'000;
+        // approximate size of the egraph in bytes
+        std::size_t memory_limit    = 0;
+        std::chrono::milliseconds time_limit = std::chrono::seconds(60);
+
+        // backoff scheduler, see `backoff_scheduler`
+        bool backoff            = true;
+        std::size_t match_limit = 1'000;
+        std::size_t ban_length  = 5;
+
+        // number of threads matching rules
+        std::size_t workers = hardware_workers();
+
+        // collect statistics of each rule in `iteration_stats::rules`
+        bool profile = false;
+
+        // snapshot of the saturation is written to `checkpoint` after every
+        // `checkpoint_interval` iterations and when the saturation stops on a limit;
+        // empty path disables checkpoints
+        std::filesystem::path checkpoint;
+        std::size_t checkpoint_interval = 5;
+    };
+
+    // statistics of a rule in one iteration
+    struct rule_profile {
+        std::string rule;
+
+        std::size_t matches = 0;
+        // matches were not applied, the rule was banned by the scheduler
+        bool banned = false;
+
+        double search_ms = 0;
+        double apply_ms  = 0;
+
+        // enodes added and classes merged by the rule before the rebuild
+        std::size_t new_nodes = 0;
+        std::size_t merges    = 0;
+    };
+
+    struct iteration_stats {
+        std::size_t iteration = 0;
+
+        // size of the egraph after the rebuild
+        std::size_t nodes   = 0;
+        std::size_t classes = 0;
+
+        // number of applied matches
+        std::size_t applied = 0;
+        // number of rules banned in this iteration
+        std::size_t banned  = 0;
+
+        double search_ms  = 0;
+        double apply_ms   = 0;
+        double rebuild_ms = 0;
+        // filled by an observer of the saturation, if it extracts the egraph
+        double extract_ms = 0;
+
+        // rules matched in the iteration, only with `saturation_config::profile`
+        std::vector< rule_profile > rules;
+    };
+
+    std::string to_string(const iteration_stats &stats);
+
+    struct saturation_stats {
+        std::vector< iteration_stats > iterations;
+        stop_reason reason = stop_reason::none;
+        double total_ms = 0;
+    };
+
+    //
+    // reports of saturation statistics
+    //
+    // CSV has a row per iteration and rule, or a single row of an iteration without
+    // profile; JSON is an object with an array of iterations. Both are labeled by the
+    // name of the saturated workload.
+    //
+    std::string_view csv_header();
+
+    void write_csv(std::ostream &os, std::string_view workload, const saturation_stats &stats);
+
+    void write_json(std::ostream &os, std::string_view workload, const saturation_stats &stats);
+
+    //
+    // snapshot of equality saturation
+    //
+    // Contains everything needed to continue the saturation, i.e., the egraph with its
+    // pending classes, the next iteration and statistics of the rule scheduler.
+    //
+    // Identifies the egraph a saturation started from, so that a snapshot is not resumed
+    // on a different one. Symbols are process-local, hence the hash is computed from the
+    // serialized egraph instead of the hashes of its enodes.
+    struct egraph_fingerprint {
+        std::size_t nodes = 0;
+        std::uint64_t hash = 0;
+
+        bool operator==(const egraph_fingerprint &) const = default;
+    };
+
+    template< gap::graph::graph_like egraph >
+    egraph_fingerprint fingerprint(const saturable_egraph< egraph > &graph) {
+        std::ostringstream os;
+        snapshot_output out(os);
+        graph.save(out);
+
+        // FNV-1a
+        std::uint64_t hash = 0xcbf29ce484222325;
+        for (unsigned char ch : os.str()) {
+            hash = (hash ^ ch) * 0x100000001b3;
+        }
+        return { graph.num_of_nodes(), hash };
+    }
+
+    template< gap::graph::graph_like egraph >
+    struct saturation_snapshot {
+        saturable_egraph< egraph > graph;
+        std::size_t iteration = 0;
+        backoff_scheduler::state scheduler;
+        // fingerprint of the egraph before the first iteration, computed by `saturate`
+        // when a checkpoint is requested
+        std::optional< egraph_fingerprint > origin = std::nullopt;
+    };
+
+    static constexpr std::uint32_t snapshot_magic   = 0x4e535145; // "EQSN"
+    static constexpr std::uint32_t snapshot_version = 3;
+
+    template< gap::graph::graph_like egraph >
+    void save_snapshot(
+        std::ostream &os,
+        const saturable_egraph< egraph > &graph,
+        std::size_t iteration,
+        const backoff_scheduler::state &scheduler,
+        const std::optional< egraph_fingerprint > &origin = std::nullopt
+    ) {
+        snapshot_output out(os);
+        out.write(snapshot_magic);
+        out.write(snapshot_version);
+        out.write(iteration);
+
+        out.write(origin.has_value());
+        if (origin) {
+            out.write(origin->nodes);
+            out.write(origin->hash);
+        }
+
+        out.write(scheduler.size());
+        for (const auto &[name, stats] : scheduler) {
+            out.write(std::string_view(name));
+            out.write(stats.times_applied);
+            out.write(stats.times_banned);
+            out.write(stats.banned_until);
+        }
+
+        graph.save(out);
+        if (!out.good()) {
+            throw snapshot_error("failed to write snapshot");
+        }
+    }
+
+    template< gap::graph::graph_like egraph >
+    saturation_snapshot< egraph > load_snapshot(std::istream &is) {
+        snapshot_input in(is);
+        if (in.read< std::uint32_t >() != snapshot_magic) {
+            throw snapshot_error("not an egraph snapshot");
+        }
+        if (in.read< std::uint32_t >() != snapshot_version) {
+            throw snapshot_error("unsupported version of egraph snapshot");
+        }
+
+        saturation_snapshot< egraph > snapshot;
+        snapshot.iteration = in.read< std::size_t >();
+
+        if (in.read_bool()) {
+            egraph_fingerprint origin;
+            origin.nodes = in.read< std::size_t >();
+            origin.hash  = in.read< std::uint64_t >();
+            snapshot.origin = origin;
+        }
+
+        for (auto rules = in.read< std::size_t >(); rules; --rules) {
+            auto name = in.read_string();
+            backoff_scheduler::rule_stats stats;
+            stats.times_applied = in.read< std::size_t >();
+            stats.times_banned  = in.read< std::size_t >();
+            stats.banned_until  = in.read< std::size_t >();
+            snapshot.scheduler.emplace_back(std::move(name), stats);
+        }
+
+        snapshot.graph.load(in);
+        return snapshot;
+    }
+
+    // The snapshot is written to a temporary file first, hence a previous snapshot at
+    // `path` is replaced only by a complete one.
+    template< gap::graph::graph_like egraph >
+    void save_snapshot(
+        const std::filesystem::path &path,
+        const saturable_egraph< egraph > &graph,
+        std::size_t iteration,
+        const backoff_scheduler::state &scheduler,
+        const std::optional< egraph_fingerprint > &origin = std::nullopt
+    ) {
+        auto tmp = path;
+        tmp += ".tmp";
+        {
+            std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+            if (!os) {
+                throw snapshot_error("cannot open snapshot file " + tmp.string());
+            }
+            save_snapshot(os, graph, iteration, scheduler, origin);
+        }
+        std::filesystem::rename(tmp, path);
+    }
+
+    template< gap::graph::graph_like egraph >
+    saturation_snapshot< egraph > load_snapshot(const std::filesystem::path &path) {
+        std::ifstream is(path, std::ios::binary);
+        if (!is) {
+            throw snapshot_error("cannot open snapshot file " + path.string());
+        }
+        return load_snapshot< egraph >(is);
+    }
+
     //
     // step of equality saturation
     //
 
+    // Applies every rule once, regardless of the number of its matches; returns
+    // `saturated` if the step neither added an enode nor merged any classes.
+    // All rules are matched (in parallel) before any of them is applied.
     template< gap::graph::graph_like egraph >
     saturation_result< egraph > make_step(
         saturable_egraph< egraph > &&graph,
-        std::span< rule_set > sets
+        std::span< rule_set > sets,
+        std::size_t workers = hardware_workers()
     ) {
         spdlog::debug("[eqsat] saturation step");
-        // TODO: paralelize
 
+        auto nodes  = graph.num_of_nodes();
+        auto merges = graph.num_of_merges();
+
+        std::vector< const rewrite_rule * > rules;
         for (const auto &set : sets) {
-            spdlog::debug("[eqsat] applying sreule set {}", set.name);
             for (const auto &rule : set.rules) {
-                graph = std::move(graph) | action::match_and_apply{ rule };
+                rules.push_back(&rule);
             }
         }
 
-        return { std::move(graph), stop_reason::unknown };
+        auto matches = graph.collect_matches(rules, workers);
+        for (std::size_t idx = 0; idx < rules.size(); ++idx) {
+            graph.apply_matches(*rules[idx], matches[idx]);
+        }
+
+        graph = std::move(graph) | action::rebuild{};
+
+        auto changed = graph.num_of_nodes() != nodes || graph.num_of_merges() != merges;
+        return { std::move(graph), changed ? stop_reason::none : stop_reason::saturated };
     }
 
     //
     // generic saturation algorithm
     //
-    template< gap::graph::graph_like egraph >
+    // Continues the saturation from the snapshot; limits other than the iteration limit
+    // apply to the continued run only. The observer is called with the rebuilt egraph
+    // and the statistics of each iteration.
+    //
+    template< gap::graph::graph_like egraph, typename observer_t >
     saturation_result< egraph > saturate(
-        saturable_egraph< egraph > &&graph,
-        std::span< rule_set > rules
+        saturation_snapshot< egraph > &&snapshot,
+        std::span< rule_set > rules,
+        const saturation_config &config,
+        saturation_stats &stats,
+        observer_t &&observer
     ) {
+        using clock = std::chrono::steady_clock;
+
         spdlog::debug("[eqsat] saturate start");
-        // egraph.rebuild()
 
-        stop_reason status = stop_reason::none;
-        while (status == stop_reason::none) {
-            auto [g, s] = make_step(std::move(graph), rules);
-            graph = std::move(g);
-            status = s;
+        auto graph = std::move(snapshot.graph);
+        auto start = clock::now();
+        auto exceeded = [&] (bool check_memory) -> std::optional< stop_reason > {
+            if (config.node_limit && graph.num_of_nodes() > config.node_limit)
+                return stop_reason::node_limit;
+            if (check_memory && config.memory_limit && graph.size_in_bytes() > config.memory_limit)
+                return stop_reason::memory_limit;
+            if (config.time_limit.count() && clock::now() - start > config.time_limit)
+                return stop_reason::time_limit;
+            return std::nullopt;
+        };
+
+        backoff_scheduler scheduler(rules, config.match_limit, config.ban_length);
+        scheduler.restore(snapshot.scheduler);
+
+        // a fresh saturation starts from the snapshot's egraph
+        auto origin = snapshot.origin;
+        if (!origin && !config.checkpoint.empty())
+            origin = fingerprint(graph);
+
+        // number of completed iterations, i.e., the iteration to continue with
+        auto completed = snapshot.iteration;
+        auto checkpoint = [&] {
+            if (config.checkpoint.empty())
+                return;
+            save_snapshot(config.checkpoint, graph, completed, scheduler.save(), origin);
+            spdlog::debug("[eqsat] checkpoint at iteration {}", completed);
+        };
+
+        auto stop = [&] (stop_reason reason) -> saturation_result< egraph > {
+            if (reason != stop_reason::saturated)
+                checkpoint();
+
+            stats.reason   = reason;
+            stats.total_ms = elapsed_ms(start);
+            spdlog::debug("[eqsat] saturate stop {}", to_string(reason));
+            return { std::move(graph), reason };
+        };
+
+        graph.rebuild();
+        for (std::size_t iteration = snapshot.iteration;; ++iteration) {
+            if (config.iteration_limit && iteration >= config.iteration_limit)
+                return stop(stop_reason::iteration_limit);
+            if (auto reason = exceeded(true))
+                return stop(reason.value());
+
+            iteration_stats current{ .iteration = iteration };
+            auto nodes  = graph.num_of_nodes();
+            auto merges = graph.num_of_merges();
+
+            // all rules are matched against the same egraph, then applied
+            auto search_start = clock::now();
+            std::vector< std::size_t > active;
+            std::vector< const rewrite_rule * > active_rules;
+            for (std::size_t idx = 0; idx < scheduler.size(); ++idx) {
+                if (config.backoff && scheduler.banned(idx, iteration))
+                    continue;
+                active.push_back(idx);
+                active_rules.push_back(&scheduler.rule(idx));
+            }
+
+            std::vector< double > search_ms(config.profile ? active.size() : 0);
+            auto found = graph.collect_matches(active_rules, config.workers, search_ms);
+
+            if (config.profile) {
+                for (std::size_t i = 0; i < active.size(); ++i) {
+                    current.rules.push_back({
+                        .rule = active_rules[i]->name,
+                        .matches = found[i].size(),
+                        .search_ms = search_ms[i]
+                    });
+                }
+            }
+
+            // matches of admitted rules by their position in `active`
+            std::vector< std::pair< std::size_t, std::vector< match_result > > > matches;
+            for (std::size_t i = 0; i < active.size(); ++i) {
+                auto idx = active[i];
+                auto &results = found[i];
+                if (config.backoff && !scheduler.admit(idx, iteration, results.size())) {
+                    spdlog::debug("[eqsat] banning rule {} with {} matches",
+                        scheduler.rule(idx).name, results.size()
+                    );
+                    current.banned++;
+                    if (config.profile)
+                        current.rules[i].banned = true;
+                    continue;
+                }
+
+                if (!results.empty())
+                    matches.emplace_back(i, std::move(results));
+            }
+            current.search_ms = elapsed_ms(search_start);
+
+            auto apply_start = clock::now();
+            std::optional< stop_reason > reason;
+            for (const auto &[i, results] : matches) {
+                auto rule_start  = clock::now();
+                auto rule_nodes  = graph.num_of_nodes();
+                auto rule_merges = graph.num_of_merges();
+
+                graph.apply_matches(*active_rules[i], results);
+                current.applied += results.size();
+
+                if (config.profile) {
+                    auto &profile     = current.rules[i];
+                    profile.apply_ms  = elapsed_ms(rule_start);
+                    profile.new_nodes = graph.num_of_nodes() - rule_nodes;
+                    profile.merges    = graph.num_of_merges() - rule_merges;
+                }
+
+                if ((reason = exceeded(false)))
+                    break;
+            }
+            current.apply_ms = elapsed_ms(apply_start);
+
+            auto rebuild_start = clock::now();
+            graph.rebuild();
+            current.rebuild_ms = elapsed_ms(rebuild_start);
+
+            current.nodes   = graph.num_of_nodes();
+            current.classes = graph.num_of_eclasses();
+            observer(std::as_const(graph), current);
+            spdlog::debug("[eqsat] {}", to_string(current));
+            stats.iterations.push_back(std::move(current));
+
+            completed = iteration + 1;
+            if (reason)
+                return stop(reason.value());
+
+            if (config.checkpoint_interval && completed % config.checkpoint_interval == 0)
+                checkpoint();
+
+            if (graph.num_of_nodes() == nodes && graph.num_of_merges() == merges) {
+                // rules skipped in this iteration might still change the egraph
+                if (!config.backoff || !scheduler.any_banned(iteration))
+                    return stop(stop_reason::saturated);
+                scheduler.unban_all(iteration + 1);
+            }
         }
+    }
 
-        spdlog::debug("[eqsat] saturate stop {}", to_string(status));
-        return { std::move(graph), status };
+    template< gap::graph::graph_like egraph >
+    saturation_result< egraph > saturate(
+        saturation_snapshot< egraph > &&snapshot,
+        std::span< rule_set > rules,
+        const saturation_config &config,
+        saturation_stats &stats
+    ) {
+        auto ignore = [] (const saturable_egraph< egraph > &, iteration_stats &) {};
+        return saturate(std::move(snapshot), rules, config, stats, ignore);
+    }
+
+    template< gap::graph::graph_like egraph >
+    saturation_result< egraph > saturate(
+        saturable_egraph< egraph > &&graph,
+        std::span< rule_set > rules,
+        const saturation_config &config,
+        saturation_stats &stats
+    ) {
+        return saturate(saturation_snapshot< egraph >{ std::move(graph) }, rules, config, stats);
+    }
+
+    template< gap::graph::graph_like egraph >
+    saturation_result< egraph > saturate(
+        saturable_egraph< egraph > &&graph,
+        std::span< rule_set > rules,
+        const saturation_config &config = {}
+    ) {
+        saturation_stats stats;
+        return saturate(std::move(graph), rules, config, stats);
     }
 
     template< gap::graph::graph_like egraph >
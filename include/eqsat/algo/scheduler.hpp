@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <eqsat/pattern/rule_set.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace eqsat
+{
+    //
+    // Backoff rule scheduler (as in egg)
+    //
+    // Rules that produce more matches than their threshold are banned for a number of
+    // iterations instead of being applied. Each ban doubles both the threshold and the
+    // length of the next ban of the rule, therefore rules such as associativity or
+    // commutativity cannot flood the egraph, but still get applied eventually.
+    //
+    struct backoff_scheduler {
+
+        struct rule_stats {
+            std::size_t times_applied = 0;
+            std::size_t times_banned  = 0;
+            std::size_t banned_until  = 0;
+        };
+
+        // statistics of rules by their names, independent of the order of rule sets
+        using state = std::vector< std::pair< std::string, rule_stats > >;
+
+        backoff_scheduler(std::span< rule_set > sets, std::size_t match_limit, std::size_t ban_length)
+            : match_limit(match_limit), ban_length(ban_length)
+        {
+            for (const auto &set : sets) {
+                for (const auto &rule : set.rules) {
+                    _rules.push_back(&rule);
+                }
+            }
+
+            _stats.resize(_rules.size());
+        }
+
+        std::size_t size() const { return _rules.size(); }
+
+        const rewrite_rule &rule(std::size_t idx) const { return *_rules[idx]; }
+
+        const rule_stats &stats(std::size_t idx) const { return _stats[idx]; }
+
+        bool banned(std::size_t idx, std::size_t iteration) const {
+            return _stats[idx].banned_until > iteration;
+        }
+
+        bool any_banned(std::size_t iteration) const {
+            return std::any_of(_stats.begin(), _stats.end(), [&] (const auto &stats) {
+                return stats.banned_until > iteration;
+            });
+        }
+
+        // Returns `false` if `matches` exceed the threshold of the rule, in which case
+        // the rule is banned and its matches should not be applied.
+        bool admit(std::size_t idx, std::size_t iteration, std::size_t matches) {
+            auto &stats = _stats[idx];
+            auto shift  = std::min< std::size_t >(stats.times_banned, max_shift);
+
+            if (matches > (match_limit << shift)) {
+                stats.times_banned++;
+                stats.banned_until = iteration + (ban_length << shift);
+                return false;
+            }
+
+            stats.times_applied++;
+            return true;
+        }
+
+        // Nothing changed, but some rules are banned - let them run in the next iteration.
+        void unban_all(std::size_t iteration) {
+            for (auto &stats : _stats) {
+                stats.banned_until = std::min(stats.banned_until, iteration);
+            }
+        }
+
+        state save() const {
+            state out;
+            for (std::size_t idx = 0; idx < size(); ++idx) {
+                out.emplace_back(rule(idx).name, _stats[idx]);
+            }
+            return out;
+        }
+
+        // Restores statistics of rules with the same name, other rules start afresh.
+        void restore(const state &saved) {
+            std::unordered_map< std::string_view, const rule_stats * > by_name;
+            for (const auto &[name, stats] : saved) {
+                by_name.emplace(name, &stats);
+            }
+
+            for (std::size_t idx = 0; idx < size(); ++idx) {
+                if (auto it = by_name.find(rule(idx).name); it != by_name.end()) {
+                    _stats[idx] = *it->second;
+                }
+            }
+        }
+
+      private:
+        static constexpr std::size_t max_shift = 20;
+
+        std::size_t match_limit;
+        std::size_t ban_length;
+
+        std::vector< const rewrite_rule * > _rules;
+        std::vector< rule_stats > _stats;
+    };
+
+} // namespace eqsat
@@ -8,13 +8,27 @@
 #include <gap/core/concepts.hpp>
 #include <gap/core/memoize.hpp>
 
+#include <functional>
+#include <optional>
+#include <queue>
+#include <tuple>
 #include <unordered_set>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace eqsat {
 
     using cost_t = double;
 
+    struct extraction_config {
+        // account for sharing, i.e., count the cost of an enode once regardless of
+        // the number of its users in the extracted graph
+        bool dag = false;
+        // upper bound on candidate swaps tried by the DAG local search
+        std::size_t max_trials = 1'000;
+    };
+
     template< gap::graph::graph_like base_graph, typename cost_function_t >
     struct cost_graph : base_graph {
 
@@ -27,35 +41,16 @@ namespace eqsat {
 
         using base_graph::nodes;
         using base_graph::eclass;
+        using base_graph::find;
+
+        using handle_hash = gap::hash< graph::node_handle >;
 
         using nodes_set = std::unordered_set< node_pointer >;
         using cost_map  = std::unordered_map< node_pointer, cost_t >;
 
         struct cost_node { cost_t cost; node_pointer node; };
 
-        // state of dfs algorith to detect loops in egraph
-        struct graph_explore_state {
-            enum class node_state { open, closed };
-
-            std::unordered_map< node_pointer, node_state > nodes;
-
-            void open(node_pointer node) {
-                nodes[node] = node_state::open;
-            }
-
-            void close(node_pointer node) {
-                assert(nodes[node] == node_state::open);
-                nodes[node] = node_state::closed;
-            }
-
-            bool is_loop_edge(node_pointer node) const {
-                return nodes.contains(node) && nodes.at(node) == node_state::open;
-            }
-
-            bool contains(node_pointer node) const {
-                return nodes.contains(node);
-            }
-        };
+        using eclass_cost_map = std::unordered_map< graph::node_handle, cost_node, handle_hash >;
 
         cost_graph(cost_graph &&other) = default;
         cost_graph& operator=(cost_graph &&other) = default;
@@ -69,81 +64,80 @@ namespace eqsat {
                 gap::memoize(std::forward< cost_function_t >(cost_function))
             )
         {
-            // precompute loop nodes to be ommited from cost computation
-            {
-                graph_explore_state seen;
-                for (auto node : nodes()) {
-                    if (!seen.contains(node)) {
-                        nodes_on_loops_from(node, seen, [&] (auto n) {
-                            nodes_on_loops.insert(n);
-                        });
-                    }
-                }
-            }
-
-            // compute cost map for quick queries later
-            {
-                nodes_set seen;
-                for (auto node : nodes()) {
-                    if (!costs.contains(node)) {
-                        // we compute costs in postorder for dependent cost computations
-                        for (auto n : toposort(node, seen)) {
-                            costs[n] = init_minimal_cost(n);
-                        }
-                    }
-                }
-            }
+            compute_costs();
         }
 
     private:
 
-        cost_t init_minimal_cost(node_pointer node) const {
-            cost_t children_cost = 0;
+        // Costs are computed bottom-up from a worklist ordered by cost (Knuth's
+        // generalization of Dijkstra's algorithm). The cheapest enode popped for
+        // an eclass fixes its cost, an enode is evaluated once all its child
+        // eclasses are fixed. Hence every enode is evaluated at most once and
+        // enodes on loops never get a cost.
+        void compute_costs() {
+            using entry = std::tuple< cost_t, std::size_t, node_pointer >;
+            std::priority_queue< entry, std::vector< entry >, std::greater<> > worklist;
+
+            // enodes using an eclass, ordered as the enodes of the egraph so that
+            // ties in cost are broken deterministically
+            std::unordered_map< graph::node_handle, std::vector< node_pointer >, handle_hash > users;
+            std::unordered_map< node_pointer, std::size_t > order;
+
+            for (auto node : nodes()) {
+                auto idx = order.size();
+                order.emplace(node, idx);
+
+                if (node->num_of_children() == 0) {
+                    worklist.emplace(cost_function(node), idx, node);
+                }
 
-            for (auto child_class : node->children()) {
-                children_cost += minimal_cost(child_class).cost;
+                for (std::size_t i = 0; i < node->num_of_children(); ++i) {
+                    users[find(node->child(i))].push_back(node);
+                }
             }
 
-            return children_cost + cost_function(node);
-        }
+            auto ready = [&] (node_pointer node) {
+                for (std::size_t i = 0; i < node->num_of_children(); ++i) {
+                    if (!best.contains(find(node->child(i)))) {
+                        return false;
+                    }
+                }
+                return true;
+            };
 
-    protected:
+            nodes_set queued;
+            while (!worklist.empty()) {
+                auto [cost, _, node] = worklist.top();
+                worklist.pop();
 
-        template< typename Yield >
-        void nodes_on_loops_from(node_pointer node, graph_explore_state &seen, Yield yield) const {
-            seen.open(node);
+                costs.emplace(node, cost);
+
+                auto handle = find(node);
+                if (!best.try_emplace(handle, cost_node{ cost, node }).second) {
+                    continue;
+                }
 
-            for (auto child_class : node->children()) {
-                for (auto child : eclass(child_class).nodes) {
-                    if (seen.is_loop_edge(child)) {
-                        yield(node);
-                    } else {
-                        nodes_on_loops_from(child, seen, yield);
+                for (auto user : users[handle]) {
+                    if (!queued.contains(user) && ready(user)) {
+                        queued.insert(user);
+                        worklist.emplace(init_minimal_cost(user), order.at(user), user);
                     }
                 }
             }
-
-            seen.close(node);
         }
 
-        gap::recursive_generator< node_pointer > toposort(node_pointer root, nodes_set &seen) {
-            if (nodes_on_loops.contains(root)) {
-                co_return;
-            }
-
-            seen.insert(root);
+        cost_t init_minimal_cost(node_pointer node) const {
+            cost_t children_cost = 0;
 
-            for (auto child_class : root->children()) {
-                for (auto child : eclass(child_class).nodes) {
-                    if (!seen.count(child)) {
-                        co_yield toposort(child, seen);
-                    }
-                }
+            for (std::size_t i = 0; i < node->num_of_children(); ++i) {
+                children_cost += minimal_cost(node->child(i)).cost;
             }
 
-            co_yield root;
+            return children_cost + cost_function(node);
         }
 
+    protected:
+
         std::optional< cost_node > minimal_cost(node_pointer node) const {
             if (auto it = costs.find(node); it != costs.end())
                 return {{ it->second, node }};
@@ -152,22 +146,18 @@ namespace eqsat {
 
         // Returns minimal cost node for given equality class
         //
-        // Each eclass should have at least one non-loop node,
+        // Each eclass of an acyclic term has at least one non-loop node,
         // therefore the cost_node is not `optional` as in previous function.
         cost_node minimal_cost(graph::node_handle handle) const {
-            std::optional< cost_node > min = std::nullopt;
-            for (auto node : eclass(handle).nodes) {
-                if (auto curr = minimal_cost(node)) {
-                    if (!min.has_value() || curr->cost < min->cost) {
-                        std::swap(min, curr);
-                    }
-                }
-            }
-            return min.value();
+            return best.at(find(handle));
+        }
+
+        bool has_cost(graph::node_handle handle) const {
+            return best.contains(find(handle));
         }
 
         cost_map costs;
-        nodes_set nodes_on_loops;
+        eclass_cost_map best;
         memoized_cost_function cost_function;
     };
 
@@ -181,6 +171,10 @@ namespace eqsat {
         using cost_graph::eclass;
         using cost_graph::eclasses;
         using cost_graph::minimal_cost;
+        using cost_graph::has_cost;
+        using cost_graph::cost_function;
+
+        using handle_hash = typename cost_graph::handle_hash;
 
         using cost_node = typename cost_graph::cost_node;
 
@@ -194,8 +188,115 @@ namespace eqsat {
             )
         {
             for (const auto &[handle, _] : eclasses()) {
-                optimal_nodes[handle] = minimal_cost(handle);
+                if (has_cost(handle)) {
+                    optimal_nodes.emplace(handle, minimal_cost(handle));
+                }
+            }
+        }
+
+        //
+        // DAG cost of the graph extracted from the root, i.e., the cost of every
+        // chosen enode is counted once; `nullopt` if the choices form a loop
+        //
+        std::optional< cost_t > dag_cost(graph::node_handle root) const {
+            enum class state { open, closed };
+            std::unordered_map< graph::node_handle, state, handle_hash > visited;
+            std::vector< std::pair< graph::node_handle, std::size_t > > stack;
+
+            cost_t total = 0;
+            auto enter = [&] (graph::node_handle handle) {
+                if (auto it = visited.find(handle); it != visited.end()) {
+                    return it->second == state::closed;
+                }
+
+                visited.emplace(handle, state::open);
+                stack.emplace_back(handle, 0);
+                total += cost_function(optimal_nodes.at(handle).node);
+                return true;
+            };
+
+            if (!enter(find(root))) {
+                return std::nullopt;
             }
+
+            while (!stack.empty()) {
+                auto [handle, idx] = stack.back();
+                auto node = optimal_nodes.at(handle).node;
+                if (idx == node->num_of_children()) {
+                    visited[handle] = state::closed;
+                    stack.pop_back();
+                    continue;
+                }
+
+                stack.back().second++;
+                if (!enter(find(node->child(idx)))) {
+                    return std::nullopt;
+                }
+            }
+
+            return total;
+        }
+
+        //
+        // Local search on top of the greedy (tree cost) choices: the enode chosen for
+        // an eclass reachable from the root is swapped for another one whenever that
+        // lowers the DAG cost of the root. Every trial traverses the extracted graph,
+        // therefore the number of trials is bounded by `max_trials`.
+        //
+        cost_t improve_sharing(graph::node_handle root, std::size_t max_trials) {
+            auto best_cost = dag_cost(root).value();
+
+            std::size_t trials = 0;
+            for (bool improved = true; improved && trials < max_trials;) {
+                improved = false;
+                for (auto handle : reachable(root)) {
+                    auto &chosen = optimal_nodes.at(handle);
+                    for (auto node : eclass(handle).nodes) {
+                        if (trials >= max_trials) {
+                            return best_cost;
+                        }
+
+                        auto candidate = minimal_cost(node);
+                        if (!candidate || node == chosen.node) {
+                            continue;
+                        }
+
+                        ++trials;
+                        auto previous = std::exchange(chosen, *candidate);
+                        if (auto cost = dag_cost(root); cost && *cost < best_cost) {
+                            best_cost = *cost;
+                            improved  = true;
+                        } else {
+                            chosen = previous;
+                        }
+                    }
+                }
+            }
+
+            return best_cost;
+        }
+
+        // eclasses of the extracted graph in preorder from the root
+        std::vector< graph::node_handle > reachable(graph::node_handle root) const {
+            std::vector< graph::node_handle > result;
+            std::unordered_set< graph::node_handle, handle_hash > seen;
+
+            std::vector< graph::node_handle > stack = { find(root) };
+            while (!stack.empty()) {
+                auto handle = stack.back();
+                stack.pop_back();
+                if (!seen.insert(handle).second) {
+                    continue;
+                }
+
+                result.push_back(handle);
+                auto node = optimal_nodes.at(handle).node;
+                for (std::size_t i = node->num_of_children(); i > 0; --i) {
+                    stack.push_back(find(node->child(i - 1)));
+                }
+            }
+
+            return result;
         }
 
         struct optimal_node {
@@ -225,7 +326,6 @@ namespace eqsat {
             }
         }
 
-        using handle_hash = gap::hash< graph::node_handle >;
         std::unordered_map< graph::node_handle, cost_node, handle_hash > optimal_nodes;
     };
 
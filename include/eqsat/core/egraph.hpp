@@ -5,6 +5,8 @@
 #pragma once
 
 #include <eqsat/core/common.hpp>
+#include <eqsat/core/snapshot.hpp>
+#include <eqsat/core/symbol.hpp>
 #include <eqsat/pattern/pattern.hpp>
 
 #include <gap/core/generator.hpp>
@@ -13,7 +15,13 @@
 #include <gap/core/union_find.hpp>
 #include <gap/core/bigint.hpp>
 
+#include <cassert>
+#include <concepts>
+#include <optional>
+#include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 #include <iostream>
 
@@ -74,12 +82,17 @@ namespace eqsat::graph
 
     template< typename storage >
     std::string node_name(const storage_node< storage > &n) {
-        return node_name(static_cast< storage >(n));
+        return node_name(static_cast< const storage & >(n));
+    }
+
+    template< typename storage >
+    symbol_t node_symbol(const storage_node< storage > &n) {
+        return node_symbol(static_cast< const storage & >(n));
     }
 
     template< typename storage >
     std::optional< gap::bigint > extract_constant(const storage_node< storage > &n) {
-        return extract_constant(static_cast< storage >(n));
+        return extract_constant(static_cast< const storage & >(n));
     }
 
     struct bond_node {
@@ -88,6 +101,11 @@ namespace eqsat::graph
 
     static inline std::string node_name(const bond_node &n) { return "bond"; }
 
+    static inline symbol_t node_symbol(const bond_node &n) {
+        static const auto bond = intern("bond");
+        return bond;
+    }
+
     static inline std::optional< gap::bigint > extract_constant(const bond_node &n) {
         return std::nullopt;
     }
@@ -132,6 +150,11 @@ namespace eqsat::graph
         return std::visit( [] (const auto &n) { return node_name(n); }, n.data);
     }
 
+    template< typename storage >
+    symbol_t node_symbol(const node< storage > &n) {
+        return std::visit( [] (const auto &n) { return node_symbol(n); }, n.data);
+    }
+
     template< typename storage >
     std::optional< gap::bigint > extract_constant(const node< storage > &n) {
         return std::visit( [] (const auto &n) { return extract_constant(n); }, n.data);
@@ -196,7 +219,35 @@ namespace eqsat::graph
         using eclass_pointer = eclass_type *;
 
         using handle_hash  = gap::hash< node_handle >;
-        using eclass_map   = std::unordered_map< node_handle, eclass_type, handle_hash >;
+
+        // eclasses are stored densely, indexed by the id of their representative;
+        // the slot of a class merged into another one is a tombstone (empty)
+        using eclass_pair  = std::pair< const node_handle, eclass_type >;
+        using eclass_slot  = std::optional< eclass_pair >;
+
+        // storage and children of an enode at the time it was hashed into memo
+        struct memo_key {
+            const storage_type *data;
+            children_t children;
+
+            bool operator==(const memo_key &other) const {
+                return children == other.children && *data == *other.data;
+            }
+
+            friend gap::hash_code hash_value(gap::hash_code code, const memo_key &key) {
+                code = hash_value(code, *key.data);
+                for (auto ch : key.children) {
+                    code = hash_value(code, ch);
+                }
+                return code;
+            }
+        };
+
+        using memo_hash = gap::hash< memo_key >;
+        using memo_map  = std::unordered_map< memo_key, node_pointer, memo_hash >;
+
+        using handle_set     = std::unordered_set< node_handle, handle_hash >;
+        using operator_index = std::unordered_map< symbol_t, handle_set >;
 
         egraph() = default;
 
@@ -208,12 +259,14 @@ namespace eqsat::graph
 
         gap::generator< const node_pointer > nodes() const {
             for (auto &node : _nodes)
-                co_yield node.get();
+                if (node)
+                    co_yield node.get();
         }
 
         gap::generator< node_pointer > nodes() {
             for (auto &node : _nodes)
-                co_yield node.get();
+                if (node)
+                    co_yield node.get();
         }
 
         gap::generator< edge_type > edges() {
@@ -228,94 +281,449 @@ namespace eqsat::graph
         gap::generator< const edge_type > edges() const {
             for (const auto &node : nodes()) {
                 for (const auto &ch : node->children()) {
-                    const auto &cls = _classes.at(find(ch));
+                    const auto &cls = eclass(ch);
                     co_yield edge_type{node, const_cast< const eclass_pointer >(&cls)};
                 }
             }
         }
 
-        using eclass_pair = typename eclass_map::value_type;
         gap::generator< const eclass_pair & > eclasses() const {
-            for (const auto &pair : _classes)
-                co_yield pair;
+            // indexed loop, the list of canonical classes may grow meanwhile
+            for (std::size_t i = 0; i < _canonical.size(); ++i) {
+                if (const auto &entry = _classes[_canonical[i].id.ref()]) {
+                    co_yield entry.value();
+                }
+            }
+        }
+
+        // Yields only eclasses that contain an enode with the given symbol. The index may
+        // contain stale handles of removed classes, those are skipped.
+        gap::generator< const eclass_pair & > eclasses(symbol_t op) const {
+            auto it = _operators.find(op);
+            if (it == _operators.end()) {
+                co_return;
+            }
+
+            for (auto handle : it->second) {
+                if (const auto &entry = _classes[handle.id.ref()]) {
+                    co_yield entry.value();
+                }
+            }
+        }
+
+        // Visits the same eclasses as `eclasses()` and `eclasses(op)` without creating
+        // a generator, used by the e-matcher for every scan of candidates.
+        template< typename yield_t >
+        void for_each_eclass(yield_t &&yield) const {
+            for (std::size_t i = 0; i < _canonical.size(); ++i) {
+                if (const auto &entry = _classes[_canonical[i].id.ref()]) {
+                    yield(entry.value());
+                }
+            }
+        }
+
+        template< typename yield_t >
+        void for_each_eclass(symbol_t op, yield_t &&yield) const {
+            auto it = _operators.find(op);
+            if (it == _operators.end()) {
+                return;
+            }
+
+            for (auto handle : it->second) {
+                if (const auto &entry = _classes[handle.id.ref()]) {
+                    yield(entry.value());
+                }
+            }
+        }
+
+        std::size_t num_of_eclasses() const { return _canonical.size() - _dead_classes; }
+
+        std::size_t num_of_eclasses(symbol_t op) const {
+            auto it = _operators.find(op);
+            return it == _operators.end() ? 0 : it->second.size();
         }
 
-        std::size_t num_of_eclasses() const { return _classes.size(); }
+        std::size_t num_of_nodes() const { return _nodes.size() - _dead_nodes; }
+
+        // number of ids ever created, i.e., also of enodes removed since
+        std::size_t num_of_ids() const { return _classes.size(); }
+
+        // approximate memory footprint of the egraph, linear in its size
+        std::size_t size_in_bytes() const {
+            std::size_t bytes = 0;
+            bytes += _nodes.capacity() * sizeof(typename decltype(_nodes)::value_type);
+            for (const auto &node : nodes()) {
+                bytes += sizeof(node_type) + node->_children.capacity() * sizeof(node_handle);
+            }
+
+            bytes += _classes.capacity() * sizeof(eclass_slot)
+                   + _canonical.capacity() * sizeof(node_handle);
+            for (const auto &[_, cls] : eclasses()) {
+                auto refs = cls.nodes.capacity() + cls.parents.capacity();
+                bytes += refs * sizeof(node_pointer);
+            }
+
+            for (const auto &[key, _] : _memo) {
+                bytes += sizeof(typename memo_map::value_type)
+                       + key.children.capacity() * sizeof(node_handle);
+            }
+
+            for (const auto &[_, handles] : _operators) {
+                bytes += sizeof(typename operator_index::value_type)
+                       + handles.size() * sizeof(node_handle);
+            }
+
+            bytes += _ids.size() * sizeof(typename decltype(_ids)::value_type);
+            return bytes;
+        }
 
         node_handle find(const_node_pointer ptr) const {
-            return find(_ids.at(const_cast< node_pointer >(ptr)));
+            return find(_ids.at(const_cast< node_pointer >(ptr)).id);
         }
 
-        node_handle find(node_pointer ptr) { return find(_ids.at(ptr)); }
+        node_handle find(node_pointer ptr) { return find(_ids.at(ptr).id); }
 
         node_handle find(node_handle node) const {
+            if (_frozen) {
+                return node_handle( _roots[node.id.ref()] );
+            }
             return node_handle( _unions.find(node.id) );
         }
 
         node_handle find(node_handle node) {
-            return node_handle( _unions.find(node.id) );
+            return std::as_const(*this).find(node);
+        }
+
+        // While frozen, `find` is answered from a snapshot of the union-find instead of
+        // compressing its paths, hence the egraph can be read from many threads at once.
+        // The egraph must not be modified until it is thawed.
+        void freeze() {
+            _roots.resize(_classes.size());
+            for (std::size_t id = 0; id < _roots.size(); ++id) {
+                _roots[id] = _unions.find(node_id_t(node_id_t::underlying_t(id)));
+            }
+            _frozen = true;
         }
 
+        void thaw() { _frozen = false; }
+
+        bool frozen() const { return _frozen; }
+
         void canonicalize(node_type &node) {
-            node.update_children([&](node_handle child) {
-                return _unions.find(child.id); /* compresses paths */
+            node.update_children([&](node_handle &child) {
+                child = find(child); /* compresses paths */
             });
         }
 
+        // Returns class of an existing congruent enode if there is one (hash-consing),
+        // otherwise creates a new enode in a singleton class.
         node_handle insert(storage_type &&data, std::span< node_handle > children) {
-            auto node = add_node(std::move(data));
+            children_t canonical;
+            canonical.reserve(children.size());
             for (auto ch : children) {
+                canonical.push_back(find(ch));
+            }
+
+            if (is_hashconsed(data)) {
+                if (auto it = _memo.find(memo_key{ &data, canonical }); it != _memo.end()) {
+                    return find(it->second);
+                }
+            }
+
+            auto node = add_node(std::move(data));
+            for (auto ch : canonical) {
                 add_child(node, ch);
             }
+            hashcons(node);
             return find(node);
         }
 
-        const eclass_type &eclass(node_handle handle) const { return _classes.at(find(handle)); }
-        eclass_type &eclass(node_handle handle) { return _classes.at(find(handle)); }
+        const eclass_type &eclass(node_handle handle) const { return slot(find(handle)).second; }
+        eclass_type &eclass(node_handle handle) { return slot(find(handle)).second; }
 
         const auto& parents(node_handle handle) const {
             return eclass(handle).parents;
         }
 
-        void canonicalize(node_handle eclass) {
-            for (auto node : _classes[eclass].nodes) {
-                this->canonicalize(*node);
+        //
+        // snapshot (see `snapshot.hpp`)
+        //
+        // The union-find is written as the representative of every id, enodes in the
+        // order of `_nodes` and eclasses in the order of `_canonical`, without tombstones.
+        // Ids are preserved, i.e., handles into the saved egraph are valid in the loaded
+        // one. The operator index is recomputed from the eclasses.
+        //
+        void save(snapshot_output &out) const {
+            out.write(num_of_ids());
+            for (std::size_t id = 0; id < num_of_ids(); ++id) {
+                out.write(find(node_handle(node_id_t(node_id_t::underlying_t(id)))).id.ref());
             }
+
+            std::unordered_map< const_node_pointer, std::size_t > positions;
+            out.write(num_of_nodes());
+            for (const auto &node : _nodes) {
+                if (node) {
+                    positions.emplace(node.get(), positions.size());
+                    save_node(out, node.get());
+                }
+            }
+
+            auto save_nodes = [&] (const auto &nodes) {
+                out.write(nodes.size());
+                for (auto node : nodes) {
+                    out.write(positions.at(node));
+                }
+            };
+
+            out.write(num_of_eclasses());
+            for_each_eclass([&] (const eclass_pair &entry) {
+                out.write(entry.first.id.ref());
+                save_nodes(entry.second.nodes);
+                save_nodes(entry.second.parents);
+            });
         }
 
-        // require canonicalized eclasses
-        void repair(node_handle eclass) { repair(_classes[eclass]); }
+        // Loads the snapshot into an empty egraph.
+        void load(snapshot_input &in) {
+            assert(_nodes.empty() && "snapshot has to be loaded into an empty egraph");
 
-        void repair(eclass_type &eclass) {
-            // deduplicate the parents, noting that equal
-            // parents get merged and put on the worklist
+            auto ids = in.read< std::size_t >();
+            auto read_id = [&] {
+                auto id = in.read< node_id_t::underlying_t >();
+                if (id >= ids) {
+                    throw snapshot_error("invalid id in snapshot");
+                }
+                return node_handle(node_id_t(id));
+            };
 
-            std::unordered_set< node_handle, handle_hash > seen;
-            std::vector< node_pointer > new_parents;
-            for (auto *node : eclass.parents) {
-                if (auto id = find(node); !seen.count(id)) {
-                    new_parents.push_back(node);
-                    seen.insert(id);
+            _unions = gap::resizable_union_find(0);
+            for (std::size_t id = 0; id < ids; ++id) {
+                _unions.make_new_set();
+            }
+
+            // every id is merged to its representative while still being a singleton,
+            // therefore the representative remains the same as in the saved egraph
+            for (std::size_t id = 0; id < ids; ++id) {
+                auto repr = read_id();
+                if (repr.id.ref() != id) {
+                    _unions.merge(repr.id, node_id_t(node_id_t::underlying_t(id)));
                 }
             }
 
-            eclass.parents = std::move(new_parents);
+            std::vector< node_pointer > loaded(in.read< std::size_t >());
+            for (std::size_t position = 0; position < loaded.size(); ++position) {
+                auto id     = read_id();
+                auto hashed = in.read_bool();
+
+                auto node = _nodes.emplace_back(load_node(in)).get();
+                for (auto arity = in.read< std::size_t >(); arity; --arity) {
+                    node->add_child(read_id());
+                }
+
+                _ids.emplace(node, node_info{ id, position });
+                if (hashed) {
+                    hashcons(node);
+                }
+                loaded[position] = node;
+            }
+
+            auto load_nodes = [&] (auto &nodes) {
+                for (auto size = in.read< std::size_t >(); size; --size) {
+                    auto position = in.read< std::size_t >();
+                    if (position >= loaded.size()) {
+                        throw snapshot_error("invalid enode in snapshot");
+                    }
+                    nodes.push_back(loaded[position]);
+                }
+            };
+
+            _classes.resize(ids);
+            for (auto classes = in.read< std::size_t >(); classes; --classes) {
+                auto handle = read_id();
+                if (find(handle) != handle || _classes[handle.id.ref()]) {
+                    throw snapshot_error("invalid eclass in snapshot");
+                }
 
-            // obliterate empty classes
-            remove_empty_eclasses();
+                eclass_type cls;
+                load_nodes(cls.nodes);
+                load_nodes(cls.parents);
+                for (auto node : cls.nodes) {
+                    _operators[node_symbol(*node)].insert(handle);
+                }
+
+                _classes[handle.id.ref()].emplace(handle, std::move(cls));
+                _canonical.push_back(handle);
+            }
         }
 
         void remove_empty_eclasses() {
-            std::erase_if(_classes, [](const auto& eclass) {
-                const auto &[handle, cls] = eclass;
-                return cls.nodes.empty();
-            });
+            for (auto handle : _canonical) {
+                if (auto &entry = _classes[handle.id.ref()]; entry && entry->second.nodes.empty()) {
+                    entry.reset();
+                    ++_dead_classes;
+                }
+            }
+            compact_eclasses();
         }
 
       protected:
 
+        // Memo is keyed by children of the enode, therefore an enode has to be unhashed
+        // before its children are canonicalized and hashed again afterwards.
+        // Bond nodes are not hash-consed.
+
+        // Storage opts out of hash-consing of some enodes (e.g., leaves that are equal,
+        // but each stands for a distinct value) by `bool hashconsed(const storage_type &)`
+        // found by ADL. Such enodes are never merged by congruence.
+        static bool is_hashconsed(const storage_type &data) {
+            if constexpr (requires { { hashconsed(data) } -> std::convertible_to< bool >; }) {
+                return hashconsed(data);
+            } else {
+                return true;
+            }
+        }
+
+        // Returns the enode congruent to `node` that is already in memo, or inserts
+        // `node` and returns it.
+        node_pointer hashcons(node_pointer node) {
+            if (auto key = memo_key_of(*node)) {
+                return _memo.try_emplace(std::move(*key), node).first->second;
+            }
+            return node;
+        }
+
+        void unhash(node_pointer node) {
+            if (auto key = memo_key_of(*node)) {
+                if (auto it = _memo.find(*key); it != _memo.end() && it->second == node) {
+                    _memo.erase(it);
+                }
+            }
+        }
+
+        std::optional< memo_key > memo_key_of(const node_type &node) const {
+            if (auto data = std::get_if< storage_node< storage_type > >(&node.data)) {
+                if (is_hashconsed(*data)) {
+                    return memo_key{ data, node._children };
+                }
+            }
+            return std::nullopt;
+        }
+
+        // An enode is written as its id, whether it is hash-consed, its kind with data
+        // and its children; parents of classes are restored from the eclasses.
+        void save_node(snapshot_output &out, const_node_pointer node) const {
+            out.write(_ids.at(const_cast< node_pointer >(node)).id.id.ref());
+
+            auto key = memo_key_of(*node);
+            auto it  = key ? _memo.find(*key) : _memo.end();
+            out.write(it != _memo.end() && it->second == node);
+
+            out.write(node->data.index());
+            if (auto data = std::get_if< storage_node< storage_type > >(&node->data)) {
+                save_storage(out, static_cast< const storage_type & >(*data));
+            } else {
+                const auto &bond = std::get< bond_node >(node->data);
+                out.write(bond.children_parents.size());
+                for (auto parent : bond.children_parents) {
+                    out.write(parent);
+                }
+            }
+
+            out.write(node->num_of_children());
+            for (std::size_t idx = 0; idx < node->num_of_children(); ++idx) {
+                out.write(node->child(idx).id.ref());
+            }
+        }
+
+        static std::unique_ptr< node_type > load_node(snapshot_input &in) {
+            switch (in.read< std::size_t >()) {
+                case 0:
+                    return std::make_unique< node_type >(
+                        load_storage(in, std::type_identity< storage_type >{})
+                    );
+                case 1: {
+                    bond_node bond;
+                    for (auto size = in.read< std::size_t >(); size; --size) {
+                        bond.children_parents.push_back(in.read< std::size_t >());
+                    }
+                    return std::make_unique< node_type >(std::move(bond));
+                }
+                default:
+                    throw snapshot_error("invalid enode in snapshot");
+            }
+        }
+
+        // Moves operators of `from` class to `into` class, has to be called before the
+        // classes are merged.
+        void reindex_operators(node_handle into, node_handle from) {
+            for (auto node : slot(from).second.nodes) {
+                auto &handles = _operators[node_symbol(*node)];
+                handles.erase(from);
+                handles.insert(into);
+            }
+        }
+
+        eclass_pair &slot(node_handle handle) {
+            auto &entry = _classes.at(handle.id.ref());
+            assert(entry && "eclass was merged into another one");
+            return entry.value();
+        }
+
+        const eclass_pair &slot(node_handle handle) const {
+            const auto &entry = _classes.at(handle.id.ref());
+            assert(entry && "eclass was merged into another one");
+            return entry.value();
+        }
+
+        // Moves the class out of the egraph, leaving a tombstone in its place.
+        eclass_type extract_eclass(node_handle handle) {
+            auto &entry = _classes.at(handle.id.ref());
+            auto cls = std::move(entry->second);
+            entry.reset();
+            ++_dead_classes;
+            return cls;
+        }
+
+        // Drops tombstones from the list of canonical classes. Amortized, i.e., the list
+        // is rewritten only if at least half of it are tombstones; may be called only
+        // when no iteration over eclasses is in progress.
+        void compact_eclasses() {
+            if (2 * _dead_classes <= _canonical.size()) {
+                return;
+            }
+
+            std::erase_if(_canonical, [&] (auto handle) { return !_classes[handle.id.ref()]; });
+            _dead_classes = 0;
+        }
+
+        // enodes have to be already removed from their classes
+        void remove_nodes(const std::unordered_set< node_pointer > &removed) {
+            for (auto node : removed) {
+                unhash(node);
+                auto it = _ids.find(node);
+                _nodes[it->second.position].reset();
+                _ids.erase(it);
+            }
+
+            _dead_nodes += removed.size();
+            compact_nodes();
+        }
+
+        // Same as `compact_eclasses` for enodes, positions of enodes are updated.
+        void compact_nodes() {
+            if (2 * _dead_nodes <= _nodes.size()) {
+                return;
+            }
+
+            std::erase_if(_nodes, [] (const auto &node) { return !node; });
+            for (std::size_t i = 0; i < _nodes.size(); ++i) {
+                _ids.at(_nodes[i].get()).position = i;
+            }
+            _dead_nodes = 0;
+        }
+
         void add_parent(node_handle eclass, node_pointer parent) {
-            _classes.at(eclass).parents.push_back(parent);
+            slot(eclass).second.parents.push_back(parent);
         }
 
         void add_child(node_pointer node, node_handle child) {
@@ -324,30 +732,58 @@ namespace eqsat::graph
         }
 
         node_pointer add_node(storage_type &&data) {
+            auto position = _nodes.size();
             auto node = _nodes.emplace_back(
                 std::make_unique< node_type >(std::move(data))
             ).get();
 
             node_handle id{ _unions.make_new_set().parent };
 
-            _classes.emplace(id, singleton_eclass(node));
+            if (_classes.size() <= id.id.ref()) {
+                _classes.resize(id.id.ref() + 1);
+            }
+            _classes[id.id.ref()].emplace(id, singleton_eclass(node));
+            _canonical.push_back(id);
+
+            _ids.emplace(node, node_info{ id, position });
 
-            _ids.emplace(node, id);
+            _operators[node_symbol(*node)].insert(id);
 
             return node;
         }
 
-        // stores heap allocated nodes of egraph
+        // stores heap allocated nodes of egraph, removed nodes are null until compaction
         std::vector< std::unique_ptr< node_type > > _nodes;
+        std::size_t _dead_nodes = 0;
 
         // stores equivalence relation between equaltity classes
         mutable gap::resizable_union_find _unions = gap::resizable_union_find(0);
 
-        // all equavalent ids  map to the same class
-        eclass_map _classes;
+        // all equavalent ids  map to the same class, indexed by the representative id
+        std::vector< eclass_slot > _classes;
+
+        // ids of canonical classes, contains `_dead_classes` tombstones until compaction
+        std::vector< node_handle > _canonical;
+        std::size_t _dead_classes = 0;
+
+        struct node_info {
+            node_handle id;
+            // index to `_nodes`
+            std::size_t position;
+        };
 
         // stores equality ids of enodes
-        std::unordered_map< node_pointer, node_handle > _ids;
+        std::unordered_map< node_pointer, node_info > _ids;
+
+        // hash-cons of enodes, i.e., every enode is present at most once
+        memo_map _memo;
+
+        // representatives of all ids at the time of `freeze`
+        std::vector< node_id_t > _roots;
+        bool _frozen = false;
+
+        // canonical eclasses containing an enode of the given symbol
+        operator_index _operators;
 
         // modified eclasses that needs to be rebuild
         std::vector< node_id_t > _pending;
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <eqsat/core/symbol.hpp>
+
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace eqsat
+{
+    //
+    // binary snapshot streams
+    //
+    // Unsigned integers are written as LEB128 varints, most of the stored values are
+    // small ids. Symbols are process-local, therefore a symbol is written with its name
+    // on its first occurrence only and as an index into the table of already written
+    // symbols afterwards.
+    //
+    // Types stored in egraph nodes are written by `save_storage(snapshot_output &, const T &)`
+    // and read by `load_storage(snapshot_input &, std::type_identity< T >)` found by ADL.
+    //
+    struct snapshot_error : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    struct snapshot_output {
+        explicit snapshot_output(std::ostream &os) : os(os) {}
+
+        void write(std::uint64_t value) {
+            do {
+                auto byte = std::uint8_t(value & 0x7f);
+                value >>= 7;
+                os.put(char(value ? byte | 0x80 : byte));
+            } while (value);
+        }
+
+        void write(bool value) { os.put(char(value)); }
+
+        void write(std::string_view str) {
+            write(std::uint64_t(str.size()));
+            os.write(str.data(), std::streamsize(str.size()));
+        }
+
+        void write(symbol_t symbol) {
+            auto [it, fresh] = _symbols.try_emplace(symbol, _symbols.size());
+            write(std::uint64_t(it->second));
+            if (fresh) {
+                write(std::string_view(symbol.name()));
+            }
+        }
+
+        template< typename T >
+        void write(const std::optional< T > &value) {
+            write(value.has_value());
+            if (value) {
+                write(*value);
+            }
+        }
+
+        template< typename integral >
+            requires (std::is_unsigned_v< integral > && !std::is_same_v< integral, bool >)
+        void write(integral value) { write(std::uint64_t(value)); }
+
+        bool good() const { return os.good(); }
+
+      private:
+        std::ostream &os;
+        std::unordered_map< symbol_t, std::uint32_t > _symbols;
+    };
+
+    struct snapshot_input {
+        explicit snapshot_input(std::istream &is) : is(is) {}
+
+        std::uint64_t read_uint() {
+            std::uint64_t value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7) {
+                auto byte = std::uint8_t(get());
+                value |= std::uint64_t(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) {
+                    return value;
+                }
+            }
+            throw snapshot_error("malformed integer in snapshot");
+        }
+
+        template< typename integral >
+        integral read() {
+            auto value = read_uint();
+            if (value > std::uint64_t(std::numeric_limits< integral >::max())) {
+                throw snapshot_error("integer out of range in snapshot");
+            }
+            return integral(value);
+        }
+
+        bool read_bool() { return get() != 0; }
+
+        std::string read_string() {
+            std::string str(read< std::size_t >(), '\0');
+            if (!is.read(str.data(), std::streamsize(str.size()))) {
+                throw snapshot_error("unexpected end of snapshot");
+            }
+            return str;
+        }
+
+        symbol_t read_symbol() {
+            auto idx = read< std::size_t >();
+            if (idx == _symbols.size()) {
+                return _symbols.emplace_back(intern(read_string()));
+            }
+
+            if (idx > _symbols.size()) {
+                throw snapshot_error("reference to an unknown symbol in snapshot");
+            }
+            return _symbols[idx];
+        }
+
+        template< typename integral >
+        std::optional< integral > read_optional() {
+            if (read_bool()) {
+                return read< integral >();
+            }
+            return std::nullopt;
+        }
+
+      private:
+        char get() {
+            char ch;
+            if (!is.get(ch)) {
+                throw snapshot_error("unexpected end of snapshot");
+            }
+            return ch;
+        }
+
+        std::istream &is;
+        std::vector< symbol_t > _symbols;
+    };
+
+} // namespace eqsat
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <gap/core/hash.hpp>
+
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace eqsat
+{
+    //
+    // Interned name of an operation (or of its attribute)
+    //
+    // Symbols are compact ids into the process-wide symbol table, therefore comparison
+    // and hashing of symbols does not touch the name itself. The same name is always
+    // interned to the same symbol, symbols are never freed.
+    //
+    struct symbol_t {
+        std::uint32_t id = 0;
+
+        constexpr auto operator<=>(const symbol_t &) const = default;
+
+        const std::string &name() const;
+    };
+
+    // Returns the symbol of the name, the name is added to the table if necessary.
+    // Safe to be called concurrently.
+    symbol_t intern(std::string_view name);
+
+    // Number of interned symbols
+    std::size_t num_of_symbols();
+
+    static inline const std::string &symbol_name(symbol_t symbol) { return symbol.name(); }
+
+    static inline std::string to_string(symbol_t symbol) { return symbol.name(); }
+
+    template< typename stream >
+    stream &operator<<(stream &os, symbol_t symbol) {
+        os << symbol.name();
+        return os;
+    }
+
+    static inline gap::hash_code hash_value(gap::hash_code code, symbol_t symbol) {
+        return gap::hash_combine(code, gap::hash_code(symbol.id));
+    }
+
+} // namespace eqsat
+
+template<>
+struct std::hash< eqsat::symbol_t > {
+    std::size_t operator()(eqsat::symbol_t symbol) const noexcept {
+        return std::hash< std::uint32_t >{}(symbol.id);
+    }
+};
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <eqsat/core/common.hpp>
+#include <eqsat/core/symbol.hpp>
+
 #include <gap/core/bigint.hpp>
 #include <gap/core/overloads.hpp>
 #include <gap/core/parser.hpp>
@@ -12,6 +14,7 @@
 #include <gap/core/strong_type.hpp>
 
 #include <optional>
+#include <string_view>
 #include <unordered_set>
 #include <variant>
 #include <vector>
@@ -95,8 +98,23 @@ namespace eqsat
     using constant_t = gap::strong_type< gap::bigint, constant_tag >;
 
     // operation has to be named with prefix 'op_'
-    struct operation_tag;
-    using operation_t = gap::strong_type< name_t, operation_tag >;
+    // the name is interned, i.e., operations are compared by their symbols
+    struct operation_t {
+        explicit operation_t(std::string_view name) : symbol(intern(name)) {}
+        explicit operation_t(symbol_t symbol) : symbol(symbol) {}
+
+        const name_t &ref() const { return symbol.name(); }
+
+        constexpr auto operator<=>(const operation_t &) const = default;
+
+        symbol_t symbol;
+    };
+
+    template< typename stream >
+    stream& operator<<(stream& os, const operation_t& op) {
+        os << op.ref();
+        return os;
+    }
 
     // place has to be named with prefix '?'
     struct placeholder_tag;
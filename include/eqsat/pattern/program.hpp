@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#pragma once
+
+#include <eqsat/pattern/pattern.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace eqsat
+{
+    //
+    // compiled match pattern
+    //
+    // A match pattern is compiled once into a flat sequence of instructions of
+    // a backtracking machine (as in egg). Instructions operate on two register
+    // files, eclass registers and enode registers. Scans are the only instructions
+    // with more than one outcome: the machine continues with the next instruction
+    // for each of their candidates in turn. Any failed check backtracks to the
+    // innermost scan.
+    //
+    // Places do not need registers of their own, a place is the eclass register
+    // of its first occurrence, its other occurrences compile to `compare`.
+    //
+    enum class opcode : std::uint8_t {
+        scan_eclasses,   // dst <- each eclass with root operation `arg`
+        scan_nodes,      // dst <- each enode of eclass `src`
+        check_operation, // operation of enode `src` is symbol `arg`
+        check_constant,  // enode `src` is the constant `arg` of the program
+        load_children,   // enode `src` has `arg` children, their eclasses go to dst...
+        compare,         // eclass `src` is eclass `dst`
+        yield,           // report a match
+        unsupported      // pattern can not be matched yet
+    };
+
+    struct instruction {
+        static constexpr std::uint32_t any_operation = std::numeric_limits< std::uint32_t >::max();
+
+        opcode op;
+        std::uint32_t dst = 0;
+        std::uint32_t src = 0;
+        std::uint32_t arg = 0;
+    };
+
+    struct match_program {
+        std::vector< instruction > code;
+        std::vector< constant_t > constants;
+
+        std::uint32_t eclass_registers = 0;
+        std::uint32_t enode_registers  = 0;
+
+        // places of the pattern (as in `gather_places`) and their eclass registers
+        places_t places;
+        std::vector< std::uint32_t > place_registers;
+
+        // eclass registers of matched roots; simple expression has a single anonymous
+        // root, match expression has a root per label
+        std::vector< std::pair< label_t, std::uint32_t > > roots;
+        bool multi_match = false;
+    };
+
+    match_program compile_pattern(const match_pattern &pattern);
+
+    std::string_view opcode_name(opcode op);
+
+    template< typename stream >
+    stream& operator<<(stream& os, const instruction& inst) {
+        return os << opcode_name(inst.op) << ' ' << inst.dst << ' ' << inst.src << ' ' << inst.arg;
+    }
+
+    template< typename stream >
+    stream& operator<<(stream& os, const match_program& program) {
+        for (const auto &inst : program.code) {
+            os << inst << '\n';
+        }
+        return os;
+    }
+
+} // namespace eqsat
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <eqsat/pattern/pattern.hpp>
+#include <eqsat/pattern/program.hpp>
 
 #include <string>
 #include <vector>
@@ -29,6 +30,7 @@ namespace eqsat {
             : name(name)
             , lhs(make_match_pattern(lhs))
             , rhs(make_apply_pattern(rhs))
+            , program(compile_pattern(this->lhs))
             //, places(get_indexed_places(lhs))
         {}
 
@@ -39,6 +41,9 @@ namespace eqsat {
         match_pattern lhs;
         apply_pattern rhs;
 
+        // left-hand-side compiled for the e-matcher
+        match_program program;
+
         // Places that occur in the rewrite pattern
         // Note: it is required that place occurs on the left hand side
         // of the rule when it occurs on the right hand side
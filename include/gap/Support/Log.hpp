@@ -8,6 +8,7 @@
 #include <sstream>
 #include <string>
 #include <filesystem>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
@@ -49,7 +50,7 @@
 //    NOTE(lukas): I don't know how to achieve that ^ does not happen without macro.
 //
 //  Cons:
-//  * No thread-safety yet.
+//  * Messages from multiple threads do not interleave, but their order is arbitrary.
 //  * No custom sinks yet.
 
 
@@ -86,10 +87,13 @@ namespace gap::log {
         using sinks_t = std::vector< Sink >;
         using alert_id_t = severity::level::id_t;
         std::unordered_map< alert_id_t, sinks_t > storage;
+        // Messages from different threads must not interleave.
+        std::mutex mtx;
 
         template< typename L, typename ... Args >
         Sinks &add(Args && ... args)
         {
+            std::lock_guard lock(mtx);
             storage[L::id].push_back(Sink(std::forward< Args >(args) ...));
             return *this;
         }
@@ -97,9 +101,13 @@ namespace gap::log {
         template< typename L >
         void log(const std::string &str)
         {
-            for (auto &sink : storage[L::id])
+            std::lock_guard lock(mtx);
+            auto it = storage.find(L::id);
+            if (it == storage.end())
+                return;
+            for (auto &sink : it->second)
                 sink.out << str;
-            for (auto &sink : storage[L::id])
+            for (auto &sink : it->second)
                 sink->flush();
         }
     };
@@ -17,6 +17,7 @@ CIRCUITOUS_RELAX_WARNINGS
 CIRCUITOUS_UNRELAX_WARNINGS
 
 #include <sstream>
+#include <string>
 
 namespace circ::exalt
 {
@@ -31,6 +32,37 @@ namespace circ::exalt
         return circuit_function( *fn );
     }
 
+    llvm::CallInst *partial_marker::make( builder_t &irb, const std::string &kind,
+                                          values_t args )
+    {
+        // Types are part of the name, the same kind can carry values of different types.
+        std::string name = prefix + kind;
+        llvm::raw_string_ostream os( name );
+        std::vector< llvm::Type * > types;
+        for ( auto arg : args )
+        {
+            os << ".";
+            arg->getType()->print( os );
+            types.push_back( arg->getType() );
+        }
+        os.flush();
+
+        auto module = irb.GetInsertBlock()->getModule();
+        auto type = llvm::FunctionType::get( irb.getVoidTy(), types, false );
+        auto callee = module->getOrInsertFunction( name, type );
+        return irb.CreateCall( callee, args );
+    }
+
+    std::string partial_marker::kind( llvm::CallInst *call )
+    {
+        auto callee = call->getCalledFunction();
+        if ( !callee || !callee->getName().startswith( prefix ) )
+            return {};
+
+        auto name = callee->getName().drop_front( std::string_view( prefix ).size() );
+        return name.split( '.' ).first.str();
+    }
+
     auto function_context::make( CtxRef ctx_ref ) -> function_context
     {
         return function_context( circuit_function::make( ctx_ref ) );
@@ -21,6 +21,8 @@
 CIRCUITOUS_RELAX_WARNINGS
 CIRCUITOUS_UNRELAX_WARNINGS
 
+#include <algorithm>
+
 namespace circ::exalt
 {
     namespace
@@ -369,6 +371,36 @@ namespace circ::exalt
         return irops::And::make( bld, mk_args( extract( buckets, place::root ) ) );
     }
 
+    // Registers are identified by their index in `regs()`, which is the same for every
+    // `Ctx` of the same arch.
+    void mux_heavy_lifter::export_partial()
+    {
+        const auto &regs = l_ctx().regs();
+        for ( const auto &[ reg, values ] : final_values )
+        {
+            auto it = std::find( regs.begin(), regs.end(), reg );
+            // Never checked by `finalize_circuit` anyway.
+            if ( it == regs.end() )
+                continue;
+
+            auto idx = irb().getInt32( std::uint32_t( std::distance( regs.begin(), it ) ) );
+            for ( auto [ cond, value ] : values )
+                partial_marker::make( irb(), "final", { idx, cond, value } );
+        }
+    }
+
+    void mux_heavy_lifter::import_partial( const std::string &kind, llvm::CallInst *marker )
+    {
+        if ( kind != "final" )
+            return;
+
+        const auto &regs = l_ctx().regs();
+        auto idx = llvm::cast< llvm::ConstantInt >( marker->getArgOperand( 0 ) )->getZExtValue();
+        check( idx < regs.size() ) << log_prefix() << "Partial circuit of a different arch.";
+
+        final_values[ regs[ idx ] ].emplace_back( marker->getArgOperand( 1 ),
+                                                  marker->getArgOperand( 2 ) );
+    }
 
     /* `disjunction_lifter` */
 
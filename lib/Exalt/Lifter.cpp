@@ -8,6 +8,7 @@
 #include <circuitous/Exalt/ISemLifters.hpp>
 
 #include <circuitous/Lifter/ISELBank.hpp>
+#include <circuitous/Lifter/SemanticsCache.hpp>
 #include <circuitous/Lifter/Components/OperandSelection.hpp>
 
 #include <circuitous/Lifter/Undefs.hpp>
@@ -18,6 +19,10 @@
 #include <circuitous/Support/Check.hpp>
 
 CIRCUITOUS_RELAX_WARNINGS
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/MemoryBuffer.h>
 CIRCUITOUS_UNRELAX_WARNINGS
 
 namespace circ::exalt
@@ -74,7 +79,7 @@ namespace circ::exalt
         // TODO( next ): Bump pc.
         auto semantic = circ::isem::semantic_fn( unit.isel, *llvm_module() );
         check( semantic ) << log_prefix() << "Could not fetch semantic for unit!";
-        post_lift( **semantic );
+        circ::isem::post_lift( l_ctx(), unit.isel, **semantic );
 
         // Make the actual call
         auto &isem_lifter = local_components.get_isem_lifter();
@@ -138,6 +143,92 @@ namespace circ::exalt
         optimize_silently( { fn } );
     }
 
+    std::string circuit_producer::export_partial() &&
+    {
+        auto &bld = b_ctx.irb();
+        for ( const auto &[ p, values ] : exalted_buckets )
+            for ( auto value : values )
+                partial_marker::make( bld, "bucket", { bld.getInt8( std::uint8_t( p ) ),
+                                                       value } );
+
+        pcs.get_isem_lifter().export_partial();
+        pcs.fetch_or_die< TM_allocator >().export_partial( bld );
+        bld.CreateRet( bld.getTrue() );
+
+        auto fn = std::move( b_ctx ).take_fn();
+        fn->setName( partial_fn_name );
+        ctx.clean_module( { fn } );
+
+        std::string bitcode;
+        llvm::raw_string_ostream os( bitcode );
+        llvm::WriteBitcodeToFile( *ctx.module(), os );
+        os.flush();
+        return bitcode;
+    }
+
+    void circuit_producer::merge_partial( std::string_view bitcode )
+    {
+        auto buffer = llvm::MemoryBuffer::getMemBuffer(
+                llvm::StringRef( bitcode.data(), bitcode.size() ), "partial", false );
+        auto parsed = llvm::parseBitcodeFile( buffer->getMemBufferRef(), *ctx.llvm_ctx() );
+        if ( !parsed )
+            log_kill() << log_prefix() << "Cannot parse partial circuit:"
+                       << llvm::toString( parsed.takeError() );
+        auto partial = std::move( *parsed );
+
+        // Whatever survived `clean_module` is already present (semantics module is the
+        // same), only declarations are linked to avoid multiple definitions.
+        for ( auto &fn : *partial )
+            if ( !fn.isDeclaration() && fn.getName() != partial_fn_name &&
+                 ctx.module()->getFunction( fn.getName() ) )
+            {
+                fn.deleteBody();
+            }
+
+        for ( auto &gv : partial->globals() )
+            if ( !gv.isDeclaration() && !gv.hasLocalLinkage() &&
+                 ctx.module()->getNamedValue( gv.getName() ) )
+            {
+                gv.setInitializer( nullptr );
+                gv.setLinkage( llvm::GlobalValue::ExternalLinkage );
+            }
+
+        check( !llvm::Linker::linkModules( *ctx.module(), std::move( partial ) ) )
+            << log_prefix() << "Cannot link partial circuit.";
+
+        auto partial_fn = ctx.module()->getFunction( partial_fn_name );
+        check( partial_fn ) << log_prefix() << "Partial circuit is missing its function.";
+
+        auto make_breakpoint = []( auto irb )
+        {
+            return irops::Breakpoint::make( irb, irb.getTrue() );
+        };
+        auto call = b_ctx.irb().CreateCall( partial_fn );
+        auto [ begin, end ] = inline_flattened( call, make_breakpoint );
+        partial_fn->eraseFromParent();
+
+        std::vector< std::tuple< std::string, llvm::CallInst * > > markers;
+        for ( auto &inst : make_range( begin, end ) )
+            if ( auto marker = llvm::dyn_cast< llvm::CallInst >( &inst ) )
+                if ( auto kind = partial_marker::kind( marker ); !kind.empty() )
+                    markers.emplace_back( std::move( kind ), marker );
+
+        for ( auto &[ kind, marker ] : markers )
+        {
+            if ( kind == "bucket" )
+            {
+                auto p = llvm::cast< llvm::ConstantInt >( marker->getArgOperand( 0 ) );
+                exalted_buckets[ place( p->getZExtValue() ) ].insert(
+                        marker->getArgOperand( 1 ) );
+            }
+            else if ( kind == "selector" )
+                pcs.fetch_or_die< TM_allocator >().import_partial( marker );
+            else
+                pcs.get_isem_lifter().import_partial( kind, marker );
+            marker->eraseFromParent();
+        }
+    }
+
     void circuit_producer::init_pcs()
     {
         pcs.emplace< timestamp >().init();
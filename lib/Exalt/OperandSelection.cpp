@@ -187,6 +187,45 @@ namespace circ::exalt
         return materalized[ idx ];
     }
 
+    void TM_allocator::export_partial( builder_t &irb )
+    {
+        for ( auto &[ storage_idx, materialized ] : read_map )
+            for ( std::size_t i = 0; i < materialized.size(); ++i )
+                partial_marker::make( irb, "selector", { irb.getInt64( storage_idx ),
+                                                         irb.getInt64( i ),
+                                                         *materialized[ i ] } );
+    }
+
+    void TM_allocator::import_partial( llvm::CallInst *marker )
+    {
+        auto as_idx = [ & ]( unsigned arg )
+        {
+            return llvm::cast< llvm::ConstantInt >( marker->getArgOperand( arg ) )
+                ->getZExtValue();
+        };
+
+        auto &materialized = read_map[ as_idx( 0 ) ];
+        auto idx = as_idx( 1 );
+        auto mux = llvm::cast< llvm::Instruction >( marker->getArgOperand( 2 ) );
+
+        // Each partition exports a prefix of positions.
+        check( idx <= materialized.size() ) << "Partial selectors are not contiguous.";
+        if ( idx == materialized.size() )
+        {
+            materialized.emplace_back( mux );
+            return;
+        }
+
+        // Users bind their selector values to the delayed value of the mux, so those
+        // are moved to the existing mux, which then replaces the duplicate one.
+        auto existing = llvm::cast< llvm::Instruction >( *materialized[ idx ] );
+        auto delayed = llvm::cast< llvm::Instruction >( mux->getOperand( 0 ) );
+        delayed->replaceAllUsesWith( existing->getOperand( 0 ) );
+        mux->replaceAllUsesWith( existing );
+        mux->eraseFromParent();
+        delayed->eraseFromParent();
+    }
+
     auto operand_allocator_base::get_requester( builder_t &irb, State &state, value_t ctx_cond )
         -> requester_ptr
     {
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#include <circuitous/IR/Decode.hpp>
+
+#include <circuitous/Support/Check.hpp>
+#include <circuitous/Support/Log.hpp>
+
+CIRCUITOUS_RELAX_WARNINGS
+#include <llvm/ADT/StringRef.h>
+CIRCUITOUS_UNRELAX_WARNINGS
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace circ
+{
+    namespace
+    {
+        using apint = llvm::APInt;
+        // Empty if the value is unknown - the node (or one of its operands) is not
+        // supported, e.g., because the decoder was rewritten by an optimization.
+        using maybe_apint = std::optional< apint >;
+
+        struct decoder_eval
+        {
+            const apint &bits;
+            std::unordered_map< Operation *, maybe_apint > values;
+
+            explicit decoder_eval( const apint &bits ) : bits( bits ) {}
+
+            // Operands are evaluated before their users, nodes shared by decoders of
+            // several contexts are evaluated once.
+            const maybe_apint &get( Operation *root )
+            {
+                std::vector< std::pair< Operation *, std::size_t > > todo;
+                if ( !values.count( root ) )
+                    todo.emplace_back( root, 0 );
+
+                while ( !todo.empty() )
+                {
+                    auto &[ op, idx ] = todo.back();
+                    if ( idx < op->operands_size() )
+                    {
+                        auto next = op->operand( idx++ );
+                        if ( !values.count( next ) )
+                            todo.emplace_back( next, 0 );
+                        continue;
+                    }
+                    values.emplace( op, eval( op ) );
+                    todo.pop_back();
+                }
+                return values.at( root );
+            }
+
+            // Only valid once all operands are known to have a value, see `eval`.
+            const apint &operand( Operation *op, std::size_t idx )
+            {
+                return *values.at( op->operand( idx ) );
+            }
+
+            bool all_equal( Operation *op )
+            {
+                for ( std::size_t i = 1; i < op->operands_size(); ++i )
+                    if ( operand( op, i ) != operand( op, 0 ) )
+                        return false;
+                return true;
+            }
+
+            maybe_apint eval( Operation *op )
+            {
+                for ( auto o : op->operands() )
+                    if ( !values.at( o ) )
+                        return {};
+
+                auto nary = [ & ]( auto &&combine )
+                {
+                    auto out = operand( op, 0 );
+                    for ( std::size_t i = 1; i < op->operands_size(); ++i )
+                        combine( out, operand( op, i ) );
+                    return out;
+                };
+
+                switch ( op->op_code )
+                {
+                    case InputInstructionBits::kind:
+                        check( op->size == bits.getBitWidth() );
+                        return bits;
+                    case Constant::kind:
+                    {
+                        auto c = static_cast< Constant * >( op );
+                        std::string msb_first{ c->bits.rbegin(), c->bits.rend() };
+                        return apint( c->size, msb_first, /*radix=*/2U );
+                    }
+                    case Extract::kind:
+                    {
+                        auto e = static_cast< Extract * >( op );
+                        return operand( op, 0 ).extractBits( e->extracted_size(),
+                                                             e->low_bit_inc );
+                    }
+                    case Concat::kind:
+                    {
+                        apint out( op->size, 0 );
+                        uint32_t current = 0;
+                        for ( std::size_t i = 0; i < op->operands_size(); ++i )
+                        {
+                            out.insertBits( operand( op, i ), current );
+                            current += op->operand( i )->size;
+                        }
+                        return out;
+                    }
+                    case Select::kind:
+                    {
+                        auto selected = operand( op, 0 ).getLimitedValue() + 1;
+                        if ( selected >= op->operands_size() )
+                            return {};
+                        return operand( op, selected );
+                    }
+                    case Not::kind:
+                        return ~operand( op, 0 );
+                    case And::kind:
+                        return nary( []( auto &out, auto &x ) { out &= x; } );
+                    case Or::kind:
+                        return nary( []( auto &out, auto &x ) { out |= x; } );
+                    case Xor::kind:
+                        return nary( []( auto &out, auto &x ) { out ^= x; } );
+                    case Icmp_eq::kind:
+                    case DecodeCondition::kind:
+                        return apint( 1, all_equal( op ) );
+                    case Icmp_ne::kind:
+                        return apint( 1, !all_equal( op ) );
+                    case DecoderResult::kind:
+                        for ( std::size_t i = 0; i < op->operands_size(); ++i )
+                            if ( operand( op, i ).isZero() )
+                                return apint( 1, 0 );
+                        return apint( 1, 1 );
+                    default:
+                        log_dbg() << "[decode]:" << "Cannot evaluate"
+                                  << pretty_print< false >( op ) << "in decoder.";
+                        return {};
+                }
+            }
+        };
+
+    } // namespace
+
+    std::optional< llvm::APInt > instruction_bits( std::string_view encoding, uint32_t size )
+    {
+        if ( encoding.size() * 8 > size )
+            return {};
+
+        apint out( size, 0 );
+        for ( std::size_t i = 0; i < encoding.size(); ++i )
+        {
+            auto byte = static_cast< uint8_t >( encoding[ i ] );
+            out.insertBits( apint( 8, byte ), static_cast< unsigned >( i * 8 ) );
+        }
+        return out;
+    }
+
+    std::vector< Operation * > accepting_contexts( Circuit *circuit, std::string_view encoding )
+    {
+        auto &inst_bits = circuit->attr< InputInstructionBits >();
+        if ( inst_bits.empty() )
+            return {};
+
+        auto bits = instruction_bits( encoding, ( *inst_bits.begin() )->size );
+        if ( !bits )
+            return {};
+
+        decoder_eval eval( *bits );
+        std::vector< Operation * > out;
+        for ( auto op : circuit->root->operands() )
+        {
+            auto ctx = dyn_cast< VerifyInstruction >( op );
+            if ( !ctx )
+                continue;
+
+            // A decoder that cannot be evaluated is not known to accept the encoding.
+            auto decoder = ctx->decoder();
+            if ( !decoder )
+                continue;
+            if ( auto accepts = eval.get( *decoder ); accepts && accepts->isOne() )
+                out.push_back( ctx );
+        }
+        return out;
+    }
+
+} // namespace circ
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#include <circuitous/IR/Link.hpp>
+
+#include <circuitous/Support/Check.hpp>
+#include <circuitous/Support/Log.hpp>
+
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace circ
+{
+    namespace
+    {
+        // Leaves that stand for the same input or output in every shard.
+        using shared_leaves_ts = tl::TL<
+            InputInstructionBits, Memory,
+            InputTimestamp, OutputTimestamp,
+            InputErrorFlag, OutputErrorFlag,
+            InputRegister, OutputRegister,
+            InputSyscallState, OutputSyscallState,
+            InputSyscallReg, OutputSyscallReg
+        >;
+
+        bool is_shared_leaf( Operation *op ) { return is_one_of( op, shared_leaves_ts{} ); }
+
+        // Creates an operation of the same kind and with the same attributes as `op`,
+        // operands are not copied.
+        Operation *clone( Circuit *into, Operation *op, std::size_t advice_offset )
+        {
+            auto make = [ & ]< typename T >() -> Operation *
+            {
+                auto typed = static_cast< T * >( op );
+                if constexpr ( std::is_same_v< T, Constant > )
+                    return into->create< T >( typed->bits, typed->size );
+                else if constexpr ( std::is_same_v< T, Extract > )
+                    return into->create< T >( typed->low_bit_inc, typed->high_bit_exc );
+                else if constexpr ( std::is_same_v< T, Select > )
+                    return into->create< T >( typed->bits, typed->size );
+                else if constexpr ( std::is_same_v< T, Advice > )
+                    return into->create< T >( typed->size, advice_offset + typed->advice_idx );
+                else if constexpr ( std::is_same_v< T, Memory > )
+                    return into->create< T >( typed->size, typed->mem_idx );
+                else if constexpr ( std::is_base_of_v< Register, T > ||
+                                    std::is_base_of_v< SyscallReg, T > )
+                    return into->create< T >( typed->reg_name, typed->size );
+                else if constexpr ( std::is_same_v< T, SyscallModule > )
+                    return into->create< T >();
+                else
+                    return into->create< T >( typed->size );
+            };
+            return dispatch_on_kind_to_all( op->op_code, make );
+        }
+
+        // Shared leaves are identified by their kind and name, everything else also
+        // by its size and (already linked) operands.
+        std::string structural_key( Operation *op, const std::vector< Operation * > &operands,
+                                    std::size_t advice_offset )
+        {
+            auto out = std::to_string( util::to_underlying( op->op_code ) );
+            auto add = [ & ]( const auto &x )
+            {
+                out += ":";
+                if constexpr ( std::is_convertible_v< decltype( x ), std::string > )
+                    out += x;
+                else
+                    out += std::to_string( x );
+            };
+
+            if ( auto c = dyn_cast< Constant >( op ) )
+                add( c->bits );
+            else if ( auto e = dyn_cast< Extract >( op ) )
+            {
+                add( e->low_bit_inc );
+                add( e->high_bit_exc );
+            }
+            else if ( auto s = dyn_cast< Select >( op ) )
+                add( s->bits );
+            else if ( auto a = dyn_cast< Advice >( op ) )
+                add( advice_offset + a->advice_idx );
+            else if ( auto m = dyn_cast< Memory >( op ) )
+                add( m->mem_idx );
+            else if ( auto reg = dynamic_cast< Register * >( op ) )
+                add( reg->reg_name );
+            else if ( auto sreg = dynamic_cast< SyscallReg * >( op ) )
+                add( sreg->reg_name );
+
+            if ( is_shared_leaf( op ) )
+                return out;
+
+            add( op->size );
+            for ( auto x : operands )
+                add( x->id() );
+            return out;
+        }
+
+        // Operands always precede their users, `root` is not included.
+        std::vector< Operation * > post_order( Operation *root )
+        {
+            std::vector< Operation * > out;
+            std::unordered_set< Operation * > seen = { root };
+            std::vector< std::pair< Operation *, std::size_t > > todo = { { root, 0 } };
+
+            while ( !todo.empty() )
+            {
+                auto &[ op, idx ] = todo.back();
+                if ( idx < op->operands_size() )
+                {
+                    auto next = op->operand( idx++ );
+                    if ( seen.insert( next ).second )
+                        todo.emplace_back( next, 0 );
+                    continue;
+                }
+                if ( op != root )
+                    out.push_back( op );
+                todo.pop_back();
+            }
+            return out;
+        }
+
+    } // namespace
+
+    CircuitLinker::CircuitLinker( Circuit::ptr_size_t ptr_size )
+        : circuit( std::make_unique< Circuit >( ptr_size ) )
+    {
+        circuit->root = circuit->create< OnlyOneCondition >();
+    }
+
+    Operation *CircuitLinker::import( Operation *op, const std::vector< Operation * > &operands,
+                                      std::size_t advice_offset )
+    {
+        // Each undefined value is distinct, even in one shard.
+        if ( isa< Undefined >( op ) )
+        {
+            ++_stats.created;
+            return clone( circuit.get(), op, advice_offset );
+        }
+
+        auto key = structural_key( op, operands, advice_offset );
+        if ( auto it = nodes.find( key ); it != nodes.end() )
+        {
+            auto linked = it->second;
+            check( linked->size == op->size )
+                << "Cannot link" << pretty_print< false >( op ) << "of size" << op->size
+                << "as it already has size" << linked->size;
+            ++_stats.reused;
+            return linked;
+        }
+
+        auto linked = clone( circuit.get(), op, advice_offset );
+        linked->add_operands( operands );
+        linked->meta = op->meta;
+
+        nodes.emplace( std::move( key ), linked );
+        ++_stats.created;
+        return linked;
+    }
+
+    CircuitLinker &CircuitLinker::add( Circuit *shard )
+    {
+        check( circuit != nullptr ) << "Linker was already used.";
+        check( shard->ptr_size == circuit->ptr_size )
+            << "Cannot link shard with pointer size" << shard->ptr_size
+            << "into circuit with pointer size" << circuit->ptr_size;
+        check( shard->root && isa< OnlyOneCondition >( shard->root ) )
+            << "Root of a shard is expected to be OnlyOneCondition.";
+
+        auto advice_offset = next_advice;
+        std::unordered_map< Operation *, Operation * > linked;
+
+        std::vector< Operation * > operands;
+        for ( auto op : post_order( shard->root ) )
+        {
+            operands.clear();
+            for ( auto x : op->operands() )
+                operands.push_back( linked.at( x ) );
+
+            linked[ op ] = import( op, operands, advice_offset );
+
+            if ( auto advice = dyn_cast< Advice >( op ) )
+                next_advice = std::max( next_advice, advice_offset + advice->advice_idx + 1 );
+        }
+
+        for ( auto ctx : shard->root->operands() )
+        {
+            auto linked_ctx = linked.at( ctx );
+            if ( !contexts.insert( linked_ctx ).second )
+                continue;
+
+            circuit->root->add_operand( linked_ctx );
+            ++_stats.contexts;
+        }
+
+        ++_stats.shards;
+        return *this;
+    }
+
+    circuit_owner_t CircuitLinker::take()
+    {
+        check( circuit != nullptr ) << "Linker was already used.";
+        nodes.clear();
+        contexts.clear();
+        return std::move( circuit );
+    }
+
+    circuit_owner_t link( std::vector< circuit_owner_t > &&shards )
+    {
+        check( !shards.empty() ) << "Nothing to link.";
+
+        CircuitLinker linker( shards.front()->ptr_size );
+        for ( auto &shard : shards )
+        {
+            linker.add( shard.get() );
+            shard.reset();
+        }
+        return linker.take();
+    }
+
+} // namespace circ
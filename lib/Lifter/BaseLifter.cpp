@@ -14,14 +14,26 @@
 #include <circuitous/Util/Warnings.hpp>
 
 CIRCUITOUS_RELAX_WARNINGS
-#include <llvm/IR/LegacyPassManager.h>
-#include <llvm/Transforms/IPO/PassManagerBuilder.h>
-#include <llvm/Transforms/IPO.h>
+#include <llvm/IR/PassInstrumentation.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Transforms/Scalar/EarlyCSE.h>
+#include <llvm/Transforms/Scalar/LowerExpectIntrinsic.h>
+#include <llvm/Transforms/Scalar/SROA.h>
+#include <llvm/Transforms/Scalar/SimplifyCFG.h>
 
 #include <llvm/Support/raw_os_ostream.h>
 #include <llvm/CodeGen/IntrinsicLowering.h>
 CIRCUITOUS_UNRELAX_WARNINGS
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+
 namespace circ {
 
     struct InstrinsicHandler {
@@ -194,31 +206,157 @@ namespace circ {
         }
     };
 
-    void optimize_silently(llvm::Module *module,
-                           const std::vector<llvm::Function *> &fns)
+    namespace
     {
-        llvm::legacy::FunctionPassManager func_manager(module);
+        struct pass_timing
+        {
+            using clock = std::chrono::steady_clock;
+
+            struct entry_t
+            {
+                std::uint64_t runs = 0;
+                double ms = 0;
+            };
+
+            std::atomic< bool > enabled = false;
+
+            std::mutex mtx;
+            std::map< std::string, entry_t > entries;
+
+            void add( llvm::StringRef name, clock::time_point start )
+            {
+                using ms_t = std::chrono::duration< double, std::milli >;
+                auto took = std::chrono::duration_cast< ms_t >( clock::now() - start );
+
+                std::lock_guard lock( mtx );
+                auto &entry = entries[ name.str() ];
+                ++entry.runs;
+                entry.ms += took.count();
+            }
+
+            static pass_timing &get()
+            {
+                static pass_timing instance;
+                return instance;
+            }
+        };
+
+        // Circuitous only optimizes functions that are (or are about to be) flattened
+        // into a loop-free data-flow, therefore this is the function simplification
+        // part of the legacy O3 pipeline `optimize_silently` used to build (loop,
+        // inlining and vectorization passes never ran as it was a function pass manager)
+        // and produces the same output.
+        //
+        // Passes are independent of `llvm::LLVMContext` and analyses are dropped after
+        // each run, one instance per thread is kept as lifting may run in parallel.
+        struct function_pipeline
+        {
+            using clock = pass_timing::clock;
+
+            llvm::PassInstrumentationCallbacks pic;
+            llvm::PassBuilder pb;
+
+            llvm::LoopAnalysisManager lam;
+            llvm::FunctionAnalysisManager fam;
+            llvm::CGSCCAnalysisManager cgam;
+            llvm::ModuleAnalysisManager mam;
+
+            llvm::FunctionPassManager fpm;
+
+            // Passes of a function pass manager do not nest.
+            clock::time_point started;
+
+            function_pipeline()
+                : pb( nullptr, llvm::PipelineTuningOptions(), llvm::None, &pic )
+            {
+                pb.registerModuleAnalyses( mam );
+                pb.registerCGSCCAnalyses( cgam );
+                pb.registerFunctionAnalyses( fam );
+                pb.registerLoopAnalyses( lam );
+                pb.crossRegisterProxies( lam, fam, cgam, mam );
+
+                pic.registerBeforeNonSkippedPassCallback( [ this ]( llvm::StringRef, llvm::Any )
+                {
+                    started = clock::now();
+                } );
+                pic.registerAfterPassCallback(
+                    [ this ]( llvm::StringRef name, llvm::Any, const llvm::PreservedAnalyses & )
+                    {
+                        if ( auto &timing = pass_timing::get(); timing.enabled )
+                            timing.add( name, started );
+                    } );
+
+                fpm.addPass( llvm::LowerExpectIntrinsicPass() );
+                fpm.addPass( llvm::SimplifyCFGPass() );
+            #if LLVM_VERSION_NUMBER >= LLVM_VERSION(16, 0)
+                fpm.addPass( llvm::SROAPass( llvm::SROAOptions::ModifyCFG ) );
+            #else
+                fpm.addPass( llvm::SROAPass() );
+            #endif
+                fpm.addPass( llvm::EarlyCSEPass( false ) );
+            }
+
+            void run( const std::vector< llvm::Function * > &fns )
+            {
+                for ( auto fn : fns )
+                    fpm.run( *fn, fam );
+
+                // Callers are free to erase the functions (and their modules).
+                fam.clear();
+                mam.clear();
+            }
+
+            static function_pipeline &get()
+            {
+                static thread_local function_pipeline instance;
+                return instance;
+            }
+        };
+
+    } // namespace
 
-        llvm::PassManagerBuilder builder;
-        builder.OptLevel = 3;
-        builder.SizeLevel = 0;
-        builder.Inliner = llvm::createFunctionInliningPass(250);
-        builder.DisableUnrollLoops = false;
-        builder.SLPVectorize = false;
-        builder.LoopVectorize = false;
+    void enable_pass_timing( bool enabled )
+    {
+        pass_timing::get().enabled = enabled;
+    }
 
-        builder.VerifyOutput = true;
-        builder.VerifyInput = false;
+    std::string pass_timing_report()
+    {
+        auto &timing = pass_timing::get();
 
-        builder.MergeFunctions = false;
+        std::vector< std::pair< std::string, pass_timing::entry_t > > sorted;
+        double total = 0;
+        {
+            std::lock_guard lock( timing.mtx );
+            for ( const auto &[ name, entry ] : timing.entries )
+            {
+                sorted.emplace_back( name, entry );
+                total += entry.ms;
+            }
+        }
 
-        builder.populateFunctionPassManager(func_manager);
-        func_manager.doInitialization();
-        for (auto fn : fns)
-            func_manager.run(*fn);
+        std::sort( sorted.begin(), sorted.end(), []( const auto &a, const auto &b )
+        {
+            return a.second.ms > b.second.ms;
+        } );
 
-        func_manager.doFinalization();
+        std::stringstream out;
+        out << "Pass execution timing report of optimize_silently:\n";
+        out << "  Total: " << std::fixed << std::setprecision( 2 ) << total << " ms\n";
+        for ( const auto &[ name, entry ] : sorted )
+        {
+            auto share = ( total > 0 ) ? 100.0 * entry.ms / total : 0.0;
+            out << "  " << std::setw( 10 ) << entry.ms << " ms "
+                << std::setw( 6 ) << share << "% "
+                << std::setw( 8 ) << entry.runs << " runs  " << name << "\n";
+        }
+        return out.str();
+    }
 
+    void optimize_silently(llvm::Module *,
+                           const std::vector<llvm::Function *> &fns)
+    {
+        function_pipeline::get().run(fns);
         InstrinsicHandler().lower(fns);
     }
 
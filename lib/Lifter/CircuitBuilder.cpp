@@ -12,6 +12,7 @@
 #include <circuitous/Lifter/Memory.hpp>
 #include <circuitous/Lifter/Instruction.hpp>
 #include <circuitous/Lifter/SelectFold.hpp>
+#include <circuitous/Lifter/SemanticsCache.hpp>
 #include <circuitous/Lifter/Undefs.hpp>
 
 #include <circuitous/Lifter/Components/Decoder.hpp>
@@ -683,7 +684,8 @@ namespace circ
 
         for (auto &fn : *ctx.module())
         {
-            if (!remill::HasOriginType< remill::Semantics >(&fn))
+            // Semantics that were never materialized are not annotated yet.
+            if (!fn.isMaterializable() && !remill::HasOriginType< remill::Semantics >(&fn))
                 continue;
             if (fn.isDeclaration())
                 continue;
@@ -752,7 +754,7 @@ namespace circ
 
         log_info() << "[exalt]: Fetching semantic ...";
         auto semantic = isem::semantic_fn( unit.isel, *ctx.module() );
-        post_lift( **semantic );
+        isem::post_lift( ctx, unit.isel, **semantic );
 
 
         log_info() << "[exalt]: Lifting & binding operands ...";
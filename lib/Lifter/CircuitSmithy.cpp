@@ -14,11 +14,21 @@ CIRCUITOUS_UNRELAX_WARNINGS
 #include <circuitous/Exalt/Lifter.hpp>
 #include <circuitous/Exalt/ISemLifters.hpp>
 
+#include <circuitous/Fuzz/FuzzEngine.hpp>
+
 #include <circuitous/Lifter/BaseLifter.hpp>
 #include <circuitous/Lifter/CircuitBuilder.hpp>
 #include <circuitous/Lifter/CircuitSmithy.hpp>
 #include <circuitous/Lifter/Lifter.hpp>
 #include <circuitous/Lifter/LLVMToCircIR.hpp>
+#include <circuitous/Lifter/SemanticsCache.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace circ
 {
@@ -39,6 +49,18 @@ namespace circ
         return out;
     }
 
+    void CircuitSmithy::log_cache_stats()
+    {
+        auto cache = ctx.isem_cache();
+        if ( !cache )
+            return;
+
+        auto stats = cache->stats();
+        log_info() << "[smithy]:" << "Semantics cache in" << cache->path().string()
+                   << "had" << stats.hits << "hits and" << stats.misses << "misses,"
+                   << stats.uncacheable << "semantics could not be cached.";
+    }
+
     auto CircuitSmithy::purify( const std::vector< InstBytes > &insts ) -> concretes_t
     {
         return freeze< std::vector >( decode_all( ctx, insts ) );
@@ -51,12 +73,16 @@ namespace circ
 
     auto CircuitSmithy::smelt( concretes_t &&concretes ) -> atoms_t
     {
+        auto engine = fuzz_engine( *ctx.arch(), ctx.os_name(), ctx.arch_name(), workers );
+        auto abstracts = engine.fuzz( concretes );
+
+        auto stats = engine.decode_stats();
+        log_info() << "[smithy]:" << "Decode cache of fuzzing had" << stats.hits << "hits and"
+                   << stats.misses << "misses.";
+
         atoms_t out;
-        for ( auto concrete : std::move( concretes ) )
-        {
-            auto abstract = fuzz_operands( *ctx.arch(), concrete );
-            out.emplace_back( std::move( concrete ), std::move( abstract ) );
-        }
+        for ( std::size_t i = 0; i < concretes.size(); ++i )
+            out.emplace_back( std::move( concretes[ i ] ), std::move( abstracts[ i ] ) );
 
         for ( auto &atom : out )
             atom.abstract.distribute_selectors();
@@ -64,17 +90,85 @@ namespace circ
         return out;
     }
 
-    auto CircuitSmithy::forge_common( exalt::circuit_producer &producer,
-                                         atoms_t &&atoms )
+    // All partitions select operands from translation maps of the whole worklist and
+    // identical selectors are merged into one in `merge_partial`, therefore the circuit
+    // is the same as the one lifted serially.
+    void CircuitSmithy::exalt_parallel( exalt::circuit_producer &producer,
+                                        const producer_setup_t &setup,
+                                        worklist_t &&worklist )
+    {
+        auto count = std::min( workers, worklist.size() );
+        std::vector< worklist_t > partitions( count );
+
+        std::size_t idx = 0;
+        exalt::TM_cache selectors( ctx );
+        selectors.build_from( worklist );
+        producer.add_operand_selector( selectors );
+
+        for ( auto &unit : worklist )
+            partitions[ idx++ % count ].add( std::move( unit ) );
+
+        // Contexts (and producers in them) are built on the calling thread, remill may
+        // initialize global state when building an arch or loading semantics. Workers
+        // only lift their units and export the result.
+        std::vector< std::unique_ptr< Ctx > > locals;
+        std::vector< std::unique_ptr< exalt::circuit_producer > > producers;
+        for ( std::size_t i = 0; i < count; ++i )
+        {
+            auto &local = locals.emplace_back(
+                std::make_unique< Ctx >( ctx.os_name(), ctx.arch_name() ) );
+            local->_isem_cache = ctx._isem_cache;
+
+            auto &partial = producers.emplace_back(
+                std::make_unique< exalt::circuit_producer >( *local ) );
+            setup( *partial );
+            partial->add_operand_selector( selectors );
+        }
+
+        std::vector< std::string > partials( count );
+        {
+            std::vector< std::jthread > threads;
+            for ( std::size_t i = 0; i < count; ++i )
+                threads.emplace_back( [ &, i ]
+                {
+                    for ( auto &unit : partitions[ i ] )
+                        producers[ i ]->exalt( unit );
+                    partials[ i ] = std::move( *producers[ i ] ).export_partial();
+                } );
+        }
+
+        for ( auto &bitcode : partials )
+            producer.merge_partial( bitcode );
+    }
+
+    auto CircuitSmithy::forge_common( const producer_setup_t &setup,
+                                      atoms_t &&atoms )
         -> circuit_ptr_t
     {
         auto worklist = categorize( std::move( atoms ) );
-
-        producer.add_operand_selector( worklist );
         log_info() << "[smithy]:" << "Worklist contains:" << worklist.size() << "entries!";
 
-        for ( auto &unit : worklist )
-            producer.exalt( unit );
+        auto producer = exalt::circuit_producer( ctx );
+        setup( producer );
+
+        auto start = std::chrono::steady_clock::now();
+        if ( workers > 1 && worklist.size() > 1 )
+        {
+            exalt_parallel( producer, setup, std::move( worklist ) );
+        }
+        else
+        {
+            producer.add_operand_selector( worklist );
+            for ( auto &unit : worklist )
+                producer.exalt( unit );
+        }
+
+        using ms = std::chrono::duration< double, std::milli >;
+        auto took = std::chrono::duration_cast< ms >( std::chrono::steady_clock::now() - start );
+        log_info() << "[smithy]:" << "Lifting with" << workers << "workers took"
+                   << took.count() << "ms.";
+        log_cache_stats();
+
         producer.finalize();
         auto circuit_fn = std::move( producer ).take_fn();
         return lower_fn( &*circuit_fn, ctx.ptr_size );
@@ -83,16 +177,20 @@ namespace circ
 
     auto CircuitSmithy::forge_disjunctions( concretes_t &&concrete ) -> circuit_ptr_t
     {
-        auto producer = exalt::circuit_producer( ctx );
-        producer.add_isem_lifter< exalt::disjunctions_lifter >();
-        return forge_common( producer, smelt( std::move( concrete ) ) );
+        auto setup = []( exalt::circuit_producer &producer )
+        {
+            producer.add_isem_lifter< exalt::disjunctions_lifter >();
+        };
+        return forge_common( setup, smelt( std::move( concrete ) ) );
     }
 
     auto CircuitSmithy::forge_mux_heavy( concretes_t &&concrete ) -> circuit_ptr_t
     {
-        auto producer = exalt::circuit_producer( ctx );
-        producer.add_isem_lifter< exalt::mux_heavy_lifter >();
-        return forge_common( producer, smelt( std::move( concrete ) ) );
+        auto setup = []( exalt::circuit_producer &producer )
+        {
+            producer.add_isem_lifter< exalt::mux_heavy_lifter >();
+        };
+        return forge_common( setup, smelt( std::move( concrete ) ) );
     }
 
     auto CircuitSmithy::forge_v3( concretes_t &&concrete ) -> circuit_ptr_t
@@ -104,6 +202,7 @@ namespace circ
         auto exalt_context = ExaltationContext( ctx, circuit_fn );
         for ( auto &unit : worklist )
             exalt_context.exalt( unit );
+        log_cache_stats();
 
         exalt_context.finalize();
         return lower_fn( &*circuit_fn, ctx.ptr_size );
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#include <circuitous/Lifter/Extend.hpp>
+
+#include <circuitous/IR/Decode.hpp>
+#include <circuitous/IR/Link.hpp>
+
+#include <circuitous/Support/Check.hpp>
+#include <circuitous/Support/Log.hpp>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace circ
+{
+    extension_plan plan_extension( CircuitSmithy &smithy, Circuit *base, const CIF &covered,
+                                   CircuitSmithy::concretes_t &&concretes )
+    {
+        extension_plan plan;
+
+        std::unordered_set< std::string > known;
+        std::unordered_map< std::string, std::vector< InstBytes > > covered_by_isel;
+        for ( const auto &[ bytes, isel ] : covered )
+        {
+            if ( !known.insert( bytes.data ).second )
+                continue;
+            covered_by_isel[ isel ].push_back( bytes );
+            plan.coverage.emplace_back( bytes, isel );
+        }
+
+        // Encodings accepted by a context of `base` are kept aside, if the context turns
+        // out to be stale they are lifted as well.
+        std::vector< std::pair< remill::Instruction, std::vector< Operation * > > > accepted;
+        std::unordered_set< std::string > fresh_isels;
+
+        for ( auto &inst : concretes )
+        {
+            if ( !known.insert( inst.bytes ).second )
+            {
+                ++plan.known;
+                continue;
+            }
+
+            plan.coverage.emplace_back( InstBytes( inst.bytes ), inst.function );
+            if ( auto ctxs = accepting_contexts( base, inst.bytes ); !ctxs.empty() )
+            {
+                ++plan.accepted;
+                accepted.emplace_back( std::move( inst ), std::move( ctxs ) );
+                continue;
+            }
+
+            ++plan.fresh;
+            fresh_isels.insert( inst.function );
+            plan.to_lift.push_back( std::move( inst ) );
+        }
+
+        for ( const auto &isel : fresh_isels )
+        {
+            auto it = covered_by_isel.find( isel );
+            if ( it == covered_by_isel.end() )
+                continue;
+
+            ++plan.changed_isels;
+            for ( auto &inst : smithy.purify( it->second ) )
+            {
+                for ( auto ctx : accepting_contexts( base, inst.bytes ) )
+                    plan.stale.insert( ctx );
+                plan.to_lift.push_back( std::move( inst ) );
+            }
+        }
+
+        for ( auto &[ inst, ctxs ] : accepted )
+        {
+            auto is_stale = [ & ]( auto ctx ) { return plan.stale.count( ctx ); };
+            if ( std::any_of( ctxs.begin(), ctxs.end(), is_stale ) )
+                plan.to_lift.push_back( std::move( inst ) );
+        }
+
+        log_info() << "[extend]:" << plan.known << "encodings are covered," << plan.accepted
+                   << "accepted by existing decoders," << plan.fresh << "are new;"
+                   << plan.changed_isels << "isels and" << plan.stale.size()
+                   << "contexts are lifted again.";
+        return plan;
+    }
+
+    circuit_owner_t splice( circuit_owner_t &&base, const extension_plan &plan,
+                            circuit_owner_t &&delta )
+    {
+        // Stale contexts are no longer reachable from the root, the linker therefore
+        // does not copy them (nor anything used only by them).
+        for ( auto ctx : plan.stale )
+            ctx->destroy();
+
+        CircuitLinker linker( base->ptr_size );
+        linker.add( base.get() );
+        base.reset();
+
+        auto reused = linker.stats().reused;
+        if ( delta )
+            linker.add( delta.get() );
+
+        const auto &stats = linker.stats();
+        log_info() << "[extend]:" << "Spliced circuit has" << stats.contexts << "contexts,"
+                   << stats.reused - reused << "nodes of the lifted one are shared.";
+        return linker.take();
+    }
+
+} // namespace circ
@@ -5,6 +5,7 @@
 #include <circuitous/Lifter/ISELBank.hpp>
 
 #include <circuitous/Lifter/BaseLifter.hpp>
+#include <circuitous/Lifter/Semantics.hpp>
 
 #include <circuitous/IR/Intrinsics.hpp>
 #include <circuitous/IR/Visitors.hpp>
@@ -182,10 +183,15 @@ namespace circ::isem
         -> std::optional< llvm::Function * >
     {
         log_info() << "[isem]: Fetching semantics for" << isel_name;
-        auto mapping = isel_map( in );
-        if ( auto it = mapping.find( "ISEL_" + isel_name ); it != mapping.end() )
-            return { it->second };
-        return {};
+        auto gv = in.getNamedGlobal( "ISEL_" + isel_name );
+        if ( !gv || !gv->hasInitializer() )
+            return {};
+
+        auto fn = llvm::dyn_cast< llvm::Function >( gv->getInitializer()->stripPointerCasts() );
+        check( fn ) << "ISEL_" + isel_name << "does not point to a function.";
+
+        materialize( *fn );
+        return { fn };
     }
 
     llvm::Instruction *ISem::reconstruct_arg( llvm::IRBuilder<> &irb,
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#include <circuitous/Lifter/Semantics.hpp>
+
+#include <circuitous/Support/Check.hpp>
+#include <circuitous/Support/Log.hpp>
+
+CIRCUITOUS_RELAX_WARNINGS
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+CIRCUITOUS_UNRELAX_WARNINGS
+
+#include <remill/Arch/Arch.h>
+#include <remill/Arch/Name.h>
+#include <remill/BC/Annotate.h>
+#include <remill/BC/Util.h>
+
+#include <unordered_set>
+
+namespace circ::isem
+{
+    std::unique_ptr< llvm::Module > load_semantics( const remill::Arch &arch )
+    {
+        auto arch_name = remill::GetArchName( arch.arch_name );
+        auto path = remill::FindSemanticsBitcodeFile( arch_name );
+        check( path ) << "Cannot find semantics of" << std::string( arch_name );
+
+        auto buffer = llvm::MemoryBuffer::getFile( path->string() );
+        check( buffer ) << "Cannot read semantics from" << path->string() << ":"
+                        << buffer.getError().message();
+
+        auto module = llvm::getOwningLazyBitcodeModule( std::move( *buffer ), *arch.context );
+        if ( !module )
+            log_kill() << "Cannot parse semantics from" << path->string() << ":"
+                       << llvm::toString( module.takeError() );
+
+        log_info() << "[isem]: Lazily loaded semantics from" << path->string();
+
+        arch.PrepareModule( module->get() );
+        for ( auto &fn : **module )
+            if ( fn.getName().startswith( "__remill" ) )
+                materialize( fn );
+
+        return std::move( *module );
+    }
+
+    void materialize( llvm::Function &root )
+    {
+        std::vector< llvm::GlobalValue * > todo = { &root };
+        std::unordered_set< llvm::GlobalValue * > seen = { &root };
+
+        while ( !todo.empty() )
+        {
+            auto gv = todo.back();
+            todo.pop_back();
+
+            if ( auto fn = llvm::dyn_cast< llvm::Function >( gv ) )
+            {
+                // Functions materialized before had their references visited then.
+                if ( !fn->isMaterializable() && fn != &root )
+                    continue;
+
+                if ( fn->isMaterializable() )
+                {
+                    if ( auto err = fn->materialize() )
+                        log_kill() << "Cannot materialize" << fn->getName().str() << ":"
+                                   << llvm::toString( std::move( err ) );
+                    remill::Annotate< remill::Semantics >( fn );
+                }
+            }
+
+            if ( gv->isDeclaration() )
+                continue;
+
+            for ( auto ref : referenced_globals( *gv ) )
+                if ( seen.insert( ref ).second )
+                    todo.push_back( ref );
+        }
+    }
+
+    std::vector< llvm::GlobalValue * > referenced_globals( llvm::GlobalValue &root )
+    {
+        std::vector< llvm::GlobalValue * > out;
+        std::unordered_set< llvm::Value * > seen;
+        std::vector< llvm::User * > todo;
+
+        if ( auto fn = llvm::dyn_cast< llvm::Function >( &root ) )
+            for ( auto &inst : llvm::instructions( fn ) )
+                todo.push_back( &inst );
+        else
+            todo.push_back( &root );
+
+        while ( !todo.empty() )
+        {
+            auto user = todo.back();
+            todo.pop_back();
+
+            for ( auto &op : user->operands() )
+            {
+                auto val = op.get();
+                if ( !seen.insert( val ).second )
+                    continue;
+
+                if ( auto gv = llvm::dyn_cast< llvm::GlobalValue >( val ) )
+                    out.push_back( gv );
+                else if ( auto c = llvm::dyn_cast< llvm::Constant >( val ) )
+                    todo.push_back( c );
+            }
+        }
+        return out;
+    }
+
+} // namespace circ::isem
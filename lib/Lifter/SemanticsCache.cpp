@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#include <circuitous/Lifter/SemanticsCache.hpp>
+
+#include <circuitous/Lifter/BaseLifter.hpp>
+#include <circuitous/Lifter/Semantics.hpp>
+
+#include <circuitous/Support/Check.hpp>
+#include <circuitous/Support/Log.hpp>
+#include <circuitous/Util/Warnings.hpp>
+
+CIRCUITOUS_RELAX_WARNINGS
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/DebugInfo.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Metadata.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+CIRCUITOUS_UNRELAX_WARNINGS
+
+#include <cctype>
+#include <cstdlib>
+#include <random>
+#include <system_error>
+#include <unordered_set>
+#include <vector>
+
+namespace circ::isem
+{
+    namespace
+    {
+        // Bump whenever format of entries or `post_lift` changes.
+        constexpr const char *format_version = "1";
+
+        // Printed IR refers to attribute groups and metadata by their numbers, which
+        // depend on the rest of the module. Numbers are dropped and attributes are
+        // printed separately.
+        std::string canonical_ir( llvm::GlobalValue &gv )
+        {
+            std::string printed;
+            llvm::raw_string_ostream os( printed );
+            gv.print( os );
+
+            if ( auto fn = llvm::dyn_cast< llvm::Function >( &gv ) )
+            {
+                fn->getAttributes().print( os );
+                for ( auto &inst : llvm::instructions( fn ) )
+                    if ( auto call = llvm::dyn_cast< llvm::CallBase >( &inst ) )
+                        call->getAttributes().print( os );
+            }
+            os.flush();
+
+            std::string out;
+            out.reserve( printed.size() );
+            for ( std::size_t i = 0; i < printed.size(); ++i )
+            {
+                auto c = printed[ i ];
+                bool is_ref = ( c == '#' || c == '!' ) && i + 1 < printed.size() &&
+                              std::isdigit( static_cast< unsigned char >( printed[ i + 1 ] ) );
+                out += c;
+                if ( !is_ref )
+                    continue;
+                while ( i + 1 < printed.size() &&
+                        std::isdigit( static_cast< unsigned char >( printed[ i + 1 ] ) ) )
+                {
+                    ++i;
+                }
+            }
+            return out;
+        }
+
+        // Semantics are loaded from a file, its identity stands for the version of
+        // semantics (metadata such as tbaa are not part of the canonical IR).
+        std::string semantics_id( llvm::Module &module )
+        {
+            auto path = std::filesystem::path( module.getModuleIdentifier() );
+            std::string out = path.string();
+
+            std::error_code ec;
+            if ( auto size = std::filesystem::file_size( path, ec ); !ec )
+                out += ":" + std::to_string( size );
+            if ( auto time = std::filesystem::last_write_time( path, ec ); !ec )
+                out += ":" + std::to_string( time.time_since_epoch().count() );
+            return out;
+        }
+
+        void erase_body( llvm::Function &fn )
+        {
+            for ( auto &bb : fn )
+                bb.dropAllReferences();
+            while ( !fn.empty() )
+                fn.begin()->eraseFromParent();
+        }
+
+    } // namespace
+
+    semantics_cache::semantics_cache( std::filesystem::path dir, std::string config )
+        : dir( std::move( dir ) ), config( std::move( config ) )
+    {
+        std::error_code ec;
+        std::filesystem::create_directories( this->dir, ec );
+        if ( ec )
+            log_error() << "[isem-cache]:" << "Cannot create" << this->dir.string()
+                        << ":" << ec.message();
+    }
+
+    std::filesystem::path semantics_cache::default_dir()
+    {
+        if ( auto xdg = std::getenv( "XDG_CACHE_HOME" ); xdg && *xdg )
+            return std::filesystem::path( xdg ) / "circuitous" / "isem";
+        if ( auto home = std::getenv( "HOME" ); home && *home )
+            return std::filesystem::path( home ) / ".cache" / "circuitous" / "isem";
+        return std::filesystem::temp_directory_path() / "circuitous-isem";
+    }
+
+    std::string semantics_cache::key( Ctx &ctx, const std::string &isel,
+                                      llvm::Function &fn ) const
+    {
+        llvm::SHA1 sha;
+        auto add = [ & ]( llvm::StringRef str )
+        {
+            sha.update( std::to_string( str.size() ) + ":" );
+            sha.update( str );
+        };
+
+        auto &module = *fn.getParent();
+        add( format_version );
+        add( LLVM_VERSION_STRING );
+        add( ctx.arch_name() );
+        add( ctx.os_name() );
+        add( config );
+        add( isel );
+        add( module.getDataLayoutStr() );
+        add( module.getTargetTriple() );
+        add( semantics_id( module ) );
+
+        std::unordered_set< llvm::GlobalValue * > seen = { &fn };
+        std::vector< llvm::GlobalValue * > todo = { &fn };
+        while ( !todo.empty() )
+        {
+            auto gv = todo.back();
+            todo.pop_back();
+
+            add( canonical_ir( *gv ) );
+            if ( gv->isDeclaration() )
+                continue;
+
+            for ( auto ref : referenced_globals( *gv ) )
+                if ( seen.insert( ref ).second )
+                    todo.push_back( ref );
+        }
+
+        auto hash = sha.final();
+        return llvm::toHex( hash, true );
+    }
+
+    bool semantics_cache::load( Ctx &ctx, llvm::Function &fn,
+                                const std::filesystem::path &file )
+    {
+        auto buffer = llvm::MemoryBuffer::getFile( file.string() );
+        if ( !buffer )
+            return false;
+
+        auto parsed = llvm::parseBitcodeFile( ( *buffer )->getMemBufferRef(),
+                                              *ctx.llvm_ctx() );
+        if ( !parsed )
+        {
+            log_error() << "[isem-cache]:" << "Ignoring corrupted" << file.string() << ":"
+                        << llvm::toString( parsed.takeError() );
+            return false;
+        }
+
+        auto &module = *fn.getParent();
+        check( !module.getFunction( cached_fn_name ) );
+
+        if ( llvm::Linker::linkModules( module, std::move( *parsed ) ) )
+        {
+            log_error() << "[isem-cache]:" << "Cannot link" << file.string();
+            return false;
+        }
+
+        auto cached = module.getFunction( cached_fn_name );
+        check( cached ) << "[isem-cache]:" << file.string() << "is missing its function.";
+
+        if ( cached->getFunctionType() != fn.getFunctionType() )
+        {
+            log_error() << "[isem-cache]:" << "Type of function in" << file.string()
+                        << "does not match" << fn.getName().str();
+            cached->eraseFromParent();
+            return false;
+        }
+
+        // Users of `fn` and its metadata (e.g. origin annotations of remill) are kept,
+        // only the body is replaced.
+        erase_body( fn );
+        fn.getBasicBlockList().splice( fn.end(), cached->getBasicBlockList() );
+        for ( unsigned i = 0; i < fn.arg_size(); ++i )
+            cached->getArg( i )->replaceAllUsesWith( fn.getArg( i ) );
+        cached->replaceAllUsesWith( &fn );
+
+        fn.setAttributes( cached->getAttributes() );
+        cached->eraseFromParent();
+
+        verify_or_die( fn );
+        return true;
+    }
+
+    bool semantics_cache::store( llvm::Function &fn, const std::filesystem::path &file )
+    {
+        // Local constants are copied along with the function, local functions would
+        // not be resolved back to the ones of semantics when linked.
+        std::unordered_set< const llvm::GlobalValue * > copied = { &fn };
+        for ( auto gv : referenced_globals( fn ) )
+        {
+            if ( gv == &fn || !gv->hasLocalLinkage() )
+                continue;
+
+            auto var = llvm::dyn_cast< llvm::GlobalVariable >( gv );
+            if ( !var || !var->isConstant() )
+                return false;
+            copied.insert( var );
+        }
+
+        llvm::ValueToValueMapTy vmap;
+        auto should_clone = [ & ]( const llvm::GlobalValue *gv )
+        {
+            return copied.count( gv ) != 0;
+        };
+        auto copy = llvm::CloneModule( *fn.getParent(), vmap, should_clone );
+
+        auto cached = llvm::cast< llvm::Function >( vmap[ &fn ] );
+        cached->setLinkage( llvm::GlobalValue::ExternalLinkage );
+        cached->setName( cached_fn_name );
+
+        llvm::StripDebugInfo( *copy );
+
+        for ( auto &other : llvm::make_early_inc_range( copy->functions() ) )
+            if ( &other != cached && other.use_empty() )
+                other.eraseFromParent();
+        for ( auto &gv : llvm::make_early_inc_range( copy->globals() ) )
+            if ( gv.use_empty() )
+                gv.eraseFromParent();
+        for ( auto &alias : llvm::make_early_inc_range( copy->aliases() ) )
+            if ( alias.use_empty() )
+                alias.eraseFromParent();
+
+        // Written under a unique name first, so concurrent readers never see
+        // a partial entry.
+        auto tmp = file;
+        tmp += ".tmp." + std::to_string( std::random_device{}() );
+
+        std::error_code ec;
+        {
+            llvm::raw_fd_ostream os( tmp.string(), ec );
+            if ( ec )
+                return false;
+            llvm::WriteBitcodeToFile( *copy, os );
+        }
+
+        std::filesystem::rename( tmp, file, ec );
+        if ( ec )
+        {
+            std::filesystem::remove( tmp, ec );
+            return false;
+        }
+        return true;
+    }
+
+    void semantics_cache::post_lift( Ctx &ctx, const std::string &isel, llvm::Function &fn )
+    {
+        auto file = dir / ( key( ctx, isel, fn ) + ".bc" );
+        if ( load( ctx, fn, file ) )
+        {
+            ++hits;
+            log_info() << "[isem-cache]:" << "Loaded" << isel << "from" << file.string();
+        }
+        else
+        {
+            ++misses;
+            circ::post_lift( fn );
+            if ( !store( fn, file ) )
+            {
+                ++uncacheable;
+                log_info() << "[isem-cache]:" << "Could not cache" << isel;
+            }
+        }
+    }
+
+    void post_lift( Ctx &ctx, const std::string &isel, llvm::Function &fn )
+    {
+        // Semantic functions are shared by all units with the same isel.
+        if ( fn.getMetadata( semantics_cache::processed_md ) )
+            return;
+
+        if ( auto cache = ctx.isem_cache() )
+            cache->post_lift( ctx, isel, fn );
+        else
+            circ::post_lift( fn );
+
+        // Entries of the cache carry no debug info, it is dropped from processed
+        // functions as well so the result does not depend on whether cache is used.
+        llvm::stripDebugInfo( fn );
+        fn.setMetadata( semantics_cache::processed_md,
+                        llvm::MDNode::get( fn.getContext(), {} ) );
+    }
+
+} // namespace circ::isem
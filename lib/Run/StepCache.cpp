@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2022 Trail of Bits, Inc.
+ */
+
+#include <circuitous/Run/StepCache.hpp>
+
+#include <circuitous/IR/Memory.hpp>
+#include <circuitous/Support/Check.hpp>
+
+CIRCUITOUS_RELAX_WARNINGS
+#include <llvm/ADT/APInt.h>
+#include <llvm/ADT/Hashing.h>
+CIRCUITOUS_UNRELAX_WARNINGS
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <unordered_set>
+
+namespace circ::run
+{
+    namespace
+    {
+        constexpr std::size_t hint_ts_idx = irops::memory::Layout::e_num - 1;
+
+        std::size_t bytes_of( const value_type &val )
+        {
+            if ( !val || val->isSingleWord() )
+                return sizeof( value_type );
+            return sizeof( value_type ) + val->getNumWords() * sizeof( uint64_t );
+        }
+
+        std::size_t bytes_of( const step_outcome &outcome )
+        {
+            std::size_t out = sizeof( step_outcome );
+            for ( const auto &hint : outcome.memory_hints )
+                out += sizeof( hint ) + hint.vals.size() * sizeof( llvm::APInt );
+            return out;
+        }
+
+    } // namespace
+
+    std::string step_cache::stats_t::to_string() const
+    {
+        std::stringstream ss;
+        ss << "hits: " << hits << ", misses: " << misses
+           << ", hit rate: " << std::fixed << std::setprecision( 2 ) << hit_rate() * 100
+           << "%, entries: " << entries << ", bytes: " << bytes
+           << ", evictions: " << evictions;
+        return ss.str();
+    }
+
+    step_cache::step_cache( circuit_ref_t circuit, step_cache_config config )
+        : config( config )
+    {
+        check( circuit && circuit->root ) << "[run:step-cache]: Circuit has no root.";
+
+        std::unordered_set< Operation * > seen;
+        std::vector< Operation * > todo = { circuit->root };
+        while ( !todo.empty() )
+        {
+            auto op = todo.back();
+            todo.pop_back();
+            if ( !seen.insert( op ).second )
+                continue;
+
+            if ( is_one_of( op, input_leaves_ts{} ) || is_one_of( op, output_leaves_ts{} ) )
+                leaves.push_back( op );
+
+            for ( auto operand : op->operands() )
+                todo.push_back( operand );
+        }
+
+        std::sort( leaves.begin(), leaves.end(),
+                   []( auto lhs, auto rhs ) { return lhs->id() < rhs->id(); } );
+
+        for ( auto op : leaves )
+            if ( isa< InputTimestamp >( op ) )
+                ts_in = op;
+
+        for ( auto op : circuit->attr< circ::Memory >() )
+        {
+            auto keyed = std::binary_search( leaves.begin(), leaves.end(), op,
+                []( auto lhs, auto rhs ) { return lhs->id() < rhs->id(); } );
+            hint_leaves.push_back( ( keyed ) ? op : nullptr );
+        }
+
+        irops::memory::Layout layout( circuit->ptr_size );
+        hint_ts_offset = 0;
+        for ( std::size_t i = 0; i < hint_ts_idx; ++i )
+            hint_ts_offset += layout.defs[ i ];
+    }
+
+    std::optional< llvm::APInt > step_cache::input_ts( const step_t &step ) const
+    {
+        if ( !config.relative_timestamps || !ts_in )
+            return {};
+
+        auto it = step.find( ts_in );
+        if ( it == step.end() || !it->second )
+            return {};
+        return it->second->zextOrTrunc( 64 );
+    }
+
+    auto step_cache::make_key( const step_t &step ) const -> key_t
+    {
+        auto ts = input_ts( step );
+        auto relative = [ & ]( const llvm::APInt &val )
+        {
+            return val - ts->zextOrTrunc( val.getBitWidth() );
+        };
+
+        key_t key;
+        key.values.reserve( leaves.size() );
+        llvm::hash_code hash = llvm::hash_value( leaves.size() );
+
+        for ( auto op : leaves )
+        {
+            auto it = step.find( op );
+            value_type val = ( it != step.end() ) ? it->second : std::nullopt;
+
+            if ( ts && val )
+            {
+                if ( isa< InputTimestamp >( op ) || isa< OutputTimestamp >( op ) )
+                    val = relative( *val );
+                else if ( isa< circ::Memory >( op ) )
+                    val->insertBits( relative( val->extractBits( 64, hint_ts_offset ) ),
+                                     hint_ts_offset );
+            }
+
+            hash = llvm::hash_combine( hash, ( val ) ? llvm::hash_value( *val )
+                                                     : llvm::hash_value( op->id() ) );
+            key.values.push_back( std::move( val ) );
+        }
+
+        key.hash = static_cast< std::size_t >( hash );
+        return key;
+    }
+
+    void step_cache::rebase( step_outcome &outcome, const step_t &step, bool relative ) const
+    {
+        auto ts = input_ts( step );
+        if ( !ts || outcome.memory_hints.empty() )
+            return;
+
+        check( outcome.memory_hints.size() == hint_leaves.size() )
+            << "[run:step-cache]: Memory hints do not match the circuit.";
+
+        for ( std::size_t i = 0; i < hint_leaves.size(); ++i )
+        {
+            // Mirrors `make_key`, which makes the timestamp relative only if it has a value.
+            if ( !hint_leaves[ i ] )
+                continue;
+            auto it = step.find( hint_leaves[ i ] );
+            if ( it == step.end() || !it->second )
+                continue;
+
+            auto &hint_ts = outcome.memory_hints[ i ].vals[ hint_ts_idx ];
+            auto shift = ts->zextOrTrunc( hint_ts.getBitWidth() );
+            hint_ts = ( relative ) ? hint_ts - shift : hint_ts + shift;
+        }
+    }
+
+    auto step_cache::lookup( const key_t &key, const step_t &step )
+        -> std::optional< step_outcome >
+    {
+        std::unique_lock lock( mtx );
+
+        auto it = entries.find( key );
+        if ( it == entries.end() )
+        {
+            ++counters.misses;
+            return {};
+        }
+
+        ++counters.hits;
+        lru.splice( lru.begin(), lru, it->second.position );
+        auto out = it->second.outcome;
+        lock.unlock();
+
+        rebase( out, step, false );
+        return out;
+    }
+
+    void step_cache::insert( key_t key, step_outcome outcome, const step_t &step )
+    {
+        rebase( outcome, step, true );
+
+        auto bytes = sizeof( key_t ) + sizeof( cached_t ) + 4 * sizeof( void * )
+                   + bytes_of( outcome );
+        for ( const auto &val : key.values )
+            bytes += bytes_of( val );
+
+        std::lock_guard lock( mtx );
+
+        auto [ it, inserted ] = entries.try_emplace( std::move( key ),
+                                                     cached_t{ std::move( outcome ), bytes,
+                                                               lru.end() } );
+        // Some other thread was faster.
+        if ( !inserted )
+            return;
+
+        lru.push_front( &it->first );
+        it->second.position = lru.begin();
+        counters.bytes += bytes;
+        evict();
+    }
+
+    void step_cache::evict()
+    {
+        while ( counters.bytes > config.max_bytes && !lru.empty() )
+        {
+            auto it = entries.find( *lru.back() );
+            check( it != entries.end() ) << "[run:step-cache]: LRU is out of sync.";
+
+            counters.bytes -= it->second.bytes;
+            ++counters.evictions;
+            lru.pop_back();
+            entries.erase( it );
+        }
+    }
+
+    auto step_cache::stats() const -> stats_t
+    {
+        std::lock_guard lock( mtx );
+        auto out = counters;
+        out.entries = entries.size();
+        return out;
+    }
+
+} // namespace circ::run
@@ -8,18 +8,158 @@
 #include <llvm/ADT/APSInt.h>
 #include <llvm/ADT/Twine.h>
 
+#include <functional>
+#include <initializer_list>
 #include <optional>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
 #include <variant>
 
 namespace circ
 {
     std::string node_name( const node_template &op ) {
-        return std::visit( [](const auto &o) { return o.op_code_name; }, op );
+        return node_symbol(op).name();
+    }
+
+    eqsat::symbol_t node_symbol( const node_template &op ) {
+        return std::visit( [](const auto &o) { return o.op_code; }, op );
+    }
+
+    gap::hash_code hash_value( gap::hash_code code, const node_template &op ) {
+        auto combine = [&] (const auto &value) {
+            using value_type = std::decay_t< decltype(value) >;
+            code = gap::hash_combine(code, gap::hash_code(std::hash< value_type >{}(value)));
+        };
+
+        combine(op.index());
+        std::visit( gap::overloaded {
+            [&] (const op_code_node  &o) { combine(o.op_code); },
+            [&] (const sized_node    &o) { combine(o.op_code); combine(o.size); },
+            [&] (const advice_node   &o) { combine(o.op_code); combine(o.size); combine(o.idx); },
+            [&] (const register_node &o) { combine(o.op_code); combine(o.size); combine(o.reg); },
+            [&] (const constant_node &o) { combine(o.op_code); combine(o.size); combine(o.bits); },
+            [&] (const memory_node   &o) { combine(o.op_code); combine(o.size); combine(o.idx); },
+            [&] (const extract_node  &o) { combine(o.op_code); combine(o.low_bit_inc); combine(o.high_bit_exc); },
+            [&] (const select_node   &o) { combine(o.op_code); combine(o.size); combine(o.bits); }
+        }, op );
+        return code;
+    }
+
+    bool hashconsed( const node_template &op ) {
+        // see `Undefined`, two of them of the same width are not the same value
+        static const auto undefined = eqsat::intern( Undefined::op_code_str() );
+        return node_symbol(op) != undefined;
+    }
+
+    void save_storage(eqsat::snapshot_output &out, const node_template &op) {
+        out.write(op.index());
+        std::visit( gap::overloaded {
+            [&] (const op_code_node  &o) { out.write(o.op_code); },
+            [&] (const sized_node    &o) { out.write(o.op_code); out.write(o.size); },
+            [&] (const advice_node   &o) { out.write(o.op_code); out.write(o.size); out.write(o.idx); },
+            [&] (const register_node &o) { out.write(o.op_code); out.write(o.size); out.write(o.reg); },
+            [&] (const constant_node &o) { out.write(o.op_code); out.write(o.size); out.write(o.bits); },
+            [&] (const memory_node   &o) { out.write(o.op_code); out.write(o.size); out.write(o.idx); },
+            [&] (const extract_node  &o) { out.write(o.op_code); out.write(o.low_bit_inc); out.write(o.high_bit_exc); },
+            [&] (const select_node   &o) { out.write(o.op_code); out.write(o.size); out.write(o.bits); }
+        }, op );
+    }
+
+    node_template load_storage(eqsat::snapshot_input &in, std::type_identity< node_template >) {
+        static_assert(std::variant_size_v< node_template > == 8);
+
+        // braced initializers are evaluated in order, i.e., in the order of `save_storage`
+        switch (in.read< std::size_t >()) {
+            case 0: return op_code_node{ in.read_symbol() };
+            case 1: return sized_node{ in.read_symbol(), in.read_optional< bitwidth_t >() };
+            case 2: return advice_node{
+                in.read_symbol(), in.read_optional< bitwidth_t >(), in.read_optional< std::uint32_t >()
+            };
+            case 3: return register_node{ in.read_symbol(), in.read< bitwidth_t >(), in.read_symbol() };
+            case 4: return constant_node{ in.read_symbol(), in.read< bitwidth_t >(), in.read_symbol() };
+            case 5: return memory_node{
+                in.read_symbol(), in.read_optional< bitwidth_t >(), in.read_optional< std::uint32_t >()
+            };
+            case 6: return extract_node{
+                in.read_symbol(), in.read< std::uint32_t >(), in.read< std::uint32_t >()
+            };
+            case 7: return select_node{ in.read_symbol(), in.read< bitwidth_t >(), in.read< std::uint32_t >() };
+        }
+
+        throw eqsat::snapshot_error("invalid node template in snapshot");
+    }
+
+    namespace
+    {
+        enum class synthesized_kind { opcode, sized, predicate };
+
+        const auto &synthesized_kinds() {
+            static const auto kinds = [] {
+                std::unordered_map< eqsat::symbol_t, synthesized_kind > out;
+                auto add = [&] (synthesized_kind kind, std::initializer_list< std::string_view > names) {
+                    for (auto name : names) {
+                        out.emplace(eqsat::intern(name), kind);
+                    }
+                };
+
+                add(synthesized_kind::opcode, {
+                    "register_constraint", "advice_constraint", "write_constraint",
+                    "read_constraint", "unused_constraint", "parity", "DecodeCondition",
+                    "DecoderResult", "VerifyInstruction", "OnlyOneCondition"
+                });
+
+                add(synthesized_kind::sized, {
+                    "in.timestamp", "out.timestamp", "in.error_flag", "out.error_flag",
+                    "undefined", "instruction_bits",
+                    // binary sized
+                    "Add", "Sub", "Mul", "UDiv", "SDiv", "URem", "Xor", "SRem", "Shl", "LShr",
+                    "AShr", "Trunc", "ZExt", "SExt",
+                    // concat
+                    "concat",
+                    // bitops
+                    "Or", "And",
+                    // input
+                    "input_immediate",
+                    // other
+                    "pop_count", "count_lead_zeroes", "count_trailing_zeroes", "not", "Switch",
+                    "Option"
+                });
+
+                // binary relational
+                add(synthesized_kind::predicate, {
+                    "Icmp_ult", "Icmp_slt", "Icmp_ugt", "Icmp_eq", "Icmp_ne", "Icmp_uge",
+                    "Icmp_ule", "Icmp_sgt", "Icmp_sge", "Icmp_sle"
+                });
+
+                return out;
+            }();
+
+            return kinds;
+        }
+
+    } // anonymous namespace
+
+    std::optional< node_template > synthesize_node_template(
+        eqsat::symbol_t op, maybe_bitwidth_t size
+    ) {
+        auto it = synthesized_kinds().find(op);
+        if (it == synthesized_kinds().end()) {
+            return std::nullopt;
+        }
+
+        switch (it->second) {
+            case synthesized_kind::opcode:    return op_code_node{ op };
+            case synthesized_kind::sized:     return sized_node{ op, size };
+            case synthesized_kind::predicate: return sized_node{ op, 1 };
+        }
+
+        return std::nullopt;
     }
 
     std::optional< gap::bigint > extract_constant( const node_template &op ) {
         if (auto con = std::get_if< constant_node >(&op) ) {
-            return gap::bigint(con->size, con->bits, 2);
+            return gap::bigint(con->size, con->bits.name(), 2);
         }
         return std::nullopt;
     }
@@ -27,29 +167,29 @@ namespace circ
     std::string to_string(const node_template &op) {
         return std::visit( gap::overloaded {
             [] (const op_code_node  &o) {
-                return o.op_code_name;
+                return o.op_code.name();
             },
             [] (const sized_node    &o) {
-                return o.op_code_name + "." + std::to_string(o.size.value());
+                return o.op_code.name() + "." + std::to_string(o.size.value());
             },
             [] (const advice_node   &o) {
-                return o.op_code_name + "." + std::to_string(o.size.value()) + "." + std::to_string(o.idx.value());
+                return o.op_code.name() + "." + std::to_string(o.size.value()) + "." + std::to_string(o.idx.value());
             },
             [] (const register_node &o) {
-                return o.op_code_name + "." + o.reg_name;
+                return o.op_code.name() + "." + o.reg.name();
             },
             [] (const memory_node   &o) {
-                return o.op_code_name + "." + std::to_string(o.size.value()) + "." + std::to_string(o.idx.value());
+                return o.op_code.name() + "." + std::to_string(o.size.value()) + "." + std::to_string(o.idx.value());
             },
             [] (const extract_node  &o) {
-                return o.op_code_name + "." + std::to_string(o.low_bit_inc) + "." + std::to_string(o.high_bit_exc);
+                return o.op_code.name() + "." + std::to_string(o.low_bit_inc) + "." + std::to_string(o.high_bit_exc);
             },
             [] (const select_node   &o) {
-                return o.op_code_name + "." + std::to_string(o.size) + "." + std::to_string(o.bits);
+                return o.op_code.name() + "." + std::to_string(o.size) + "." + std::to_string(o.bits);
             },
             [] (const constant_node &o) {
                 llvm::SmallVector< char > str;
-                llvm::APSInt(o.bits).toStringUnsigned(str);
+                llvm::APSInt(o.bits.name()).toStringUnsigned(str);
                 return llvm::Twine(str).str();
             }
         }, op );
@@ -7,6 +7,8 @@
 #include <circuitous/Transforms/CircuitBuilder.hpp>
 #include <circuitous/Transforms/EqSatCost.hpp>
 #include <circuitous/Transforms/EqualitySaturation.hpp>
+#include <circuitous/Support/Check.hpp>
+#include <circuitous/Support/Log.hpp>
 #include <eqsat/algo/saturation.hpp>
 #include <eqsat/algo/print.hpp>
 #include <eqsat/core/egraph.hpp>
@@ -22,19 +24,53 @@ namespace circ
 
     using circuit_saturable_egraph = eqsat::saturable_egraph< circuit_egraph >;
 
-    circuit_owner_t run_equality_saturation(circuit_owner_t &&circuit, std::span< eqsat::rule_set > rules) {
-
+    circuit_owner_t run_equality_saturation(
+        circuit_owner_t &&circuit, std::span< eqsat::rule_set > rules,
+        const eqsat::saturation_config &config,
+        const eqsat::extraction_config &extraction,
+        const std::filesystem::path &resume
+    ) {
         spdlog::debug("[eqsat] start equality saturation");
+        // the egraph is built even when resuming, ids of its nodes are the same as in
+        // the snapshot of the saturation
         auto [graph, nodes_map] = make_circuit_egraph(circuit);
+        log_info() << "[eqsat]:" << "Initial egraph:" << graph.num_of_nodes() << "nodes,"
+                   << graph.num_of_eclasses() << "classes.";
+
+        auto root = nodes_map.at(circuit->root);
+
+        eqsat::saturation_snapshot< circuit_egraph > start{
+            circuit_saturable_egraph(std::move(graph))
+        };
 
-        auto [saturated, status] = eqsat::saturate(
-            circuit_saturable_egraph(std::move(graph)), rules
-        );
+        if (!resume.empty()) {
+            auto origin = eqsat::fingerprint(start.graph);
+            start = eqsat::load_snapshot< circuit_egraph >(resume);
+            check(start.origin == origin)
+                << "Snapshot" << resume.string() << "is not a saturation of the lifted circuit.";
+            log_info() << "[eqsat]:" << "Resumed from" << resume.string() << "at iteration"
+                       << start.iteration << ":" << start.graph.num_of_nodes() << "nodes,"
+                       << start.graph.num_of_eclasses() << "classes.";
+        }
+
+        eqsat::saturation_stats stats;
+        auto [saturated, status] = eqsat::saturate(std::move(start), rules, config, stats);
+
+        for (const auto &iteration : stats.iterations) {
+            log_info() << "[eqsat]:" << eqsat::to_string(iteration);
+        }
+        log_info() << "[eqsat]:" << "Stopped on" << eqsat::to_string(status) << "after"
+                   << stats.iterations.size() << "iterations," << stats.total_ms << "ms.";
 
         auto optimal = make_optimal_circuit_graph(std::move(saturated));
         spdlog::debug("[eqsat] stop equality saturation");
 
-        auto root = nodes_map.at(circuit->root);
+        if (extraction.dag) {
+            auto greedy = optimal.dag_cost(root).value();
+            auto shared = optimal.improve_sharing(root, extraction.max_trials);
+            log_info() << "[eqsat]:" << "DAG cost of extraction" << greedy << "->" << shared;
+        }
+
         return extract_circuit_from_egraph(optimal).extract(root, circuit->ptr_size);
     }
 
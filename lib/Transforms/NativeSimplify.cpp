@@ -0,0 +1,815 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#include <circuitous/Transforms/Passes.hpp>
+
+#include <circuitous/Support/Check.hpp>
+#include <circuitous/Support/Log.hpp>
+#include <circuitous/Util/Warnings.hpp>
+
+CIRCUITOUS_RELAX_WARNINGS
+#include <llvm/ADT/APInt.h>
+#include <llvm/ADT/StringRef.h>
+CIRCUITOUS_UNRELAX_WARNINGS
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace circ
+{
+    namespace
+    {
+        using apint = llvm::APInt;
+
+        // Nodes that compute their value only from their operands and therefore can be
+        // merged if they are structurally equal.
+        bool is_pure( Operation *op )
+        {
+            return is_one_of( op, llvm_ops_t{} ) || is_one_of( op, bit_manips_ts{} ) ||
+                   is_one_of( op, bit_ops_ts{} ) ||
+                   is_one_of< Constant, Select, InputImmediate, DecodeCondition >( op );
+        }
+
+        bool is_commutative( Operation *op )
+        {
+            return is_one_of< Add, Mul, And, Or, Xor, Icmp_eq, Icmp_ne >( op );
+        }
+
+        struct node_key
+        {
+            Operation::kind_t kind;
+            uint32_t size;
+            uint64_t lhs = 0;
+            uint64_t rhs = 0;
+            std::string bits;
+            std::vector< Operation * > operands;
+
+            explicit node_key( Operation *op )
+                : kind( op->op_code ), size( op->size ),
+                  operands( op->begin(), op->end() )
+            {
+                if ( auto c = dyn_cast< Constant >( op ) )
+                    bits = c->bits;
+                if ( auto e = dyn_cast< Extract >( op ) )
+                {
+                    lhs = e->low_bit_inc;
+                    rhs = e->high_bit_exc;
+                }
+                if ( auto s = dyn_cast< Select >( op ) )
+                    lhs = s->bits;
+
+                if ( is_commutative( op ) )
+                {
+                    auto by_id = []( auto a, auto b ) { return a->id() < b->id(); };
+                    std::sort( operands.begin(), operands.end(), by_id );
+                }
+            }
+
+            bool operator==( const node_key & ) const = default;
+
+            struct hash
+            {
+                std::size_t operator()( const node_key &key ) const
+                {
+                    auto out = std::hash< std::string >{}( key.bits );
+                    auto combine = [ & ]( std::size_t x )
+                    {
+                        out ^= x + 0x9e3779b97f4a7c15ull + ( out << 6 ) + ( out >> 2 );
+                    };
+
+                    combine( util::to_underlying( key.kind ) );
+                    combine( key.size );
+                    combine( key.lhs );
+                    combine( key.rhs );
+                    for ( auto op : key.operands )
+                        combine( std::hash< Operation * >{}( op ) );
+                    return out;
+                }
+            };
+        };
+
+        std::optional< apint > value_of( Operation *op )
+        {
+            auto c = dyn_cast< Constant >( op );
+            if ( !c || c->size == 0 )
+                return {};
+            std::string bits{ c->bits.rbegin(), c->bits.rend() };
+            return apint( c->size, bits, /*radix=*/2U );
+        }
+
+        bool has_value( Operation *op, uint64_t x )
+        {
+            auto v = value_of( op );
+            return v && *v == x;
+        }
+
+        bool is_zero( Operation *op ) { return has_value( op, 0 ); }
+        bool is_one( Operation *op ) { return has_value( op, 1 ); }
+
+        bool is_all_ones( Operation *op )
+        {
+            auto v = value_of( op );
+            return v && v->isAllOnes();
+        }
+
+        // All operands have the same size as the result.
+        bool is_uniform( Operation *op )
+        {
+            for ( auto x : op->operands() )
+                if ( x->size != op->size )
+                    return false;
+            return true;
+        }
+
+        struct simplifier
+        {
+            struct stats_t
+            {
+                std::size_t folded = 0;
+                std::size_t simplified = 0;
+                std::size_t merged = 0;
+            };
+
+            static constexpr std::size_t max_rewrites = 32;
+
+            Circuit *circuit;
+            stats_t stats;
+            std::unordered_map< node_key, Operation *, node_key::hash > canonical_nodes;
+
+            explicit simplifier( Circuit *circuit ) : circuit( circuit ) {}
+
+            // Returns `true` if anything in the circuit was changed.
+            bool sweep()
+            {
+                // Any node can be rewritten in a sweep, therefore nodes from previous ones
+                // are no longer canonical.
+                canonical_nodes.clear();
+
+                bool changed = false;
+                for ( auto op : post_order() )
+                {
+                    // Already replaced.
+                    if ( op != circuit->root && op->users_size() == 0 )
+                        continue;
+
+                    auto replacement = canonical( op );
+                    if ( replacement == op )
+                        continue;
+
+                    check( replacement->size == op->size )
+                        << "Simplification of" << pretty_print< false >( op )
+                        << "changed its size.";
+
+                    op->replace_all_uses_with( replacement );
+                    if ( op == circuit->root )
+                        circuit->root = replacement;
+                    changed = true;
+                }
+                return changed;
+            }
+
+          private:
+
+            // Operands always precede their users.
+            std::vector< Operation * > post_order()
+            {
+                std::vector< Operation * > out;
+                if ( !circuit->root )
+                    return out;
+
+                std::unordered_set< Operation * > seen = { circuit->root };
+                std::vector< std::pair< Operation *, std::size_t > > todo =
+                {
+                    { circuit->root, 0 }
+                };
+
+                while ( !todo.empty() )
+                {
+                    auto &[ op, idx ] = todo.back();
+                    if ( idx < op->operands_size() )
+                    {
+                        auto next = op->operand( idx++ );
+                        if ( seen.insert( next ).second )
+                            todo.emplace_back( next, 0 );
+                        continue;
+                    }
+                    out.push_back( op );
+                    todo.pop_back();
+                }
+                return out;
+            }
+
+            // Expects operands of `op` to be canonical already.
+            Operation *canonical( Operation *op )
+            {
+                for ( std::size_t i = 0; i < max_rewrites; ++i )
+                {
+                    auto next = rewrite( op );
+                    if ( !next || next == op )
+                        break;
+                    op = next;
+                }
+                return intern( op );
+            }
+
+            Operation *intern( Operation *op )
+            {
+                if ( !is_pure( op ) )
+                    return op;
+
+                auto [ it, inserted ] = canonical_nodes.emplace( node_key( op ), op );
+                if ( !inserted && it->second != op )
+                    ++stats.merged;
+                return it->second;
+            }
+
+            /* Construction of new nodes */
+
+            template< typename T, typename ... Args >
+            Operation *make( const std::vector< Operation * > &operands, Args && ... args )
+            {
+                auto op = circuit->create< T >( std::forward< Args >( args ) ... );
+                op->add_operands( operands );
+                return canonical( op );
+            }
+
+            Operation *constant( const apint &value )
+            {
+                std::string bits;
+                for ( uint32_t i = 0; i < value.getBitWidth(); ++i )
+                    bits += value[ i ] ? '1' : '0';
+                return intern( circuit->create< Constant >( std::move( bits ),
+                                                            value.getBitWidth() ) );
+            }
+
+            Operation *constant( uint32_t size, uint64_t value )
+            {
+                return constant( apint( size, value ) );
+            }
+
+            Operation *extract( Operation *from, uint32_t low, uint32_t high )
+            {
+                if ( low == 0 && high == from->size )
+                    return from;
+                return make< Extract >( { from }, low, high );
+            }
+
+            /* Rewrites, each returns the replacement or `nullptr` */
+
+            Operation *rewrite( Operation *op )
+            {
+                if ( isa< Constant >( op ) )
+                    return nullptr;
+
+                if ( auto value = fold( op ) )
+                {
+                    ++stats.folded;
+                    return constant( *value );
+                }
+
+                auto out = simplify( op );
+                if ( out )
+                    ++stats.simplified;
+                return out;
+            }
+
+            std::optional< apint > fold( Operation *op )
+            {
+                if ( op->operands_size() == 0 )
+                    return {};
+
+                std::vector< apint > v;
+                for ( auto x : op->operands() )
+                {
+                    auto value = value_of( x );
+                    if ( !value )
+                        return {};
+                    v.push_back( std::move( *value ) );
+                }
+
+                auto same_width = [ & ]( uint32_t width )
+                {
+                    for ( const auto &x : v )
+                        if ( x.getBitWidth() != width )
+                            return false;
+                    return true;
+                };
+
+                auto binary = [ & ]( auto &&fn ) -> std::optional< apint >
+                {
+                    if ( v.size() != 2 || !same_width( op->size ) )
+                        return {};
+                    return fn( v[ 0 ], v[ 1 ] );
+                };
+
+                auto cmp = [ & ]( auto &&fn ) -> std::optional< apint >
+                {
+                    if ( v.size() != 2 || !same_width( v[ 0 ].getBitWidth() ) )
+                        return {};
+                    return apint( op->size, fn( v[ 0 ], v[ 1 ] ) ? 1 : 0 );
+                };
+
+                // Results of these are not defined in llvm, leave them as they are.
+                auto div = [ & ]( auto &&fn ) -> std::optional< apint >
+                {
+                    return binary( [ & ]( auto &l, auto &r ) -> std::optional< apint >
+                    {
+                        if ( r.isZero() )
+                            return {};
+                        bool overflow = false;
+                        auto out = fn( l, r, overflow );
+                        if ( overflow )
+                            return {};
+                        return out;
+                    } );
+                };
+
+                auto shift = [ & ]( auto &&fn ) -> std::optional< apint >
+                {
+                    return binary( [ & ]( auto &l, auto &r ) -> std::optional< apint >
+                    {
+                        if ( r.uge( l.getBitWidth() ) )
+                            return {};
+                        return fn( l, r );
+                    } );
+                };
+
+                auto nary = [ & ]( auto &&fn ) -> std::optional< apint >
+                {
+                    if ( !same_width( op->size ) )
+                        return {};
+                    auto out = v[ 0 ];
+                    for ( std::size_t i = 1; i < v.size(); ++i )
+                        fn( out, v[ i ] );
+                    return out;
+                };
+
+                auto unary = [ & ]( auto &&fn ) -> std::optional< apint >
+                {
+                    if ( v.size() != 1 )
+                        return {};
+                    return fn( v[ 0 ] );
+                };
+
+                switch ( op->op_code )
+                {
+                    case Add::kind: return binary( []( auto &l, auto &r ) { return l + r; } );
+                    case Sub::kind: return binary( []( auto &l, auto &r ) { return l - r; } );
+                    case Mul::kind: return binary( []( auto &l, auto &r ) { return l * r; } );
+                    case Xor::kind: return binary( []( auto &l, auto &r ) { return l ^ r; } );
+
+                    case UDiv::kind:
+                        return div( []( auto &l, auto &r, bool & ) { return l.udiv( r ); } );
+                    case SDiv::kind:
+                        return div( []( auto &l, auto &r, bool &o ) { return l.sdiv_ov( r, o ); } );
+                    case URem::kind:
+                        return div( []( auto &l, auto &r, bool & ) { return l.urem( r ); } );
+                    case SRem::kind:
+                        return div( []( auto &l, auto &r, bool &o )
+                        {
+                            // Same overflow as of `sdiv`.
+                            o = l.isMinSignedValue() && r.isAllOnes();
+                            return l.srem( r );
+                        } );
+
+                    case Shl::kind:
+                        return shift( []( auto &l, auto &r ) { return l.shl( r ); } );
+                    case LShr::kind:
+                        return shift( []( auto &l, auto &r ) { return l.lshr( r ); } );
+                    case AShr::kind:
+                        return shift( []( auto &l, auto &r ) { return l.ashr( r ); } );
+
+                    case Trunc::kind:
+                    case ZExt::kind:
+                        return unary( [ & ]( auto &x ) { return x.zextOrTrunc( op->size ); } );
+                    case SExt::kind:
+                        return unary( [ & ]( auto &x ) { return x.sextOrTrunc( op->size ); } );
+
+                    case Icmp_ult::kind: return cmp( []( auto &l, auto &r ) { return l.ult( r ); } );
+                    case Icmp_slt::kind: return cmp( []( auto &l, auto &r ) { return l.slt( r ); } );
+                    case Icmp_ugt::kind: return cmp( []( auto &l, auto &r ) { return l.ugt( r ); } );
+                    case Icmp_eq::kind:  return cmp( []( auto &l, auto &r ) { return l == r; } );
+                    case Icmp_ne::kind:  return cmp( []( auto &l, auto &r ) { return l != r; } );
+                    case Icmp_uge::kind: return cmp( []( auto &l, auto &r ) { return l.uge( r ); } );
+                    case Icmp_ule::kind: return cmp( []( auto &l, auto &r ) { return l.ule( r ); } );
+                    case Icmp_sgt::kind: return cmp( []( auto &l, auto &r ) { return l.sgt( r ); } );
+                    case Icmp_sge::kind: return cmp( []( auto &l, auto &r ) { return l.sge( r ); } );
+                    case Icmp_sle::kind: return cmp( []( auto &l, auto &r ) { return l.sle( r ); } );
+
+                    case And::kind: return nary( []( auto &out, auto &x ) { out &= x; } );
+                    case Or::kind:  return nary( []( auto &out, auto &x ) { out |= x; } );
+
+                    case Not::kind:
+                        return unary( []( auto &x ) { return ~x; } );
+                    case PopulationCount::kind:
+                        return unary( [ & ]( auto &x )
+                        {
+                            return apint( op->size, x.countPopulation() );
+                        } );
+                    case CountLeadingZeroes::kind:
+                        return unary( [ & ]( auto &x )
+                        {
+                            return apint( op->size, x.countLeadingZeros() );
+                        } );
+                    case CountTrailingZeroes::kind:
+                        return unary( [ & ]( auto &x )
+                        {
+                            return apint( op->size, x.countTrailingZeros() );
+                        } );
+                    case Parity::kind:
+                        return unary( [ & ]( auto &x )
+                        {
+                            return apint( op->size, x.countPopulation() % 2 );
+                        } );
+
+                    case Extract::kind:
+                    {
+                        auto e = static_cast< Extract * >( op );
+                        if ( e->high_bit_exc > v[ 0 ].getBitWidth() )
+                            return {};
+                        return v[ 0 ].extractBits( e->extracted_size(), e->low_bit_inc );
+                    }
+                    case Concat::kind:
+                    {
+                        apint out( op->size, 0 );
+                        uint32_t current = 0;
+                        for ( const auto &x : v )
+                        {
+                            if ( current + x.getBitWidth() > op->size )
+                                return {};
+                            out.insertBits( x, current );
+                            current += x.getBitWidth();
+                        }
+                        return out;
+                    }
+                    default:
+                        return {};
+                }
+            }
+
+            Operation *simplify( Operation *op )
+            {
+                switch ( op->op_code )
+                {
+                    case And::kind:
+                    case Or::kind:
+                        return simplify_and_or( op );
+                    case Extract::kind:
+                        return simplify_extract( static_cast< Extract * >( op ) );
+                    case Concat::kind:
+                        return simplify_concat( op );
+                    case Select::kind:
+                        return simplify_select( static_cast< Select * >( op ) );
+                    case Not::kind:
+                        if ( auto inner = dyn_cast< Not >( op->operand( 0 ) ) )
+                            return inner->operand( 0 );
+                        return nullptr;
+                    case Trunc::kind:
+                    case ZExt::kind:
+                    case SExt::kind:
+                        return simplify_cast( op );
+                    default:
+                        break;
+                }
+
+                if ( is_one_of( op, llvm_ops_t{} ) && op->operands_size() == 2 )
+                    return simplify_binary( op );
+                return nullptr;
+            }
+
+            Operation *simplify_binary( Operation *op )
+            {
+                auto lhs = op->operand( 0 );
+                auto rhs = op->operand( 1 );
+
+                // Comparisons of a value with itself.
+                if ( lhs == rhs )
+                {
+                    switch ( op->op_code )
+                    {
+                        case Icmp_eq::kind:
+                        case Icmp_uge::kind:
+                        case Icmp_ule::kind:
+                        case Icmp_sge::kind:
+                        case Icmp_sle::kind:
+                            return constant( op->size, 1 );
+                        case Icmp_ne::kind:
+                        case Icmp_ult::kind:
+                        case Icmp_ugt::kind:
+                        case Icmp_slt::kind:
+                        case Icmp_sgt::kind:
+                            return constant( op->size, 0 );
+                        default:
+                            break;
+                    }
+                }
+
+                // `x == 1` and `x != 0` of a bool are `x`.
+                if ( op->size == 1 && lhs->size == 1 && rhs->size == 1 )
+                {
+                    if ( isa< Icmp_eq >( op ) && is_one( rhs ) )
+                        return lhs;
+                    if ( isa< Icmp_eq >( op ) && is_one( lhs ) )
+                        return rhs;
+                    if ( isa< Icmp_ne >( op ) && is_zero( rhs ) )
+                        return lhs;
+                    if ( isa< Icmp_ne >( op ) && is_zero( lhs ) )
+                        return rhs;
+                }
+
+                if ( !is_uniform( op ) )
+                    return nullptr;
+
+                switch ( op->op_code )
+                {
+                    case Add::kind:
+                        if ( is_zero( rhs ) ) return lhs;
+                        if ( is_zero( lhs ) ) return rhs;
+                        return nullptr;
+                    case Sub::kind:
+                        if ( is_zero( rhs ) ) return lhs;
+                        if ( lhs == rhs ) return constant( op->size, 0 );
+                        return nullptr;
+                    case Xor::kind:
+                        if ( is_zero( rhs ) ) return lhs;
+                        if ( is_zero( lhs ) ) return rhs;
+                        if ( lhs == rhs ) return constant( op->size, 0 );
+                        return nullptr;
+                    case Mul::kind:
+                        if ( is_one( rhs ) || is_zero( lhs ) ) return lhs;
+                        if ( is_one( lhs ) || is_zero( rhs ) ) return rhs;
+                        return nullptr;
+                    case UDiv::kind:
+                    case SDiv::kind:
+                        if ( is_one( rhs ) ) return lhs;
+                        return nullptr;
+                    case Shl::kind:
+                    case LShr::kind:
+                    case AShr::kind:
+                        if ( is_zero( rhs ) ) return lhs;
+                        return nullptr;
+                    default:
+                        return nullptr;
+                }
+            }
+
+            Operation *simplify_cast( Operation *op )
+            {
+                auto from = op->operand( 0 );
+                if ( from->size == op->size )
+                    return from;
+
+                // trunc( ext( x ) ) back to the original size.
+                if ( isa< Trunc >( op ) && is_one_of< ZExt, SExt >( from ) &&
+                     from->operand( 0 )->size == op->size )
+                {
+                    return from->operand( 0 );
+                }
+                return nullptr;
+            }
+
+            Operation *simplify_and_or( Operation *op )
+            {
+                if ( !is_uniform( op ) )
+                    return nullptr;
+
+                bool is_and = isa< And >( op );
+                auto absorbs = [ & ]( auto x ) { return is_and ? is_zero( x ) : is_all_ones( x ); };
+                auto neutral = [ & ]( auto x ) { return is_and ? is_all_ones( x ) : is_zero( x ); };
+
+                std::vector< Operation * > kept;
+                std::unordered_set< Operation * > seen;
+                for ( auto x : op->operands() )
+                {
+                    if ( absorbs( x ) )
+                        return x;
+                    if ( neutral( x ) || !seen.insert( x ).second )
+                        continue;
+                    kept.push_back( x );
+                }
+
+                if ( kept.size() == op->operands_size() )
+                    return nullptr;
+
+                if ( kept.empty() )
+                    return constant( is_and ? apint::getAllOnes( op->size )
+                                            : apint( op->size, 0 ) );
+                if ( kept.size() == 1 )
+                    return kept[ 0 ];
+                if ( is_and )
+                    return make< And >( kept, op->size );
+                return make< Or >( kept, op->size );
+            }
+
+            Operation *simplify_select( Select *op )
+            {
+                if ( auto selector = value_of( op->selector() ) )
+                {
+                    auto idx = selector->getLimitedValue() + 1;
+                    if ( idx < op->operands_size() )
+                        return op->operand( idx );
+                }
+
+                for ( std::size_t i = 2; i < op->operands_size(); ++i )
+                    if ( op->operand( i ) != op->operand( 1 ) )
+                        return nullptr;
+                return ( op->operands_size() > 1 ) ? op->operand( 1 ) : nullptr;
+            }
+
+            Operation *simplify_extract( Extract *op )
+            {
+                auto from = op->operand( 0 );
+                auto low = op->low_bit_inc;
+                auto high = op->high_bit_exc;
+
+                if ( low == 0 && high == from->size )
+                    return from;
+
+                if ( auto inner = dyn_cast< Extract >( from ) )
+                {
+                    return extract( inner->operand( 0 ), inner->low_bit_inc + low,
+                                    inner->low_bit_inc + high );
+                }
+
+                if ( isa< ZExt >( from ) )
+                {
+                    auto original = from->operand( 0 );
+                    if ( high <= original->size )
+                        return extract( original, low, high );
+                    if ( low >= original->size )
+                        return constant( op->size, 0 );
+                    return nullptr;
+                }
+
+                if ( isa< Concat >( from ) )
+                    return extract_from_concat( from, low, high );
+                return nullptr;
+            }
+
+            // Operands of concat are ordered from the least significant ones.
+            Operation *extract_from_concat( Operation *concat, uint32_t low, uint32_t high )
+            {
+                struct piece_t { Operation *from; uint32_t low; uint32_t high; };
+
+                std::vector< piece_t > pieces;
+                uint32_t offset = 0;
+                for ( auto x : concat->operands() )
+                {
+                    auto begin = std::max( low, offset );
+                    auto end = std::min( high, offset + x->size );
+                    if ( begin < end )
+                        pieces.push_back( { x, begin - offset, end - offset } );
+                    offset += x->size;
+                }
+
+                if ( offset != concat->size || pieces.empty() )
+                    return nullptr;
+
+                if ( pieces.size() == 1 )
+                {
+                    auto &[ from, begin, end ] = pieces.front();
+                    return extract( from, begin, end );
+                }
+
+                // Slicing the operands would create more nodes than the extract saves.
+                for ( auto &[ from, begin, end ] : pieces )
+                    if ( begin != 0 || end != from->size )
+                        return nullptr;
+
+                std::vector< Operation * > operands;
+                for ( auto &piece : pieces )
+                    operands.push_back( piece.from );
+                return make< Concat >( operands, high - low );
+            }
+
+            Operation *simplify_concat( Operation *op )
+            {
+                uint32_t total = 0;
+                for ( auto x : op->operands() )
+                    total += x->size;
+                if ( total != op->size )
+                    return nullptr;
+
+                if ( op->operands_size() == 1 )
+                    return op->operand( 0 );
+
+                bool changed = false;
+                std::vector< Operation * > flat;
+                for ( auto x : op->operands() )
+                {
+                    if ( !isa< Concat >( x ) )
+                    {
+                        flat.push_back( x );
+                        continue;
+                    }
+                    flat.insert( flat.end(), x->begin(), x->end() );
+                    changed = true;
+                }
+
+                // Merge neighbouring constants and neighbouring slices of the same value.
+                std::vector< Operation * > merged;
+                for ( auto x : flat )
+                {
+                    if ( merged.empty() )
+                    {
+                        merged.push_back( x );
+                        continue;
+                    }
+
+                    auto &last = merged.back();
+                    auto lo = value_of( last );
+                    auto hi = value_of( x );
+                    if ( lo && hi )
+                    {
+                        last = constant( hi->concat( *lo ) );
+                        changed = true;
+                        continue;
+                    }
+
+                    auto lo_slice = dyn_cast< Extract >( last );
+                    auto hi_slice = dyn_cast< Extract >( x );
+                    if ( lo_slice && hi_slice &&
+                         lo_slice->operand( 0 ) == hi_slice->operand( 0 ) &&
+                         lo_slice->high_bit_exc == hi_slice->low_bit_inc )
+                    {
+                        last = extract( lo_slice->operand( 0 ), lo_slice->low_bit_inc,
+                                        hi_slice->high_bit_exc );
+                        changed = true;
+                        continue;
+                    }
+
+                    merged.push_back( x );
+                }
+
+                if ( !changed )
+                    return nullptr;
+                if ( merged.size() == 1 )
+                    return merged.front();
+                return make< Concat >( merged, op->size );
+            }
+        };
+
+        // Advices whose only users are their constraints can take any value.
+        std::size_t remove_unconstrained_advices( Circuit *circuit )
+        {
+            std::vector< Operation * > dead;
+            for ( auto advice : circuit->attr< Advice >() )
+            {
+                auto users = freeze< std::vector >( advice->users() );
+                auto only_constrained = [ & ]()
+                {
+                    for ( auto user : users )
+                    {
+                        auto ac = dyn_cast< AdviceConstraint >( user );
+                        if ( !ac || ac->advice() != advice )
+                            return false;
+                    }
+                    return !users.empty();
+                }();
+
+                if ( !only_constrained )
+                    continue;
+
+                dead.insert( dead.end(), users.begin(), users.end() );
+                dead.push_back( advice );
+            }
+
+            for ( auto op : dead )
+                op->destroy();
+            return dead.size();
+        }
+
+    } // namespace
+
+    circuit_owner_t NativeSimplify::run( circuit_owner_t &&circuit )
+    {
+        simplifier s( circuit.get() );
+
+        std::size_t sweeps = 0;
+        while ( sweeps < max_sweeps && s.sweep() )
+            ++sweeps;
+
+        std::size_t removed = 0;
+        while ( true )
+        {
+            auto dead = circuit->remove_unused();
+            removed += dead;
+            if ( dead == 0 && remove_unconstrained_advices( circuit.get() ) == 0 )
+                break;
+        }
+
+        log_info() << "[native-simplify]:" << "Sweeps:" << sweeps
+                   << "folded:" << s.stats.folded
+                   << "simplified:" << s.stats.simplified
+                   << "merged:" << s.stats.merged
+                   << "removed:" << removed;
+        return std::move( circuit );
+    }
+
+} // namespace circ
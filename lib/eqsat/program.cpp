@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#include <eqsat/pattern/program.hpp>
+#include <gap/core/overloads.hpp>
+
+#include <algorithm>
+#include <optional>
+
+namespace eqsat
+{
+    namespace
+    {
+        using reg_t = std::uint32_t;
+
+        constexpr reg_t unbound = std::numeric_limits< reg_t >::max();
+
+        struct pattern_compiler {
+
+            explicit pattern_compiler(const match_pattern &pattern) : pattern(pattern) {
+                program.places = gather_places(pattern);
+                program.place_registers.resize(program.places.size(), unbound);
+            }
+
+            match_program compile() && {
+                std::visit([&] (const auto &action) { compile(action); }, pattern.action);
+                return std::move(program);
+            }
+
+          private:
+            void emit(opcode op, reg_t dst = 0, reg_t src = 0, std::uint32_t arg = 0) {
+                program.code.push_back({ op, dst, src, arg });
+            }
+
+            reg_t eclass_register() { return program.eclass_registers++; }
+            reg_t enode_register() { return program.enode_registers++; }
+
+            //
+            // whole pattern
+            //
+            void compile(const simple_expr &expr) {
+                program.roots.emplace_back(anonymous_label(), compile_root(expr));
+                if (all_places_bound()) {
+                    emit(opcode::yield);
+                } else {
+                    program.code.clear();
+                }
+            }
+
+            void compile(const match_expr &expr) {
+                std::visit([&] (const auto &e) { compile(e); }, expr);
+            }
+
+            // labels are matched from the last one, every label has to bind all places
+            void compile(const basic_match_expr &expr) {
+                program.multi_match = true;
+                for (auto it = expr.labels.rbegin(); it != expr.labels.rend(); ++it) {
+                    const auto &named = get_expr_with_name(*it, pattern);
+                    program.roots.emplace_back(*it, compile_root(named.expr.expr));
+                    if (!all_places_bound()) {
+                        program.code.clear();
+                        return;
+                    }
+                }
+                emit(opcode::yield);
+            }
+
+            void compile(const commutative_match_expr &) {
+                program.multi_match = true;
+                emit(opcode::unsupported);
+            }
+
+            //
+            // root of a match, i.e., expression matched against all eclasses
+            //
+            reg_t compile_root(const simple_expr &expr) {
+                auto eclass = eclass_register();
+                auto enode  = enode_register();
+
+                auto op = root_operation(expr);
+                emit(opcode::scan_eclasses, eclass, 0,
+                    op ? op->id : instruction::any_operation
+                );
+                emit(opcode::scan_nodes, enode, eclass);
+                compile(expr, enode, eclass);
+                return eclass;
+            }
+
+            //
+            // matches expression against enode `enode` of eclass `eclass`
+            //
+            void compile(const simple_expr &expr, reg_t enode, reg_t eclass) {
+                const simple_expr_base &base = expr;
+                std::visit([&] (const auto &e) { compile(e, enode, eclass); }, base);
+            }
+
+            void compile(const atom_t &atom, reg_t enode, reg_t eclass) {
+                const atom_base &base = atom;
+                std::visit( gap::overloaded {
+                    [&] (const constant_t &c) {
+                        emit(opcode::check_constant, 0, enode, std::uint32_t(program.constants.size()));
+                        program.constants.push_back(c);
+                    },
+                    [&] (const operation_t &o) {
+                        emit(opcode::check_operation, 0, enode, o.symbol.id);
+                    },
+                    [&] (const place_t &p) {
+                        auto &reg = program.place_registers[place_index(p, program.places)];
+                        if (reg == unbound) {
+                            reg = eclass;
+                        } else {
+                            emit(opcode::compare, reg, eclass);
+                        }
+                    },
+                    [&] (const label_t &lab) {
+                        compile(get_expr_with_name(lab, pattern).expr.expr, enode, eclass);
+                    }
+                }, base);
+            }
+
+            // children are matched depth-first from the left, each against all enodes
+            // of its eclass
+            void compile(const expr_list &list, reg_t enode, reg_t eclass) {
+                compile(list.front(), enode, eclass);
+
+                auto arity = reg_t(list.size() - 1);
+                if (arity == 0) {
+                    return;
+                }
+
+                auto first = program.eclass_registers;
+                program.eclass_registers += arity;
+                emit(opcode::load_children, first, enode, arity);
+
+                for (reg_t i = 0; i < arity; ++i) {
+                    auto child = enode_register();
+                    emit(opcode::scan_nodes, child, first + i);
+                    compile(list[i + 1], child, first + i);
+                }
+            }
+
+            bool all_places_bound() const {
+                return std::find(
+                    program.place_registers.begin(), program.place_registers.end(), unbound
+                ) == program.place_registers.end();
+            }
+
+            //
+            // operation the root enode of a match has to have, if the expr determines it
+            //
+            std::optional< symbol_t > root_operation(const simple_expr &expr) const {
+                const simple_expr_base &base = expr;
+                return std::visit( gap::overloaded {
+                    [&] (const atom_t &a) { return root_operation(a); },
+                    [&] (const expr_list &list) { return root_operation(list.front()); }
+                }, base);
+            }
+
+            std::optional< symbol_t > root_operation(const atom_t &atom) const {
+                const atom_base &base = atom;
+                return std::visit( gap::overloaded {
+                    [&] (const operation_t &o) -> std::optional< symbol_t > { return o.symbol; },
+                    [&] (const label_t &lab) -> std::optional< symbol_t > {
+                        return root_operation(get_expr_with_name(lab, pattern).expr.expr);
+                    },
+                    [&] (const auto &) -> std::optional< symbol_t > { return std::nullopt; }
+                }, base);
+            }
+
+            const match_pattern &pattern;
+            match_program program;
+        };
+
+    } // anonymous namespace
+
+    match_program compile_pattern(const match_pattern &pattern) {
+        return pattern_compiler(pattern).compile();
+    }
+
+    std::string_view opcode_name(opcode op) {
+        switch (op) {
+            case opcode::scan_eclasses:   return "scan-eclasses";
+            case opcode::scan_nodes:      return "scan-nodes";
+            case opcode::check_operation: return "check-operation";
+            case opcode::check_constant:  return "check-constant";
+            case opcode::load_children:   return "load-children";
+            case opcode::compare:         return "compare";
+            case opcode::yield:           return "yield";
+            case opcode::unsupported:     return "unsupported";
+        }
+        __builtin_unreachable();
+    }
+
+} // namespace eqsat
@@ -4,6 +4,11 @@
 
 #include <eqsat/algo/saturation.hpp>
 
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <ostream>
+
 namespace eqsat {
 
     std::string to_string(stop_reason reason) {
@@ -11,10 +16,112 @@ namespace eqsat {
             case stop_reason::saturated: return "saturated";
             case stop_reason::iteration_limit: return "iteration limit";
             case stop_reason::node_limit: return "node limit";
+            case stop_reason::memory_limit: return "memory limit";
             case stop_reason::time_limit: return "time limit";
             case stop_reason::unknown: return "unkown";
             case stop_reason::none: return "none";
         }
     }
 
+    std::string to_string(const iteration_stats &stats) {
+        return fmt::format(
+            "iteration {}: {} nodes, {} classes, {} applied, {} banned, "
+            "search {:.2f} ms, apply {:.2f} ms, rebuild {:.2f} ms",
+            stats.iteration, stats.nodes, stats.classes, stats.applied, stats.banned,
+            stats.search_ms, stats.apply_ms, stats.rebuild_ms
+        );
+    }
+
+    namespace {
+
+        std::string json_string(std::string_view str) {
+            std::string out = "\"";
+            for (auto ch : str) {
+                switch (ch) {
+                    case '"':  out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\t': out += "\\t"; break;
+                    default:
+                        // remaining control characters are escaped by their code
+                        if (static_cast< unsigned char >(ch) < 0x20) {
+                            out += fmt::format("\\u{:04x}", static_cast< unsigned >(ch));
+                        } else {
+                            out += ch;
+                        }
+                }
+            }
+            return out + "\"";
+        }
+
+        std::string csv_string(std::string_view str) {
+            std::string out = "\"";
+            for (auto ch : str) {
+                out += ch == '"' ? "\"\"" : std::string(1, ch);
+            }
+            return out + "\"";
+        }
+
+    } // anonymous namespace
+
+    std::string_view csv_header() {
+        return "workload,iteration,nodes,classes,applied,banned,"
+               "search_ms,apply_ms,rebuild_ms,extract_ms,"
+               "rule,rule_matches,rule_banned,rule_search_ms,rule_apply_ms,"
+               "rule_new_nodes,rule_merges\n";
+    }
+
+    void write_csv(std::ostream &os, std::string_view workload, const saturation_stats &stats) {
+        for (const auto &it : stats.iterations) {
+            auto prefix = fmt::format("{},{},{},{},{},{},{:.3f},{:.3f},{:.3f},{:.3f}",
+                csv_string(workload), it.iteration, it.nodes, it.classes, it.applied, it.banned,
+                it.search_ms, it.apply_ms, it.rebuild_ms, it.extract_ms
+            );
+
+            if (it.rules.empty()) {
+                fmt::print(os, "{},,,,,,,\n", prefix);
+            }
+
+            for (const auto &rule : it.rules) {
+                fmt::print(os, "{},{},{},{},{:.3f},{:.3f},{},{}\n",
+                    prefix, csv_string(rule.rule), rule.matches, int(rule.banned),
+                    rule.search_ms, rule.apply_ms, rule.new_nodes, rule.merges
+                );
+            }
+        }
+    }
+
+    void write_json(std::ostream &os, std::string_view workload, const saturation_stats &stats) {
+        fmt::print(os,
+            "{{\"workload\": {}, \"reason\": {}, \"total_ms\": {:.3f}, \"iterations\": [",
+            json_string(workload), json_string(to_string(stats.reason)), stats.total_ms
+        );
+
+        for (std::size_t i = 0; i < stats.iterations.size(); ++i) {
+            const auto &it = stats.iterations[i];
+            fmt::print(os,
+                "{}\n  {{\"iteration\": {}, \"nodes\": {}, \"classes\": {}, \"applied\": {}, "
+                "\"banned\": {}, \"search_ms\": {:.3f}, \"apply_ms\": {:.3f}, "
+                "\"rebuild_ms\": {:.3f}, \"extract_ms\": {:.3f}, \"rules\": [",
+                i ? "," : "", it.iteration, it.nodes, it.classes, it.applied, it.banned,
+                it.search_ms, it.apply_ms, it.rebuild_ms, it.extract_ms
+            );
+
+            for (std::size_t r = 0; r < it.rules.size(); ++r) {
+                const auto &rule = it.rules[r];
+                fmt::print(os,
+                    "{}\n    {{\"rule\": {}, \"matches\": {}, \"banned\": {}, "
+                    "\"search_ms\": {:.3f}, \"apply_ms\": {:.3f}, \"new_nodes\": {}, "
+                    "\"merges\": {}}}",
+                    r ? "," : "", json_string(rule.rule), rule.matches, rule.banned,
+                    rule.search_ms, rule.apply_ms, rule.new_nodes, rule.merges
+                );
+            }
+            fmt::print(os, "]}}");
+        }
+
+        fmt::print(os, "\n]}}\n");
+    }
+
 } // namespace eqsat
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023 Trail of Bits, Inc.
+ */
+
+#include <eqsat/core/symbol.hpp>
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace eqsat {
+
+    namespace {
+
+        struct symbol_table {
+            symbol_table() { insert(""); }
+
+            symbol_t intern(std::string_view name) {
+                {
+                    std::shared_lock lock(mutex);
+                    if (auto it = ids.find(name); it != ids.end()) {
+                        return it->second;
+                    }
+                }
+
+                std::unique_lock lock(mutex);
+                if (auto it = ids.find(name); it != ids.end()) {
+                    return it->second;
+                }
+                return insert(name);
+            }
+
+            const std::string &name(symbol_t symbol) const {
+                std::shared_lock lock(mutex);
+                return names.at(symbol.id);
+            }
+
+            std::size_t size() const {
+                std::shared_lock lock(mutex);
+                return names.size();
+            }
+
+          private:
+            symbol_t insert(std::string_view name) {
+                symbol_t symbol{ std::uint32_t(names.size()) };
+                // deque does not move its elements, keys can view the stored names
+                const auto &stored = names.emplace_back(name);
+                ids.emplace(stored, symbol);
+                return symbol;
+            }
+
+            mutable std::shared_mutex mutex;
+            std::deque< std::string > names;
+            std::unordered_map< std::string_view, symbol_t > ids;
+        };
+
+        symbol_table &table() {
+            static symbol_table instance;
+            return instance;
+        }
+
+    } // anonymous namespace
+
+    const std::string &symbol_t::name() const { return table().name(*this); }
+
+    symbol_t intern(std::string_view name) { return table().intern(name); }
+
+    std::size_t num_of_symbols() { return table().size(); }
+
+} // namespace eqsat
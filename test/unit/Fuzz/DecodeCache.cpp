@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2023, Trail of Bits, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed in accordance with the terms specified in
+ * the LICENSE file found in the root directory of this source tree.
+ */
+
+#include <doctest/doctest.h>
+
+#include <circuitous/Fuzz/DecodeCache.hpp>
+#include <circuitous/Lifter/Context.hpp>
+
+#include <string>
+#include <vector>
+
+namespace circ::test
+{
+    TEST_SUITE( "decode-cache" )
+    {
+        TEST_CASE( "repeats within a batch are hits" )
+        {
+            auto ctx = circ::Ctx{ "macos", "x86" };
+            ifuzz::decode_cache cache;
+
+            // add eax, ebx; sub eax, ebx
+            std::vector< std::string > batch = { "\x01\xd8", "\x29\xd8", "\x01\xd8",
+                                                 "\x01\xd8" };
+            auto decoded = cache.decode( *ctx.arch(), batch );
+            REQUIRE( decoded.size() == batch.size() );
+            for ( const auto &inst : decoded )
+                CHECK( inst.has_value() );
+
+            CHECK( cache.stats().misses == 2 );
+            CHECK( cache.stats().hits == 2 );
+            CHECK( cache.size() == 2 );
+        }
+
+        TEST_CASE( "full cache evicts single entries" )
+        {
+            auto ctx = circ::Ctx{ "macos", "x86" };
+            // One entry per shard.
+            ifuzz::decode_cache cache( 64 );
+
+            std::string last;
+            for ( unsigned i = 0; i < 256; ++i )
+            {
+                last = std::string( "\x01" ) + char( i );
+                cache.decode( *ctx.arch(), last );
+            }
+
+            CHECK( cache.size() <= 64 );
+            CHECK( cache.size() > 1 );
+
+            auto before = cache.stats().hits;
+            cache.decode( *ctx.arch(), last );
+            CHECK( cache.stats().hits == before + 1 );
+        }
+    } // test suite: decode-cache
+
+} // namespace circ::test
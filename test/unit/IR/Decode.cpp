@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2023, Trail of Bits, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed in accordance with the terms specified in
+ * the LICENSE file found in the root directory of this source tree.
+ */
+
+#include <doctest/doctest.h>
+
+#include <circuitous/IR/Decode.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace circ::test
+{
+    struct decode_fixture
+    {
+        circuit_owner_t circuit = std::make_unique< Circuit >();
+        Operation *root = circuit->create< OnlyOneCondition >();
+        Operation *bits = circuit->create< InputInstructionBits >( 16u );
+
+        decode_fixture() { circuit->root = root; }
+
+        Operation *constant( uint32_t size, uint64_t value )
+        {
+            std::string lsb_first;
+            for ( uint32_t i = 0; i < size; ++i )
+                lsb_first += ( ( value >> i ) & 1 ) ? '1' : '0';
+            return circuit->create< Constant >( std::move( lsb_first ), size );
+        }
+
+        Operation *byte( uint32_t idx )
+        {
+            auto out = circuit->create< Extract >( idx * 8, idx * 8 + 8 );
+            out->add_operand( bits );
+            return out;
+        }
+
+        // Context whose decoder requires each of `expected` to hold.
+        Operation *context( std::vector< std::pair< Operation *, Operation * > > expected )
+        {
+            auto decoder = circuit->create< DecoderResult >();
+            for ( auto [ actual, value ] : expected )
+            {
+                auto cond = circuit->create< DecodeCondition >();
+                cond->add_operands( actual, value );
+                decoder->add_operand( cond );
+            }
+
+            auto ctx = circuit->create< VerifyInstruction >();
+            ctx->add_operand( decoder );
+            root->add_operand( ctx );
+            return ctx;
+        }
+    };
+
+    TEST_SUITE( "decode" )
+    {
+        TEST_CASE_FIXTURE( decode_fixture, "accepting-contexts" )
+        {
+            auto first = context( { { byte( 0 ), constant( 8, 0x48 ) },
+                                    { byte( 1 ), constant( 8, 0x01 ) } } );
+            auto second = context( { { byte( 0 ), constant( 8, 0x49 ) } } );
+
+            // First byte of the encoding is the least significant one.
+            CHECK_EQ( accepting_contexts( circuit.get(), "\x48\x01" ),
+                      ( std::vector< Operation * >{ first } ) );
+            CHECK_EQ( accepting_contexts( circuit.get(), "\x49\x07" ),
+                      ( std::vector< Operation * >{ second } ) );
+            CHECK( accepting_contexts( circuit.get(), "\x01\x48" ).empty() );
+            // Does not fit into the instruction bits.
+            CHECK( accepting_contexts( circuit.get(), "\x49\x01\x02" ).empty() );
+        }
+
+        TEST_CASE_FIXTURE( decode_fixture, "decoder-operations" )
+        {
+            // Lowest bit of the first byte selects which byte must be 0xff.
+            auto selector = circuit->create< Extract >( 0u, 1u );
+            selector->add_operand( bits );
+            auto selected = circuit->create< Select >( 1u, 8u );
+            selected->add_operands( selector, byte( 0 ), byte( 1 ) );
+
+            auto high = circuit->create< Concat >( 16u );
+            high->add_operands( byte( 1 ), byte( 0 ) );
+            auto inverted = circuit->create< Not >( 16u );
+            inverted->add_operand( high );
+
+            auto ctx = context( { { selected, constant( 8, 0xff ) },
+                                  { inverted, constant( 16, 0xfe00 ) } } );
+
+            // selector = 1, byte 1 = 0xff, ~( 0x01ff ) = 0xfe00
+            CHECK_EQ( accepting_contexts( circuit.get(), "\x01\xff" ),
+                      ( std::vector< Operation * >{ ctx } ) );
+            CHECK( accepting_contexts( circuit.get(), "\x02\xff" ).empty() );
+        }
+
+        TEST_CASE_FIXTURE( decode_fixture, "unsupported-decoder" )
+        {
+            // Not supported by the evaluator, e.g., decoder rewritten by an optimization.
+            auto less = circuit->create< Icmp_ult >( 1u );
+            less->add_operands( byte( 0 ), constant( 8, 0x10 ) );
+            context( { { less, constant( 1, 1 ) } } );
+            auto plain = context( { { byte( 0 ), constant( 8, 0x01 ) } } );
+
+            // The unknown decoder does not accept, others are still evaluated.
+            CHECK_EQ( accepting_contexts( circuit.get(), "\x01" ),
+                      ( std::vector< Operation * >{ plain } ) );
+            CHECK( accepting_contexts( circuit.get(), "\x02" ).empty() );
+        }
+    }
+
+} // namespace circ::test
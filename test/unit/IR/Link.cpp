@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023, Trail of Bits, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed in accordance with the terms specified in
+ * the LICENSE file found in the root directory of this source tree.
+ */
+
+#include <doctest/doctest.h>
+
+#include <circuitous/IR/Link.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace circ::test
+{
+    // Shard with one context per `values` entry, each constrains `out` to
+    // `( in + value ) ^ advice`.
+    circuit_owner_t make_shard( const std::vector< std::string > &values )
+    {
+        auto circuit = std::make_unique< Circuit >();
+        auto root = circuit->create< OnlyOneCondition >();
+        circuit->root = root;
+
+        for ( std::size_t i = 0; i < values.size(); ++i )
+        {
+            auto in = circuit->create< InputRegister >( "in", 8u );
+            auto out = circuit->create< OutputRegister >( "out", 8u );
+            auto advice = circuit->create< Advice >( 8u, i );
+
+            auto sum = circuit->create< Add >( 8u );
+            sum->add_operands( in, circuit->create< Constant >( values[ i ], 8u ) );
+            auto value = circuit->create< Xor >( 8u );
+            value->add_operands( sum, advice );
+
+            auto rc = circuit->create< RegConstraint >();
+            rc->add_operands( value, out );
+            auto ctx = circuit->create< VerifyInstruction >();
+            ctx->add_operand( rc );
+            root->add_operand( ctx );
+        }
+        return circuit;
+    }
+
+    TEST_SUITE( "link" )
+    {
+        TEST_CASE( "shared-leaves" )
+        {
+            std::vector< circuit_owner_t > shards;
+            shards.push_back( make_shard( { "10000000" } ) );
+            shards.push_back( make_shard( { "01000000", "11000000" } ) );
+
+            auto circuit = link( std::move( shards ) );
+
+            CHECK_EQ( circuit->root->operands_size(), 3 );
+            CHECK_EQ( circuit->attr< VerifyInstruction >().size(), 3 );
+            CHECK_EQ( circuit->attr< InputRegister >().size(), 1 );
+            CHECK_EQ( circuit->attr< OutputRegister >().size(), 1 );
+        }
+
+        TEST_CASE( "advices-stay-distinct" )
+        {
+            std::vector< circuit_owner_t > shards;
+            shards.push_back( make_shard( { "10000000", "01000000" } ) );
+            shards.push_back( make_shard( { "11000000" } ) );
+
+            auto circuit = link( std::move( shards ) );
+
+            std::vector< std::size_t > indices;
+            for ( auto advice : circuit->attr< Advice >() )
+                indices.push_back( advice->advice_idx );
+            std::sort( indices.begin(), indices.end() );
+            CHECK_EQ( indices, ( std::vector< std::size_t >{ 0, 1, 2 } ) );
+        }
+
+        TEST_CASE( "identical-shards" )
+        {
+            CircuitLinker linker( 64u );
+            auto shard = make_shard( { "10000000", "01000000" } );
+            linker.add( shard.get() );
+            auto nodes = linker.stats().created;
+            linker.add( shard.get() );
+
+            // Re-linking the same shard shifts its advices, everything that does not
+            // depend on them is reused.
+            CHECK_EQ( linker.stats().contexts, 4 );
+            CHECK_EQ( linker.stats().created - nodes, 2 * 4 );
+        }
+    }
+
+} // namespace circ::test
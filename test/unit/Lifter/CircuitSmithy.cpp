@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2023, Trail of Bits, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed in accordance with the terms specified in
+ * the LICENSE file found in the root directory of this source tree.
+ */
+
+#include <doctest/doctest.h>
+
+#include <circuitous/IR/Circuit.hpp>
+#include <circuitous/Lifter/CircuitSmithy.hpp>
+#include <circuitous/Lifter/Context.hpp>
+#include <circuitous/Lifter/SemanticsCache.hpp>
+#include <circuitous/Support/Log.hpp>
+
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace circ::test
+{
+    static inline auto count_kinds( Circuit *circuit )
+    {
+        std::map< Operation::kind_t, std::size_t > out;
+        circuit->for_each_operation( [ & ]( auto op ) { ++out[ op->op_code ]; } );
+        return out;
+    }
+
+    static inline auto lift( std::size_t workers, const std::string &bytes,
+                             std::shared_ptr< isem::semantics_cache > cache = {} )
+    {
+        auto smithy = CircuitSmithy( circ::Ctx{ "macos", "x86" } );
+        smithy.parallel( workers ).cache_semantics( std::move( cache ) );
+        return smithy.make( lifter_kind::disjunctions, smithy.purify( bytes ) );
+    }
+
+    TEST_SUITE( "smithy" )
+    {
+        TEST_CASE( "parallel lift matches serial lift" )
+        {
+            circ::add_sink< circ::severity::kill >( std::cerr );
+
+            // add eax, ebx; sub eax, ebx; add eax, ecx; xor ecx, edx; mov eax, ebx
+            const std::string bytes = "\x01\xd8\x29\xd8\x01\xc8\x31\xd1\x89\xd8";
+
+            auto serial = lift( 1, bytes );
+            auto parallel = lift( 4, bytes );
+            REQUIRE( serial != nullptr );
+            REQUIRE( parallel != nullptr );
+
+            CHECK( count_kinds( serial.get() ) == count_kinds( parallel.get() ) );
+        }
+
+        TEST_CASE( "cached semantics match uncached ones" )
+        {
+            circ::add_sink< circ::severity::kill >( std::cerr );
+
+            // add eax, ebx; xor ecx, edx
+            const std::string bytes = "\x01\xd8\x31\xd1";
+
+            auto dir = std::filesystem::temp_directory_path() /
+                       ( "circuitous-isem-test-" + std::to_string( std::random_device{}() ) );
+            auto cache = std::make_shared< isem::semantics_cache >( dir, "test" );
+
+            auto uncached = lift( 1, bytes );
+            auto stored = lift( 1, bytes, cache );
+            auto first = cache->stats();
+            REQUIRE( first.misses != 0 );
+            REQUIRE( first.hits == 0 );
+
+            auto loaded = lift( 1, bytes, cache );
+            CHECK( cache->stats().hits == first.misses - first.uncacheable );
+
+            CHECK( count_kinds( uncached.get() ) == count_kinds( stored.get() ) );
+            CHECK( count_kinds( uncached.get() ) == count_kinds( loaded.get() ) );
+
+            std::filesystem::remove_all( dir );
+        }
+    } // test suite: smithy
+
+} // namespace circ::test
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2023, Trail of Bits, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed in accordance with the terms specified in
+ * the LICENSE file found in the root directory of this source tree.
+ */
+
+#include <doctest/doctest.h>
+
+#include <circuitous/IR/Decode.hpp>
+#include <circuitous/Lifter/CircuitSmithy.hpp>
+#include <circuitous/Lifter/Context.hpp>
+#include <circuitous/Lifter/Extend.hpp>
+#include <circuitous/Support/Log.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace circ::test
+{
+    TEST_SUITE( "extend" )
+    {
+        TEST_CASE( "extended circuit accepts old and new encodings" )
+        {
+            circ::add_sink< circ::severity::kill >( std::cerr );
+
+            // add eax, ebx
+            const std::string old_bytes = "\x01\xd8";
+            // sub eax, ebx; add eax, ecx (same isel as the old one)
+            const std::string new_bytes = "\x29\xd8\x01\xc8";
+
+            auto smithy = CircuitSmithy( circ::Ctx{ "macos", "x86" } );
+
+            auto old_insts = smithy.purify( old_bytes );
+            REQUIRE( old_insts.size() == 1 );
+            CIF covered;
+            for ( const auto &inst : old_insts )
+                covered.emplace_back( InstBytes( inst.bytes ), inst.function );
+
+            auto base = smithy.make( lifter_kind::disjunctions, std::move( old_insts ) );
+            REQUIRE( !accepting_contexts( base.get(), "\x01\xd8" ).empty() );
+            CHECK( accepting_contexts( base.get(), "\x29\xd8" ).empty() );
+
+            auto new_insts = smithy.purify( new_bytes );
+            REQUIRE( new_insts.size() == 2 );
+
+            auto plan = plan_extension( smithy, base.get(), covered, std::move( new_insts ) );
+            CHECK( plan.known == 0 );
+            CHECK( plan.fresh >= 1 );
+            CHECK( plan.coverage.size() == 3 );
+            REQUIRE( plan.needs_lift() );
+
+            auto delta = smithy.make( lifter_kind::disjunctions, std::move( plan.to_lift ) );
+            auto extended = splice( std::move( base ), plan, std::move( delta ) );
+            REQUIRE( extended != nullptr );
+
+            CHECK( !accepting_contexts( extended.get(), "\x01\xd8" ).empty() );
+            CHECK( !accepting_contexts( extended.get(), "\x29\xd8" ).empty() );
+            CHECK( !accepting_contexts( extended.get(), "\x01\xc8" ).empty() );
+        }
+    } // test suite: extend
+
+} // namespace circ::test
@@ -6,6 +6,203 @@
  * the LICENSE file found in the root directory of this source tree.
  */
 
+#include <doctest/doctest.h>
+
+#include <circuitous/Transforms/EGraph.hpp>
+
+#include <eqsat/algo/saturation.hpp>
+#include <eqsat/pattern/parser.hpp>
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace circ::test
+{
+    using saturable_circuit_egraph = eqsat::saturable_egraph< circuit_egraph >;
+
+    static inline enode_handle make_register( circuit_egraph &egraph, const std::string &name )
+    {
+        auto reg = circuit_egraph_builder_base::regop( "in.register", 64, name );
+        return egraph.insert( node_template( reg ), {} );
+    }
+
+    static inline enode_handle make_op( circuit_egraph &egraph, const std::string &name,
+                                        std::vector< enode_handle > children )
+    {
+        return egraph.insert( node_template( circuit_egraph_builder_base::sized( name, 64 ) ), children );
+    }
+
+    static inline std::vector< eqsat::rule_set > arithmetic_rules()
+    {
+        std::stringstream rules;
+        rules << "[arithmetic]\n"
+              << "add-commutativity:\n"
+              << "    - (op_Add ?x ?y)\n"
+              << "    - (op_Add:64 ?y ?x)\n"
+              << "mul-commutativity:\n"
+              << "    - (op_Mul ?x ?y)\n"
+              << "    - (op_Mul:64 ?y ?x)\n"
+              << "add-associativity:\n"
+              << "    - (op_Add ?x (op_Add ?y ?z))\n"
+              << "    - (op_Add:64 (op_Add:64 ?x ?y) ?z)\n"
+              << "mul-distributivity:\n"
+              << "    - (op_Mul ?x (op_Add ?y ?z))\n"
+              << "    - (op_Add:64 (op_Mul:64 ?x ?y) (op_Mul:64 ?x ?z))\n";
+        return eqsat::parse_rules( rules );
+    }
+
+    // x0 * (x1 + (x2 + ... (xn-1 + xn)))
+    static inline enode_handle make_expression( circuit_egraph &egraph, std::size_t size )
+    {
+        auto sum = make_register( egraph, "x" + std::to_string( size ) );
+        for ( std::size_t i = size - 1; i > 0; --i )
+            sum = make_op( egraph, "Add", { make_register( egraph, "x" + std::to_string( i ) ),
+                                            sum } );
+        return make_op( egraph, "Mul", { make_register( egraph, "x0" ), sum } );
+    }
+
+    TEST_SUITE( "circuit-egraph" )
+    {
+        TEST_CASE( "hash-consing" )
+        {
+            circuit_egraph egraph;
+
+            auto x = make_register( egraph, "x" );
+            auto y = make_register( egraph, "y" );
+            auto add = make_op( egraph, "Add", { x, y } );
+
+            CHECK_EQ( make_register( egraph, "x" ), x );
+            CHECK_EQ( make_op( egraph, "Add", { x, y } ), add );
+            CHECK_NE( make_op( egraph, "Sub", { x, y } ), add );
+
+            std::vector< enode_handle > children = { x, y };
+            auto narrow = circuit_egraph_builder_base::sized( "Add", 32 );
+            CHECK_NE( egraph.insert( node_template( narrow ), children ), add );
+
+            // the same expression lifted twice shares all its nodes
+            auto expr = make_expression( egraph, 4 );
+            auto nodes = egraph.num_of_nodes();
+            CHECK_EQ( make_expression( egraph, 4 ), expr );
+            CHECK_EQ( egraph.num_of_nodes(), nodes );
+        }
+
+        TEST_CASE( "undefined values are distinct" )
+        {
+            circuit_egraph egraph;
+
+            auto undefined = [ & ]
+            {
+                auto op = circuit_egraph_builder_base::sized( Undefined::op_code_str(), 64 );
+                return egraph.insert( node_template( op ), {} );
+            };
+
+            auto a = undefined();
+            auto b = undefined();
+            CHECK_NE( a, b );
+
+            // (Add a b) is not an addition of a value to itself
+            make_op( egraph, "Add", { a, b } );
+
+            std::stringstream rules;
+            rules << "[undefined]\n"
+                  << "twice:\n"
+                  << "    - (op_Add ?x ?x)\n"
+                  << "    - (op_Mul:64 ?x ?x)\n"
+                  << "any:\n"
+                  << "    - (op_Add ?x ?y)\n"
+                  << "    - (op_Mul:64 ?x ?y)\n";
+            auto sets = eqsat::parse_rules( rules );
+            REQUIRE_EQ( sets.size(), 1 );
+            REQUIRE_EQ( sets.front().rules.size(), 2 );
+
+            auto graph = saturable_circuit_egraph( std::move( egraph ) );
+            CHECK( eqsat::match( sets.front().rules[ 0 ], graph ).empty() );
+            CHECK_EQ( eqsat::match( sets.front().rules[ 1 ], graph ).size(), 1 );
+        }
+
+        TEST_CASE( "commutativity does not grow the graph twice" )
+        {
+            circuit_egraph egraph;
+
+            auto x = make_register( egraph, "x" );
+            auto y = make_register( egraph, "y" );
+            auto add = make_op( egraph, "Add", { x, y } );
+
+            auto rules = arithmetic_rules();
+            auto graph = saturable_circuit_egraph( std::move( egraph ) );
+
+            graph = eqsat::make_step( std::move( graph ), rules ).first;
+            CHECK_EQ( graph.num_of_nodes(), 4 );
+            CHECK_EQ( graph.eclass( add ).size(), 2 );
+
+            // (Add y x) commuted back is the existing (Add x y)
+            graph = eqsat::make_step( std::move( graph ), rules ).first;
+            CHECK_EQ( graph.num_of_nodes(), 4 );
+            CHECK_EQ( graph.num_of_eclasses(), 3 );
+        }
+
+        // Run explicitly with `--no-skip`; reports size of the graph and time of each
+        // saturation step.
+        TEST_CASE( "benchmark: saturation steps" * doctest::skip() )
+        {
+            circuit_egraph egraph;
+            auto root = make_expression( egraph, 5 );
+
+            auto rules = arithmetic_rules();
+            auto graph = saturable_circuit_egraph( std::move( egraph ) );
+            MESSAGE( "initial: " << graph.num_of_nodes() << " nodes, "
+                                 << graph.num_of_eclasses() << " classes" );
+
+            for ( std::size_t i = 1; i <= 4; ++i )
+            {
+                auto start = std::chrono::steady_clock::now();
+                graph = eqsat::make_step( std::move( graph ), rules ).first;
+                auto ms = std::chrono::duration_cast< std::chrono::milliseconds >(
+                        std::chrono::steady_clock::now() - start ).count();
+
+                MESSAGE( "step " << i << ": " << graph.num_of_nodes() << " nodes, "
+                                 << graph.num_of_eclasses() << " classes, "
+                                 << graph.eclass( root ).size() << " root nodes, "
+                                 << ms << " ms" );
+            }
+        }
+
+        // Run explicitly with `--no-skip`; reports time of e-matching of each rule on
+        // a partially saturated graph.
+        TEST_CASE( "benchmark: e-matching" * doctest::skip() )
+        {
+            circuit_egraph egraph;
+            make_expression( egraph, 6 );
+
+            auto rules = arithmetic_rules();
+            auto graph = saturable_circuit_egraph( std::move( egraph ) );
+            for ( std::size_t i = 0; i < 3; ++i )
+                graph = eqsat::make_step( std::move( graph ), rules ).first;
+
+            MESSAGE( "graph: " << graph.num_of_nodes() << " nodes, "
+                               << graph.num_of_eclasses() << " classes" );
+
+            for ( const auto &set : rules )
+            {
+                for ( const auto &rule : set.rules )
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    std::size_t matches = 0;
+                    for ( std::size_t i = 0; i < 10; ++i )
+                        matches = eqsat::match( rule, graph ).size();
+                    auto us = std::chrono::duration_cast< std::chrono::microseconds >(
+                            std::chrono::steady_clock::now() - start ).count() / 10;
+
+                    MESSAGE( rule.name << ": " << matches << " matches, " << us << " us" );
+                }
+            }
+        }
+    }
+
+} // namespace circ::test
+
 // #include <doctest/doctest.h>
 
 // #include <circuitous/ADT/EGraph.hpp>
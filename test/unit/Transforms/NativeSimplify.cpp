@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2023, Trail of Bits, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed in accordance with the terms specified in
+ * the LICENSE file found in the root directory of this source tree.
+ */
+
+#include <doctest/doctest.h>
+
+#include <circuitous/Transforms/Passes.hpp>
+
+#include <memory>
+#include <string>
+
+namespace circ::test
+{
+    struct simplify_fixture
+    {
+        circuit_owner_t circuit = std::make_unique< Circuit >();
+        VerifyInstruction *ctx = nullptr;
+
+        simplify_fixture()
+        {
+            ctx = circuit->create< VerifyInstruction >();
+            circuit->root = ctx;
+        }
+
+        Operation *reg( const std::string &name, uint32_t size = 8 )
+        {
+            return circuit->create< InputRegister >( name, size );
+        }
+
+        Operation *constant( uint32_t size, uint64_t value )
+        {
+            std::string bits;
+            for ( uint32_t i = 0; i < size; ++i )
+                bits += ( ( value >> i ) & 1 ) ? '1' : '0';
+            return circuit->create< Constant >( std::move( bits ), size );
+        }
+
+        template< typename T, typename ... Ops >
+        Operation *make( uint32_t size, Ops ... ops )
+        {
+            auto op = circuit->create< T >( size );
+            op->add_operands( ops ... );
+            return op;
+        }
+
+        // Constrains `value` to an output register, returns the constraint.
+        Operation *constrain( Operation *value )
+        {
+            auto out = circuit->create< OutputRegister >(
+                    "out" + std::to_string( ctx->operands_size() ), value->size );
+            auto rc = circuit->create< RegConstraint >();
+            rc->add_operands( value, out );
+            ctx->add_operand( rc );
+            return rc;
+        }
+
+        void simplify()
+        {
+            circuit = NativeSimplify().run( std::move( circuit ) );
+        }
+
+        std::string constant_bits( Operation *op )
+        {
+            REQUIRE( isa< Constant >( op ) );
+            return static_cast< Constant * >( op )->bits;
+        }
+    };
+
+    TEST_SUITE( "native-simplify" )
+    {
+        TEST_CASE_FIXTURE( simplify_fixture, "constant-folding" )
+        {
+            auto sum = make< Add >( 8, constant( 8, 200 ), constant( 8, 100 ) );
+            auto rc = constrain( make< Xor >( 8, sum, constant( 8, 0xff ) ) );
+
+            simplify();
+
+            // ( 200 + 100 ) mod 256 = 44, 44 ^ 0xff = 211
+            CHECK_EQ( constant_bits( rc->operand( 0 ) ), "11001011" );
+            CHECK_EQ( circuit->attr< Add >().size(), 0 );
+            CHECK_EQ( circuit->attr< Xor >().size(), 0 );
+        }
+
+        TEST_CASE_FIXTURE( simplify_fixture, "algebraic-identities" )
+        {
+            auto x = reg( "x" );
+            auto rc_add = constrain( make< Add >( 8, x, constant( 8, 0 ) ) );
+            auto rc_and = constrain( make< And >( 8, x, x, constant( 8, 0xff ) ) );
+            auto rc_sub = constrain( make< Sub >( 8, x, x ) );
+
+            simplify();
+
+            CHECK_EQ( rc_add->operand( 0 ), x );
+            CHECK_EQ( rc_and->operand( 0 ), x );
+            CHECK_EQ( constant_bits( rc_sub->operand( 0 ) ), "00000000" );
+        }
+
+        TEST_CASE_FIXTURE( simplify_fixture, "common-subexpressions" )
+        {
+            auto x = reg( "x" );
+            auto y = reg( "y" );
+            auto rc_lhs = constrain( make< Mul >( 8, x, y ) );
+            auto rc_rhs = constrain( make< Mul >( 8, y, x ) );
+
+            simplify();
+
+            CHECK_EQ( rc_lhs->operand( 0 ), rc_rhs->operand( 0 ) );
+            CHECK_EQ( circuit->attr< Mul >().size(), 1 );
+        }
+
+        TEST_CASE_FIXTURE( simplify_fixture, "extract-concat-fusion" )
+        {
+            auto x = reg( "x" );
+            auto y = reg( "y" );
+            auto concat = make< Concat >( 16, x, y );
+
+            auto high = circuit->create< Extract >( 8u, 16u );
+            high->add_operand( concat );
+            auto rc_high = constrain( high );
+
+            auto low = circuit->create< Extract >( 0u, 4u );
+            auto high_nibble = circuit->create< Extract >( 4u, 8u );
+            low->add_operand( x );
+            high_nibble->add_operand( x );
+            auto rc_glued = constrain( make< Concat >( 8, low, high_nibble ) );
+
+            simplify();
+
+            CHECK_EQ( rc_high->operand( 0 ), y );
+            CHECK_EQ( rc_glued->operand( 0 ), x );
+            CHECK_EQ( circuit->attr< Extract >().size(), 0 );
+            CHECK_EQ( circuit->attr< Concat >().size(), 0 );
+        }
+
+        TEST_CASE_FIXTURE( simplify_fixture, "dead-nodes" )
+        {
+            auto x = reg( "x" );
+            auto unused = make< Mul >( 8, x, x );
+            constrain( make< Add >( 8, x, make< Mul >( 8, unused, constant( 8, 0 ) ) ) );
+
+            simplify();
+
+            CHECK_EQ( circuit->attr< Mul >().size(), 0 );
+            CHECK_EQ( circuit->attr< Add >().size(), 0 );
+        }
+    }
+
+} // namespace circ::test
@@ -8,10 +8,15 @@
 
 #include <doctest/doctest.h>
 #include <eqsat/algo/saturation.hpp>
+#include <eqsat/core/cost_graph.hpp>
 #include <eqsat/core/egraph.hpp>
 
 #include <support/egraph.hpp>
 
+#include <chrono>
+#include <string>
+#include <vector>
+
 namespace eqsat::test
 {
 
@@ -101,7 +106,8 @@ namespace eqsat::test
         CHECK( saturable.eclass( idx ) == saturable.eclass( idz ) );
 
         CHECK( saturable.eclass( idp ).parents.size() == 1 );
-        CHECK( saturable.eclass( idx ).parents.size() == 1 );
+        // `+` and `*` are distinct enodes of the same class
+        CHECK( saturable.eclass( idx ).parents.size() == 2 );
 
         CHECK( saturable.eclass( ids ).size() == 1 );
         CHECK( saturable.eclass( idp ).size() == 2 );
@@ -147,6 +153,174 @@ namespace eqsat::test
         CHECK(saturable.eclass(idm).size() == 1);
       }
 
+    TEST_CASE( "EGraph Hash-consing" )
+    {
+        test_graph egraph;
+
+        auto idx = make_node(egraph, "x");
+        auto idy = make_node(egraph, "y");
+        auto ida = make_node(egraph, "+", {idx, idy});
+
+        CHECK( make_node(egraph, "x") == idx );
+        CHECK( make_node(egraph, "+", {idx, idy}) == ida );
+        CHECK( make_node(egraph, "+", {idy, idx}) != ida );
+
+        CHECK( egraph.num_of_nodes() == 4 );
+        CHECK( egraph.num_of_eclasses() == 4 );
+        CHECK( egraph.eclass( idx ).parents.size() == 2 );
+    }
+
+    TEST_CASE( "EGraph Congruence Closure" )
+    {
+        test_graph egraph;
+
+        auto idx = make_node(egraph, "x");
+        auto idy = make_node(egraph, "y");
+        auto idz = make_node(egraph, "z");
+        auto fx  = make_node(egraph, "f", {idx, idz});
+        auto fy  = make_node(egraph, "f", {idy, idz});
+        auto gfx = make_node(egraph, "g", {fx});
+        auto gfy = make_node(egraph, "g", {fy});
+
+        auto saturable = saturable_egraph(std::move(egraph));
+
+        saturable.merge( idx, idy );
+        saturable.rebuild();
+
+        // congruence is propagated through all layers
+        CHECK( saturable.find( fx ) == saturable.find( fy ) );
+        CHECK( saturable.find( gfx ) == saturable.find( gfy ) );
+
+        // duplicates are removed
+        CHECK( saturable.num_of_nodes() == 5 );
+        CHECK( saturable.num_of_eclasses() == 4 );
+        CHECK( saturable.eclass( fx ).size() == 1 );
+        CHECK( saturable.eclass( gfx ).size() == 1 );
+        CHECK( saturable.eclass( idx ).parents.size() == 1 );
+        CHECK( saturable.eclass( idz ).parents.size() == 1 );
+        CHECK( saturable.eclass( fx ).parents.size() == 1 );
+
+        // memo is kept up to date
+        CHECK( make_node(saturable, "f", {idy, idz}) == saturable.find( fx ) );
+        CHECK( make_node(saturable, "g", {fy}) == saturable.find( gfx ) );
+        CHECK( saturable.num_of_nodes() == 5 );
+    }
+
+    TEST_CASE( "EGraph Tombstones" )
+    {
+        test_graph egraph;
+
+        std::vector< node_handle > leaves;
+        for (std::size_t i = 0; i < 8; ++i) {
+            leaves.push_back(make_node(egraph, "x" + std::to_string(i)));
+        }
+        auto root = make_node(egraph, "f", {leaves[0], leaves[1]});
+
+        auto saturable = saturable_egraph(std::move(egraph));
+
+        // merged classes leave tombstones that are never visited
+        for (std::size_t i = 1; i < leaves.size(); ++i) {
+            saturable.merge( leaves[0], leaves[i] );
+        }
+        saturable.rebuild();
+
+        CHECK( saturable.num_of_eclasses() == 2 );
+        CHECK( saturable.num_of_nodes() == 9 );
+        CHECK( saturable.eclass( leaves[7] ).size() == 8 );
+        CHECK( saturable.eclass( leaves[0] ).parents.size() == 1 );
+
+        std::size_t visited = 0;
+        for (const auto &[handle, cls] : saturable.eclasses()) {
+            CHECK( saturable.find( handle ) == handle );
+            ++visited;
+        }
+        CHECK( visited == 2 );
+
+        // classes and enodes can be still added after compaction
+        auto other = make_node(saturable, "f", {leaves[1], leaves[0]});
+        CHECK( other == saturable.find( root ) );
+        CHECK( saturable.num_of_eclasses() == 2 );
+
+        auto fresh = make_node(saturable, "g", {root});
+        CHECK( saturable.num_of_eclasses() == 3 );
+        CHECK( saturable.eclass( fresh ).size() == 1 );
+    }
+
+    struct name_cost {
+        cost_t operator()(const test_graph::node_pointer node) const {
+            if (node_name(*node) == "big") {
+                return 10;
+            }
+            return node_name(*node) == "k" ? 5 : 1;
+        }
+    };
+
+    TEST_CASE( "EGraph Extraction" )
+    {
+        test_graph egraph;
+
+        auto idx  = make_node(egraph, "x");
+        auto big  = make_node(egraph, "big", {idx});
+        auto idh  = make_node(egraph, "h", {big});
+        auto idk  = make_node(egraph, "k");
+        auto idg  = make_node(egraph, "g", {big});
+        auto root = make_node(egraph, "pair", {idh, idg});
+
+        auto idy  = make_node(egraph, "y");
+        auto loop = make_node(egraph, "f", {idy});
+
+        auto saturable = saturable_egraph(std::move(egraph));
+        saturable.merge(idh, idk);
+        // loop: y = f(y)
+        saturable.merge(idy, loop);
+        saturable.rebuild();
+
+        auto optimal = optimal_graph_view< test_graph, name_cost >(std::move(saturable), name_cost{});
+
+        CHECK( node_name(*optimal.node(loop).node) == "y" );
+
+        // tree cost of h(big(x)) is 12, hence k is chosen although big(x) is
+        // needed by g anyway
+        CHECK( node_name(*optimal.node(idh).node) == "k" );
+        CHECK( optimal.dag_cost(root) == 18 );
+
+        CHECK( optimal.improve_sharing(root, 100) == 14 );
+        CHECK( node_name(*optimal.node(idh).node) == "h" );
+        CHECK( optimal.dag_cost(root) == 14 );
+    }
+
+    // Run explicitly with `--no-skip`; rebuild after a few merges should take the same
+    // time regardless of the size of the egraph.
+    TEST_CASE( "benchmark: rebuild" * doctest::skip() )
+    {
+        for (std::size_t size : { 10'000, 100'000, 1'000'000 }) {
+            test_graph egraph;
+
+            std::vector< node_handle > leaves;
+            for (std::size_t i = 0; i < size / 2; ++i) {
+                leaves.push_back(make_node(egraph, "x" + std::to_string(i)));
+            }
+            for (std::size_t i = 0; i + 1 < leaves.size(); i += 2) {
+                make_node(egraph, "f", {leaves[i], leaves[i + 1]});
+                make_node(egraph, "g", {leaves[i + 1], leaves[i]});
+            }
+
+            auto saturable = saturable_egraph(std::move(egraph));
+
+            auto start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < 100; ++i) {
+                saturable.merge( leaves[2 * i], leaves[2 * i + 1] );
+                saturable.rebuild();
+            }
+            auto us = std::chrono::duration_cast< std::chrono::microseconds >(
+                std::chrono::steady_clock::now() - start
+            ).count();
+
+            MESSAGE( saturable.num_of_nodes() << " nodes, " << saturable.num_of_eclasses()
+                     << " classes, 100 rebuilds: " << us << " us" );
+        }
+    }
+
     //   TEST_CASE("EGraph with bitwidths")
     //   {
     //     TestGraph egraph;
@@ -15,6 +15,8 @@
 
 #include <support/egraph.hpp>
 
+#include <chrono>
+
 namespace eqsat::test {
 
     #pragma GCC diagnostic push
@@ -134,6 +136,105 @@ namespace eqsat::test {
         CHECK(count_matches(match(rule, saturable)) == 8);
     }
 
+    TEST_CASE("operator index") {
+        test_graph egraph;
+
+        auto idx  = make_node(egraph, "x");
+        auto idy  = make_node(egraph, "y");
+        auto add1 = make_node(egraph, "add", {idx, idy});
+        auto add2 = make_node(egraph, "add", {idy, idx});
+        auto mul  = make_node(egraph, "mul", {idx, idy});
+
+        CHECK(egraph.num_of_eclasses(intern("add")) == 2);
+        CHECK(egraph.num_of_eclasses(intern("mul")) == 1);
+        CHECK(egraph.num_of_eclasses(intern("sub")) == 0);
+
+        auto add = rewrite_rule("commutativity", "(op_add ?x ?y)", "(op_add ?y ?x)");
+        auto mult = rewrite_rule("commutativity", "(op_mul ?x ?y)", "(op_mul ?y ?x)");
+        CHECK(count_matches(match(add, egraph)) == 2);
+        CHECK(count_matches(match(mult, egraph)) == 1);
+
+        auto saturable = saturable_egraph(std::move(egraph));
+
+        saturable.merge(add1, add2);
+        saturable.rebuild();
+        CHECK(saturable.num_of_eclasses(intern("add")) == 1);
+        CHECK(count_matches(match(add, saturable)) == 2);
+
+        // merged class contains both operators
+        saturable.merge(add1, mul);
+        saturable.rebuild();
+        CHECK(saturable.num_of_eclasses(intern("add")) == 1);
+        CHECK(saturable.num_of_eclasses(intern("mul")) == 1);
+        CHECK(count_matches(match(add, saturable)) == 2);
+        CHECK(count_matches(match(mult, saturable)) == 1);
+    }
+
+    TEST_CASE("compiled program") {
+        auto opcodes = [] (const match_program &program) {
+            std::vector< opcode > result;
+            for (const auto &inst : program.code) {
+                result.push_back(inst.op);
+            }
+            return result;
+        };
+
+        auto twice = rewrite_rule("twice", "(op_add ?x ?x)", "(op_mul 2:64 ?x)");
+        CHECK(opcodes(twice.program) == std::vector< opcode >{
+            opcode::scan_eclasses, opcode::scan_nodes, opcode::check_operation,
+            opcode::load_children, opcode::scan_nodes, opcode::scan_nodes,
+            opcode::compare, opcode::yield
+        });
+
+        // the second occurrence of ?x is compared to the eclass bound by the first one
+        CHECK(twice.program.places.size() == 1);
+        CHECK(twice.program.place_registers == std::vector< std::uint32_t >{ 1 });
+        CHECK(twice.program.code[6].dst == 1);
+        CHECK(twice.program.code[6].src == 2);
+
+        // root operation selects candidate eclasses
+        CHECK(twice.program.code[0].arg == intern("add").id);
+
+        auto any = rewrite_rule("identity", "(?x)", "(?x)");
+        CHECK(any.program.code[0].arg == instruction::any_operation);
+
+        // every label of a multi-match has to bind all places
+        auto disjoint = rewrite_rule(
+            "disjoint",
+            "((let A (op_mul ?a ?b)) (let B (op_mul ?c ?d)) (match $A $B))",
+            "(union $A $B)"
+        );
+        CHECK(disjoint.program.code.empty());
+    }
+
+    TEST_CASE("benchmark: matching scales with candidates" * doctest::skip()) {
+        auto rule = rewrite_rule("commutativity", "(op_add ?x ?y)", "(op_add ?y ?x)");
+
+        for (std::size_t size : {1'000, 10'000, 100'000}) {
+            test_graph egraph;
+
+            auto idx = make_node(egraph, "x");
+            auto idy = make_node(egraph, "y");
+            for (std::size_t i = 0; i < 100; ++i) {
+                make_node(egraph, "add", {idx, make_node(egraph, std::to_string(i) + ":64")});
+            }
+
+            // unrelated enodes, these are never visited by the matcher
+            auto last = idy;
+            for (std::size_t i = 0; i < size; ++i) {
+                last = make_node(egraph, "mul", {idx, last});
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            auto matches = count_matches(match(rule, egraph));
+            auto us = std::chrono::duration_cast< std::chrono::microseconds >(
+                std::chrono::steady_clock::now() - start
+            ).count();
+
+            MESSAGE(egraph.num_of_nodes() << " nodes, " << matches << " matches, " << us << " us");
+        }
+    }
+
     } // test suite: eqsat::pattern-patching
 
 } // namespace eqsat::test
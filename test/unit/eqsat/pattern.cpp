@@ -52,6 +52,20 @@ namespace eqsat::test {
         CHECK(parse_constant("400:64"));
     }
 
+    TEST_CASE("Operation Symbols") {
+        auto add = parse_atom("op_add");
+        CHECK(add);
+        CHECK(std::holds_alternative< operation_t >(add.value()));
+
+        auto symbol = std::get< operation_t >(add.value()).symbol;
+        CHECK_EQ(symbol, intern("add"));
+        CHECK_EQ(symbol.name(), "add");
+
+        // the same name is interned only once
+        CHECK_EQ(std::get< operation_t >(parse_atom("op_add").value()).symbol, symbol);
+        CHECK_NE(std::get< operation_t >(parse_atom("op_mul").value()).symbol, symbol);
+    }
+
     TEST_CASE("Expr Parser") {
         CHECK(parse_simple_expr("(op_add ?x ?y)"));
         CHECK(parse_simple_expr("(op_add ?x (op_mul 2:64 ?y))"));
@@ -15,6 +15,9 @@
 
 #include <support/egraph.hpp>
 
+#include <filesystem>
+#include <sstream>
+
 namespace eqsat::test {
 
     #pragma GCC diagnostic push
@@ -110,7 +113,9 @@ namespace eqsat::test {
 
         auto root1 = result.eclass(add2);
 
-        CHECK_EQ(root1.nodes.size(), 5);
+        // a, (add a 0), (add 0 a); congruent (add (add a 0) 0) and
+        // (add 0 (add a 0)) are removed once both additions are in the class of a
+        CHECK_EQ(root1.nodes.size(), 3);
         CHECK_EQ(result.eclass(add2), result.eclass(add1));
 
         result = saturable_egraph(std::move(result))
@@ -119,7 +124,7 @@ namespace eqsat::test {
 
         auto root2 = result.eclass(add2);
 
-        CHECK_EQ(root2.nodes.size(), 5);
+        CHECK_EQ(root2.nodes.size(), 3);
         CHECK_EQ(result.eclass(ida), result.eclass(add2));
         CHECK_EQ(result.eclass(add1), result.eclass(add2));
     }
@@ -529,4 +534,281 @@ namespace eqsat::test {
     // }
 
     } // test suite: eqsat::pattern-rewrite
+
+    TEST_SUITE("eqsat::saturation") {
+
+    static inline std::vector< rule_set > commutativity_rules() {
+        return { rule_set{ "commutativity", {
+            rewrite_rule("commutativity", "(op_add ?x ?y)", "(op_add ?y ?x)")
+        } } };
+    }
+
+    TEST_CASE("saturated") {
+        test_graph egraph;
+        auto idx = make_node(egraph, "x:64");
+        auto idy = make_node(egraph, "y:64");
+        auto add = make_node(egraph, "add", {idx, idy});
+
+        auto rules = commutativity_rules();
+        saturation_stats stats;
+        auto [result, reason] = saturate(saturable_egraph(std::move(egraph)), rules, {}, stats);
+
+        CHECK_EQ(reason, stop_reason::saturated);
+        CHECK_EQ(stats.reason, stop_reason::saturated);
+        CHECK_EQ(stats.iterations.size(), 2);
+        CHECK_EQ(stats.iterations[0].applied, 1);
+        CHECK_EQ(stats.iterations[1].nodes, 4);
+        CHECK_EQ(result.eclass(add).size(), 2);
+    }
+
+    TEST_CASE("iteration limit") {
+        test_graph egraph;
+        auto idx = make_node(egraph, "x:64");
+        auto idy = make_node(egraph, "y:64");
+        make_node(egraph, "add", {idx, idy});
+
+        auto rules = commutativity_rules();
+        saturation_stats stats;
+        auto [result, reason] = saturate(
+            saturable_egraph(std::move(egraph)), rules, { .iteration_limit = 1 }, stats
+        );
+
+        CHECK_EQ(reason, stop_reason::iteration_limit);
+        CHECK_EQ(stats.iterations.size(), 1);
+    }
+
+    TEST_CASE("node limit") {
+        test_graph egraph;
+        auto idx = make_node(egraph, "x:64");
+        auto idy = make_node(egraph, "y:64");
+        make_node(egraph, "add", {idx, idy});
+
+        auto rules = commutativity_rules();
+        saturation_stats stats;
+        auto [result, reason] = saturate(
+            saturable_egraph(std::move(egraph)), rules, { .node_limit = 3 }, stats
+        );
+
+        CHECK_EQ(reason, stop_reason::node_limit);
+        CHECK_EQ(stats.iterations.size(), 1);
+        CHECK_EQ(result.num_of_nodes(), 4);
+    }
+
+    TEST_CASE("memory limit") {
+        test_graph egraph;
+        auto idx = make_node(egraph, "x:64");
+        auto idy = make_node(egraph, "y:64");
+        make_node(egraph, "add", {idx, idy});
+
+        // the limit is checked before each iteration, not after each applied rule
+        auto limit = egraph.size_in_bytes();
+        auto rules = commutativity_rules();
+        saturation_stats stats;
+        auto [result, reason] = saturate(
+            saturable_egraph(std::move(egraph)), rules, { .memory_limit = limit }, stats
+        );
+
+        CHECK_EQ(reason, stop_reason::memory_limit);
+        CHECK_EQ(stats.iterations.size(), 1);
+        CHECK_EQ(result.num_of_nodes(), 4);
+    }
+
+    TEST_CASE("backoff") {
+        test_graph egraph;
+        auto idx = make_node(egraph, "x:64");
+        auto idy = make_node(egraph, "y:64");
+        auto idu = make_node(egraph, "u:64");
+        auto idv = make_node(egraph, "v:64");
+        auto add = make_node(egraph, "add", {idx, idy});
+        make_node(egraph, "add", {idu, idv});
+
+        auto rules = commutativity_rules();
+        saturation_stats stats;
+        auto [result, reason] = saturate(
+            saturable_egraph(std::move(egraph)), rules,
+            { .match_limit = 1, .ban_length = 1 }, stats
+        );
+
+        // banned with 2 matches > 1, then applied with 2 matches <= 2,
+        // banned with 4 matches > 2 and finally saturated with 4 matches <= 4
+        CHECK_EQ(reason, stop_reason::saturated);
+        REQUIRE_EQ(stats.iterations.size(), 4);
+        CHECK_EQ(stats.iterations[0].banned, 1);
+        CHECK_EQ(stats.iterations[1].applied, 2);
+        CHECK_EQ(stats.iterations[2].banned, 1);
+        CHECK_EQ(stats.iterations[3].applied, 4);
+        CHECK_EQ(result.eclass(add).size(), 2);
+    }
+
+    TEST_CASE("profile") {
+        test_graph egraph;
+        auto idx = make_node(egraph, "x:64");
+        auto idy = make_node(egraph, "y:64");
+        make_node(egraph, "add", {idx, idy});
+
+        auto rules = commutativity_rules();
+        saturation_stats stats;
+        std::size_t observed = 0;
+        saturate(
+            saturation_snapshot< test_graph >{ saturable_egraph(std::move(egraph)) },
+            rules, { .profile = true }, stats,
+            [&] (const auto &, iteration_stats &it) { ++observed; it.extract_ms = 1; }
+        );
+
+        REQUIRE_EQ(stats.iterations.size(), 2);
+        CHECK_EQ(observed, 2);
+
+        const auto &first = stats.iterations[0];
+        CHECK_EQ(first.extract_ms, 1);
+        REQUIRE_EQ(first.rules.size(), 1);
+        CHECK_EQ(first.rules[0].rule, "commutativity");
+        CHECK_EQ(first.rules[0].matches, 1);
+        CHECK_EQ(first.rules[0].new_nodes, 1);
+        CHECK_EQ(first.rules[0].merges, 1);
+        CHECK_FALSE(first.rules[0].banned);
+
+        // a row per iteration and rule
+        std::stringstream csv;
+        write_csv(csv, "test", stats);
+        std::string line;
+        std::size_t rows = 0;
+        while (std::getline(csv, line)) {
+            CHECK(line.starts_with("\"test\","));
+            ++rows;
+        }
+        CHECK_EQ(rows, 2);
+
+        // control characters in names are escaped
+        std::stringstream json;
+        write_json(json, "a\x01\tb", stats);
+        CHECK(json.str().find("\"a\\u0001\\tb\"") != std::string::npos);
+    }
+
+    static inline test_graph sum_graph() {
+        test_graph egraph;
+        auto sum = make_node(egraph, "x0:64");
+        for (auto var : { "x1:64", "x2:64", "x3:64" }) {
+            sum = make_node(egraph, "add", {sum, make_node(egraph, var)});
+            sum = make_node(egraph, "mul", {sum, make_node(egraph, "2:64")});
+        }
+        return egraph;
+    }
+
+    static inline std::vector< rule_set > arithmetic_rules() {
+        return { rule_set{ "arithmetic", {
+            rewrite_rule("add-commutativity", "(op_add ?x ?y)", "(op_add ?y ?x)"),
+            rewrite_rule("mul-commutativity", "(op_mul ?x ?y)", "(op_mul ?y ?x)"),
+            rewrite_rule("mul-to-add", "(op_mul ?x 2:64)", "(op_add ?x ?x)"),
+            rewrite_rule("distributivity", "(op_mul (op_add ?x ?y) ?z)", "(op_add (op_mul ?x ?z) (op_mul ?y ?z))")
+        } } };
+    }
+
+    TEST_CASE("parallel matching") {
+        auto rules = arithmetic_rules();
+
+        auto run = [&] (std::size_t workers) {
+            saturation_stats stats;
+            auto [result, reason] = saturate(
+                saturable_egraph(sum_graph()), rules,
+                { .iteration_limit = 4, .workers = workers }, stats
+            );
+            return std::make_tuple(result.num_of_nodes(), result.num_of_eclasses(), stats.iterations.size());
+        };
+
+        auto sequential = run(1);
+        CHECK_EQ(run(2), sequential);
+        CHECK_EQ(run(8), sequential);
+    }
+
+    TEST_CASE("parallel step") {
+        auto rules = arithmetic_rules();
+
+        auto step = [&] (std::size_t workers) {
+            auto [result, reason] = make_step(saturable_egraph(sum_graph()), rules, workers);
+            CHECK_FALSE(result.frozen());
+            return std::make_tuple(result.num_of_nodes(), result.num_of_eclasses(), reason);
+        };
+
+        auto sequential = step(1);
+        CHECK_EQ(std::get< 2 >(sequential), stop_reason::none);
+        CHECK_EQ(step(4), sequential);
+    }
+
+    static inline auto snapshot_of(const saturable_egraph< test_graph > &graph, std::size_t iteration = 0) {
+        std::stringstream buffer;
+        save_snapshot(buffer, graph, iteration, {});
+        return load_snapshot< test_graph >(buffer);
+    }
+
+    TEST_CASE("snapshot") {
+        test_graph egraph;
+        auto idx = make_node(egraph, "x:64");
+        auto idy = make_node(egraph, "y:64");
+        auto fx  = make_node(egraph, "f", {idx});
+        auto fy  = make_node(egraph, "f", {idy});
+
+        auto saturable = saturable_egraph(std::move(egraph));
+        saturable.merge(idx, idy);
+
+        // pending classes are saved, congruence of f(x) and f(y) is found after load
+        auto loaded = snapshot_of(saturable, 3);
+        CHECK_EQ(loaded.iteration, 3);
+        CHECK_EQ(loaded.graph.num_of_nodes(), 4);
+        CHECK_EQ(loaded.graph.num_of_merges(), 1);
+        CHECK_EQ(loaded.graph.find(idx), loaded.graph.find(idy));
+        CHECK_NE(loaded.graph.find(fx), loaded.graph.find(fy));
+
+        loaded.graph.rebuild();
+        CHECK_EQ(loaded.graph.find(fx), loaded.graph.find(fy));
+        CHECK_EQ(loaded.graph.num_of_nodes(), 3);
+        CHECK_EQ(loaded.graph.num_of_eclasses(), 2);
+
+        // hash-consing survives the snapshot
+        CHECK_EQ(make_node(loaded.graph, "f", {idx}), loaded.graph.find(fx));
+        CHECK_EQ(loaded.graph.num_of_nodes(), 3);
+
+        std::stringstream garbage("not a snapshot");
+        CHECK_THROWS_AS(load_snapshot< test_graph >(garbage), snapshot_error);
+    }
+
+    TEST_CASE("resume from snapshot") {
+        auto rules = arithmetic_rules();
+
+        saturation_stats whole_stats;
+        auto whole = saturate(
+            saturable_egraph(sum_graph()), rules, { .iteration_limit = 4 }, whole_stats
+        );
+        REQUIRE_EQ(whole_stats.iterations.size(), 4);
+
+        auto path = std::filesystem::temp_directory_path() / "eqsat-test-snapshot";
+        saturation_stats stats;
+        saturate(
+            saturable_egraph(sum_graph()), rules,
+            { .iteration_limit = 2, .checkpoint = path, .checkpoint_interval = 1 }, stats
+        );
+        CHECK_EQ(stats.reason, stop_reason::iteration_limit);
+
+        auto snapshot = load_snapshot< test_graph >(path);
+        std::filesystem::remove(path);
+        CHECK_EQ(snapshot.iteration, 2);
+
+        // the snapshot remembers the egraph the saturation started from
+        auto origin = fingerprint(saturable_egraph(sum_graph()));
+        CHECK_EQ(snapshot.origin, origin);
+        CHECK_NE(snapshot.origin, fingerprint(saturable_egraph(test_graph())));
+        CHECK_NE(snapshot.origin, fingerprint(snapshot.graph));
+
+        saturation_stats resumed_stats;
+        auto [resumed, reason] = saturate(
+            std::move(snapshot), rules, { .iteration_limit = 4 }, resumed_stats
+        );
+
+        CHECK_EQ(reason, whole.second);
+        REQUIRE_EQ(resumed_stats.iterations.size(), 2);
+        CHECK_EQ(resumed_stats.iterations[0].iteration, 2);
+        CHECK_EQ(resumed.num_of_nodes(), whole.first.num_of_nodes());
+        CHECK_EQ(resumed.num_of_eclasses(), whole.first.num_of_eclasses());
+    }
+
+    } // test suite: eqsat::saturation
 } // namespace eqsat::test
@@ -10,23 +10,45 @@
 
 #include <charconv>
 #include <string>
+#include <type_traits>
 
 namespace eqsat::test {
 
     struct string_storage
     {
-        explicit string_storage( std::string_view str ) : data( str ) { }
+        explicit string_storage( std::string_view str ) : data( str ), symbol( intern( str ) ) { }
 
         bool operator==( const string_storage & ) const = default;
 
         std::string data;
+        symbol_t symbol;
     };
 
+    static inline gap::hash_code hash_value( gap::hash_code code, const string_storage &node )
+    {
+        return gap::hash_combine( code, gap::hash_code( std::hash< std::string >{}( node.data ) ) );
+    }
+
     static inline std::string node_name( const string_storage &node )
     {
         return node.data;
     }
 
+    static inline symbol_t node_symbol( const string_storage &node )
+    {
+        return node.symbol;
+    }
+
+    static inline void save_storage( snapshot_output &out, const string_storage &node )
+    {
+        out.write( std::string_view( node.data ) );
+    }
+
+    static inline string_storage load_storage( snapshot_input &in, std::type_identity< string_storage > )
+    {
+        return string_storage( in.read_string() );
+    }
+
     static inline std::optional< gap::bigint > extract_constant( std::string_view str ) {
         auto split = str.find_first_of(':');
         if (split == std::string_view::npos) {
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2023, Trail of Bits, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed in accordance with the terms specified in
+ * the LICENSE file found in the root directory of this source tree.
+ */
+
+#include <doctest/doctest.h>
+
+#include <circuitous/IR/Memory.hpp>
+#include <circuitous/Run/Batch.hpp>
+#include <circuitous/Run/TraceConversion.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+namespace circ::run::test
+{
+    struct batch_dir
+    {
+        std::filesystem::path root = std::filesystem::temp_directory_path() /
+                                     "circuitous-batch-test";
+
+        batch_dir()
+        {
+            std::filesystem::remove_all( root );
+            std::filesystem::create_directories( root / "traces" );
+        }
+
+        ~batch_dir() { std::filesystem::remove_all( root ); }
+
+        void touch( const std::filesystem::path &path, const std::string &content = "" )
+        {
+            std::ofstream( root / path ) << content;
+        }
+    };
+
+    std::string hex( const llvm::APInt &value ) { return llvm::toString( value, 16, false ); }
+
+    // Inverse of `FromJSON::ParseEntry`.
+    llvm::json::Object native_entry( const trace::native::Trace::Entry &entry )
+    {
+        llvm::json::Object out;
+        llvm::json::Object regs;
+        std::map< std::size_t, llvm::json::Value > hints;
+
+        for ( const auto &[ key, value ] : entry )
+        {
+            if ( !value )
+                continue;
+
+            auto name = llvm::StringRef( key );
+            if ( name == "timestamp" || name == "error_flag" )
+            {
+                out[ key ] = hex( *value );
+            }
+            else if ( name == "instruction_bits" )
+            {
+                // Bytes are stored in the order they are in memory.
+                auto digits = hex( *value );
+                digits.insert( 0, 30 - digits.size(), '0' );
+                std::string bytes;
+                for ( auto i = digits.size(); i >= 2; i -= 2 )
+                    bytes += digits.substr( i - 2, 2 );
+                out[ key ] = bytes;
+            }
+            else if ( name.consume_front( "memory." ) )
+            {
+                std::size_t idx = 0;
+                REQUIRE( !name.getAsInteger( 10, idx ) );
+
+                auto ptr_size = ( value->getBitWidth() - irops::memory::size( 0 ) ) / 2;
+                auto extract = []( const auto &v, auto from, auto size )
+                {
+                    return v.extractBits( size, from );
+                };
+                auto hint = irops::memory::parse< llvm::APInt >( *value, extract, ptr_size );
+                hints.emplace( idx, llvm::json::Object{
+                    { "mode", hex( hint.mode() ) }, { "id", hex( hint.id() ) },
+                    { "size", hex( hint.size() ) }, { "addr", hex( hint.addr() ) },
+                    { "val", hex( hint.value() ) }, { "ts", hex( hint.timestamp() ) } } );
+            }
+            else
+            {
+                regs[ key ] = hex( *value );
+            }
+        }
+
+        llvm::json::Array ordered;
+        for ( auto &[ _, hint ] : hints )
+            ordered.push_back( std::move( hint ) );
+
+        out[ "regs" ] = std::move( regs );
+        out[ "memory_hints" ] = std::move( ordered );
+        return out;
+    }
+
+    void write_jsonl( const std::filesystem::path &path, const trace::native::Trace &trace )
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream os( path.string(), ec, llvm::sys::fs::OF_Text );
+        REQUIRE( !ec );
+        for ( std::size_t i = 0; i < trace.size(); ++i )
+        {
+            llvm::json::OStream( os ).value( native_entry( trace[ i ] ) );
+            os << "\n";
+        }
+    }
+
+    // Every register of the last entry is changed, so the last step cannot be accepted.
+    trace::native::Trace tamper( trace::native::Trace trace )
+    {
+        for ( auto &[ key, value ] : trace[ trace.size() - 1 ] )
+        {
+            auto name = llvm::StringRef( key );
+            if ( value && name != "timestamp" && name != "error_flag" &&
+                 name != "instruction_bits" && !name.startswith( "memory." ) )
+            {
+                *value ^= 1;
+            }
+        }
+        return trace;
+    }
+
+    llvm::json::Value load( const std::string &path )
+    {
+        auto buffer = llvm::MemoryBuffer::getFile( path );
+        REQUIRE( static_cast< bool >( buffer ) );
+        auto json = llvm::json::parse( buffer.get()->getBuffer() );
+        REQUIRE( static_cast< bool >( json ) );
+        return std::move( *json );
+    }
+
+    TEST_SUITE( "run::batch" )
+    {
+        TEST_CASE( "directory" )
+        {
+            batch_dir dir;
+            dir.touch( "traces/b.jsonl" );
+            dir.touch( "traces/a.json" );
+            dir.touch( "traces/notes.txt" );
+
+            auto traces = collect_traces( ( dir.root / "traces" ).string() );
+            REQUIRE( traces.size() == 2 );
+            CHECK( std::filesystem::path( traces[ 0 ] ).filename() == "a.json" );
+            CHECK( std::filesystem::path( traces[ 1 ] ).filename() == "b.jsonl" );
+        }
+
+        TEST_CASE( "manifest" )
+        {
+            batch_dir dir;
+            dir.touch( "manifest", "# comment\n\ntraces/a.json\n  /abs/b.json  \n" );
+
+            auto traces = collect_traces( ( dir.root / "manifest" ).string() );
+            REQUIRE( traces.size() == 2 );
+            CHECK( traces[ 0 ] == ( dir.root / "traces/a.json" ).string() );
+            CHECK( traces[ 1 ] == "/abs/b.json" );
+        }
+
+        TEST_CASE( "verify" )
+        {
+            circ::add_sink< circ::severity::kill >( std::cerr );
+
+            trace::with_reconstructor loader;
+            auto trace = loader.parse_alien_trace( "trace-conversion/inputs/alu_adc.trace.txt" );
+            auto circuit = std::move( loader ).reconstruct();
+            REQUIRE( trace.size() > 1 );
+
+            batch_dir dir;
+            write_jsonl( dir.root / "traces/a.jsonl", trace );
+            write_jsonl( dir.root / "traces/b.jsonl", tamper( trace ) );
+            // Entry misses all the fields.
+            dir.touch( "traces/c.json", "{ \"id\": 0, \"entries\": [ {} ] }" );
+
+            auto traces = collect_traces( ( dir.root / "traces" ).string() );
+            traces.push_back( ( dir.root / "missing.json" ).string() );
+
+            batch_config config{ .workers = 2, .output_dir = ( dir.root / "out" ).string() };
+            auto summary = verify_batch( circuit.get(), traces, config );
+
+            REQUIRE( summary.entries.size() == 4 );
+            CHECK( summary.accepted() == 1 );
+            CHECK( summary.rejected() == 1 );
+            CHECK( summary.errors() == 2 );
+
+            const auto &good = summary.entries[ 0 ];
+            CHECK( accepted( good.result ) );
+            CHECK( good.steps == trace.size() - 1 );
+            CHECK( good.error.empty() );
+
+            auto result = load( good.output );
+            auto obj = result.getAsObject();
+            REQUIRE( obj );
+            CHECK( obj->getString( "result" ).value_or( "" ) == export_result( good.result ) );
+            REQUIRE( obj->getObject( "traces" ) );
+            CHECK( obj->getObject( "traces" )->size() == good.steps );
+
+            const auto &bad = summary.entries[ 1 ];
+            CHECK( rejected( bad.result ) );
+            CHECK( bad.steps == trace.size() - 1 );
+            CHECK( std::filesystem::exists( bad.output ) );
+
+            // Neither of these is verified, nor has a result file.
+            for ( const auto &entry : { summary.entries[ 2 ], summary.entries[ 3 ] } )
+            {
+                CHECK( !entry.error.empty() );
+                CHECK( entry.steps == 0 );
+                CHECK( !std::filesystem::exists( entry.output ) );
+            }
+
+            auto stored = load( summary.store( config.output_dir ) );
+            auto totals = stored.getAsObject();
+            REQUIRE( totals );
+            CHECK( totals->getInteger( "total" ) == 4 );
+            CHECK( totals->getInteger( "accepted" ) == 1 );
+            CHECK( totals->getInteger( "rejected" ) == 1 );
+            CHECK( totals->getInteger( "errors" ) == 2 );
+
+            auto entries = totals->getArray( "traces" );
+            REQUIRE( entries );
+            REQUIRE( entries->size() == 4 );
+            auto has_error = [ & ]( std::size_t idx )
+            {
+                return ( *entries )[ idx ].getAsObject()->getString( "error" ).has_value();
+            };
+            CHECK( !has_error( 0 ) );
+            CHECK( has_error( 2 ) );
+            CHECK( has_error( 3 ) );
+        }
+    } // test suite: run::batch
+
+} // namespace circ::run::test
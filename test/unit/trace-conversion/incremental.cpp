@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2023, Trail of Bits, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed in accordance with the terms specified in
+ * the LICENSE file found in the root directory of this source tree.
+ */
+
+#include <doctest/doctest.h>
+
+#include <circuitous/Run/IncrementalConversion.hpp>
+
+#include <filesystem>
+
+namespace circ::run::test
+{
+    std::filesystem::path incremental_input( const std::string &test_name )
+    {
+        return std::filesystem::path( "trace-conversion" ) / "inputs" /
+               ( test_name + ".trace.txt" );
+    }
+
+    // Coverage of `base` is first `covered` distinct encodings of the trace, the rest
+    // has to be lifted into a delta circuit. Converted entries are compared field by
+    // field with the full conversion of the same trace by a circuit of all its encodings.
+    void check_incremental( const std::string &test_name, std::size_t covered,
+                            std::size_t workers )
+    {
+        circ::add_sink< circ::severity::kill >( std::cerr );
+
+        trace::incremental_loader loader;
+        auto traces = loader.parse_alien_trace( incremental_input( test_name ) );
+
+        trace::coverage_t coverage;
+        std::vector< remill::Instruction > base_insts;
+        for ( const auto &inst : loader.seen )
+        {
+            if ( coverage.size() >= covered )
+                break;
+            if ( coverage.encodings.insert( inst.bytes ).second )
+                base_insts.push_back( inst );
+        }
+
+        auto base = CircuitSmithy( circ::Ctx{ "macos", "x86" } )
+            .make( lifter_kind::disjunctions, std::move( base_insts ) );
+        auto plan = loader.plan( coverage );
+
+        auto delta = std::move( loader ).reconstruct_delta( plan );
+        CHECK( static_cast< bool >( delta ) == plan.needs_delta() );
+
+        trace::incremental_config config{ .workers = workers, .batch = 2 };
+        trace::incremental_converter converter( base.get(), delta.get(), config );
+        converter.convert_trace( traces, plan );
+
+        REQUIRE( !converter.failure );
+        REQUIRE( converter.to_export.size() == traces.size() );
+
+        trace::with_reconstructor full_loader;
+        auto full_traces = full_loader.parse_alien_trace( incremental_input( test_name ) );
+        auto full = std::move( full_loader ).reconstruct();
+
+        trace::trace_converter< trace::reporting_collector > reference;
+        reference.convert_trace( full_traces, full.get() );
+
+        REQUIRE( !reference.failure );
+        REQUIRE( reference.to_export.size() == converter.to_export.size() );
+
+        for ( const auto &[ from, size, name ] : circ::Trace::make( full.get() ).storage )
+        {
+            auto it = converter.layout.find( name );
+            REQUIRE( it != converter.layout.end() );
+            auto [ to, converted_size ] = it->second;
+            REQUIRE( converted_size == size );
+
+            for ( std::size_t i = 0; i < reference.to_export.size(); ++i )
+            {
+                INFO( "field " << name << " of entry " << i );
+                CHECK( converter.to_export[ i ].substr( to, size )
+                       == reference.to_export[ i ].substr( from, size ) );
+            }
+        }
+    }
+
+    TEST_SUITE( "run::incremental" )
+    {
+        TEST_CASE( "fully covered" )
+        {
+            check_incremental( "alu_adc", 64, 1 );
+            check_incremental( "push_pop", 64, 4 );
+        }
+
+        TEST_CASE( "with delta" )
+        {
+            check_incremental( "alu_adc", 1, 4 );
+            check_incremental( "push_pop", 1, 4 );
+        }
+    } // test suite: run::incremental
+
+} // namespace circ::run::test
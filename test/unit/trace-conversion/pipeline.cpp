@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2023, Trail of Bits, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed in accordance with the terms specified in
+ * the LICENSE file found in the root directory of this source tree.
+ */
+
+#include <doctest/doctest.h>
+
+#include <circuitous/Run/Pipeline.hpp>
+#include <circuitous/Run/TraceConversion.hpp>
+
+#include <filesystem>
+
+namespace circ::run::test
+{
+    struct collecting_writer
+    {
+        std::vector< result_t > statuses;
+        std::optional< std::size_t > total;
+
+        void step( const step_result &step )
+        {
+            CHECK( step.idx == statuses.size() );
+            statuses.push_back( step.status );
+        }
+
+        void finish( result_t, std::size_t steps ) { total = steps; }
+    };
+
+    // Pipeline must report exactly what `StatelessControl` does, regardless of the number
+    // of workers.
+    bool pipeline_matches( const std::string &test_name, std::size_t workers )
+    {
+        circ::add_sink< circ::severity::kill >( std::cerr );
+
+        auto path = std::filesystem::path( "trace-conversion" ) / "inputs" /
+                    ( test_name + ".trace.txt" );
+
+        trace::with_reconstructor loader;
+        auto traces = loader.parse_alien_trace( path );
+        auto circuit = std::move( loader ).reconstruct();
+
+        auto ignore = []( const auto & ) {};
+        auto expected = StatelessControl().test( circuit.get(), traces, ignore );
+
+        collecting_writer writer;
+        pipeline_config config{ .workers = workers, .window = 4 };
+        verify_pipelined( circuit.get(), trace::native::EntryReader( std::move( traces ) ),
+                          writer, config );
+
+        return writer.total == expected.size() && writer.statuses == expected;
+    }
+
+    TEST_SUITE( "run::pipeline" )
+    {
+        TEST_CASE( "single worker" )
+        {
+            CHECK( pipeline_matches( "alu_adc", 1 ) );
+        }
+
+        TEST_CASE( "multiple workers" )
+        {
+            CHECK( pipeline_matches( "alu_adc", 4 ) );
+            CHECK( pipeline_matches( "push_pop", 4 ) );
+        }
+    } // test suite: run::pipeline
+
+} // namespace circ::run::test
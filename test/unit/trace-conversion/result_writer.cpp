@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2023, Trail of Bits, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed in accordance with the terms specified in
+ * the LICENSE file found in the root directory of this source tree.
+ */
+
+#include <doctest/doctest.h>
+
+#include <circuitous/Run/ResultWriter.hpp>
+
+#include <chrono>
+#include <sys/resource.h>
+
+namespace circ::run::test
+{
+    std::vector< step_result > synthetic_steps( std::size_t count )
+    {
+        irops::memory::Layout layout( 64 );
+        auto make_hint = [ & ]( uint64_t id, uint64_t ts )
+        {
+            std::vector< uint64_t > raw = { 1, id % 2, 0, id, 8, 0x1000 + id * 8, id, ts };
+            std::vector< llvm::APInt > vals;
+            for ( std::size_t i = 0; i < raw.size(); ++i )
+                vals.emplace_back( layout.defs[ i ], raw[ i ] );
+            return Memory::Parsed( 64, std::move( vals ) );
+        };
+
+        std::vector< step_result > out;
+        for ( std::size_t i = 0; i < count; ++i )
+        {
+            step_result step{ i, result_t::accepted, {} };
+            for ( uint64_t id = 0; id < i % 3; ++id )
+                step.memory_hints.push_back( make_hint( id, i ) );
+            out.push_back( std::move( step ) );
+        }
+        out.back().status = result_t::rejected;
+        return out;
+    }
+
+    template< typename Writer, typename ... Args >
+    std::string write_all( const std::vector< step_result > &steps, Args && ... args )
+    {
+        std::string out;
+        llvm::raw_string_ostream os( out );
+        Writer writer( os, std::forward< Args >( args ) ... );
+        for ( const auto &step : steps )
+            writer.step( step );
+        writer.finish( steps.back().status, steps.size() );
+        return os.str();
+    }
+
+    llvm::json::Value parse_json( const std::string &data )
+    {
+        auto maybe_json = llvm::json::parse( data );
+        REQUIRE( static_cast< bool >( maybe_json ) );
+        return std::move( *maybe_json );
+    }
+
+    long peak_rss_kb()
+    {
+        rusage usage;
+        getrusage( RUSAGE_SELF, &usage );
+        return usage.ru_maxrss;
+    }
+
+    TEST_SUITE( "run::result_writer" )
+    {
+        TEST_CASE( "streamed json matches dom" )
+        {
+            auto steps = synthetic_steps( 40 );
+            auto expected = parse_json( write_all< dom_result_writer >( steps ) );
+
+            CHECK( parse_json( write_all< json_result_writer >( steps ) ) == expected );
+            CHECK( parse_json( write_all< json_result_writer >( steps, 0u ) ) == expected );
+        }
+
+        // Run explicitly with `--no-skip`. Streamed writer goes first, so growth of peak
+        // RSS during the second half is caused by the DOM.
+        TEST_CASE( "benchmark: streamed vs dom" * doctest::skip() )
+        {
+            auto steps = synthetic_steps( 500000 );
+
+            auto measure = [ & ]( auto &&write )
+            {
+                auto rss = peak_rss_kb();
+                auto start = std::chrono::steady_clock::now();
+                write();
+                auto ms = std::chrono::duration_cast< std::chrono::milliseconds >(
+                        std::chrono::steady_clock::now() - start ).count();
+                return std::make_tuple( ms, peak_rss_kb() - rss );
+            };
+
+            auto stream_to_null = [ & ]( auto writer )
+            {
+                for ( const auto &step : steps )
+                    writer.step( step );
+                writer.finish( steps.back().status, steps.size() );
+            };
+
+            auto [ stream_ms, stream_kb ] = measure( [ & ]
+            {
+                stream_to_null( json_result_writer( llvm::nulls() ) );
+            } );
+            auto [ dom_ms, dom_kb ] = measure( [ & ]
+            {
+                stream_to_null( dom_result_writer( llvm::nulls() ) );
+            } );
+
+            MESSAGE( "streamed: " << stream_ms << " ms, +" << stream_kb << " KiB peak RSS" );
+            MESSAGE( "dom:      " << dom_ms << " ms, +" << dom_kb << " KiB peak RSS" );
+        }
+    } // test suite: run::result_writer
+
+} // namespace circ::run::test
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2023, Trail of Bits, Inc.
+ * All rights reserved.
+ *
+ * This source code is licensed in accordance with the terms specified in
+ * the LICENSE file found in the root directory of this source tree.
+ */
+
+#include <doctest/doctest.h>
+
+#include <circuitous/Run/StepCache.hpp>
+#include <circuitous/Run/TraceConversion.hpp>
+
+#include <filesystem>
+
+namespace circ::run::test
+{
+    TEST_SUITE( "run::step_cache" )
+    {
+        TEST_CASE( "memoized outcomes match" )
+        {
+            circ::add_sink< circ::severity::kill >( std::cerr );
+
+            auto path = std::filesystem::path( "trace-conversion" ) / "inputs" /
+                        "push_pop.trace.txt";
+
+            trace::with_reconstructor loader;
+            auto traces = loader.parse_alien_trace( path );
+            auto circuit = std::move( loader ).reconstruct();
+
+            auto expected = StatelessControl().test_outcomes( circuit.get(), traces );
+
+            step_cache cache( circuit.get() );
+            auto cold = StatelessControl().test_outcomes( circuit.get(), traces, &cache );
+            auto warm = StatelessControl().test_outcomes( circuit.get(), traces, &cache );
+
+            REQUIRE( cold.size() == expected.size() );
+            REQUIRE( warm.size() == expected.size() );
+            for ( std::size_t i = 0; i < expected.size(); ++i )
+            {
+                CHECK( cold[ i ].status == expected[ i ].status );
+                CHECK( warm[ i ].status == expected[ i ].status );
+                REQUIRE( warm[ i ].memory_hints.size() == expected[ i ].memory_hints.size() );
+                for ( std::size_t j = 0; j < expected[ i ].memory_hints.size(); ++j )
+                    CHECK( warm[ i ].memory_hints[ j ].vals
+                           == expected[ i ].memory_hints[ j ].vals );
+            }
+
+            // Second pass must be answered from the cache entirely.
+            auto stats = cache.stats();
+            CHECK( stats.hits >= stats.entries );
+            CHECK( stats.misses == stats.entries );
+        }
+
+        // All timestamps of the trace moved by `shift`, including these of memory hints.
+        static inline auto shifted( auto trace, uint64_t shift )
+        {
+            for ( auto &entry : trace.entries )
+                for ( auto &[ key, val ] : entry )
+                {
+                    if ( !val )
+                        continue;
+                    if ( key == "timestamp" )
+                        *val += shift;
+                    else if ( llvm::StringRef( key ).startswith( "memory." ) )
+                    {
+                        auto offset = val->getBitWidth() - 64;
+                        val->insertBits( val->extractBits( 64, offset ) + shift, offset );
+                    }
+                }
+            return trace;
+        }
+
+        TEST_CASE( "memoized outcomes at shifted timestamps match" )
+        {
+            circ::add_sink< circ::severity::kill >( std::cerr );
+
+            auto path = std::filesystem::path( "trace-conversion" ) / "inputs" /
+                        "push_pop.trace.txt";
+
+            trace::with_reconstructor loader;
+            auto traces = loader.parse_alien_trace( path );
+            auto circuit = std::move( loader ).reconstruct();
+
+            auto moved = shifted( traces, 0x1000 );
+            auto expected = StatelessControl().test_outcomes( circuit.get(), moved );
+
+            step_cache cache( circuit.get() );
+            StatelessControl().test_outcomes( circuit.get(), traces, &cache );
+            auto before = cache.stats();
+            auto cached = StatelessControl().test_outcomes( circuit.get(), moved, &cache );
+
+            // Shifted steps are answered from entries of the original ones.
+            CHECK( cache.stats().hits > before.hits );
+
+            std::size_t hints = 0;
+            REQUIRE( cached.size() == expected.size() );
+            for ( std::size_t i = 0; i < expected.size(); ++i )
+            {
+                CHECK( cached[ i ].status == expected[ i ].status );
+                REQUIRE( cached[ i ].memory_hints.size() == expected[ i ].memory_hints.size() );
+                for ( std::size_t j = 0; j < expected[ i ].memory_hints.size(); ++j )
+                    CHECK( cached[ i ].memory_hints[ j ].vals
+                           == expected[ i ].memory_hints[ j ].vals );
+                hints += expected[ i ].memory_hints.size();
+            }
+            CHECK( hints != 0 );
+        }
+    } // test suite: run::step_cache
+
+} // namespace circ::run::test